@@ -0,0 +1,231 @@
+// Copyright (c) 2016-2018 The Bitcoin Core developers
+// Copyright (c) 2021 The Gridcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockencodings.h"
+#include "consensus/merkle.h"
+#include "crypto/sha256.h"
+#include "crypto/siphash.h"
+#include "streams.h"
+#include "util.h"
+
+#include <unordered_map>
+
+// -----------------------------------------------------------------------------
+// Class: CBlockHeaderAndShortTxIDs
+// -----------------------------------------------------------------------------
+
+CBlockHeaderAndShortTxIDs::CBlockHeaderAndShortTxIDs(const CBlock& block)
+    : header(block.GetBlockHeader())
+    , vchBlockSig(block.vchBlockSig)
+    , nonce(GetRand(std::numeric_limits<uint64_t>::max()))
+{
+    FillShortTxIDSelector();
+
+    // The coinbase carries the claim and the coinstake spends the staker's
+    // own output. No peer has these in its memory pool:
+    //
+    const size_t prefilled = block.IsProofOfStake() ? 2 : std::min<size_t>(1, block.vtx.size());
+
+    prefilledtxn.reserve(prefilled);
+    shorttxids.reserve(block.vtx.size() - prefilled);
+
+    for (size_t i = 0; i < block.vtx.size(); ++i) {
+        if (i < prefilled) {
+            prefilledtxn.push_back(PrefilledTransaction { static_cast<uint16_t>(i), block.vtx[i] });
+        } else {
+            shorttxids.push_back(GetShortID(block.vtx[i].GetHash()));
+        }
+    }
+}
+
+void CBlockHeaderAndShortTxIDs::FillShortTxIDSelector() const
+{
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << header << nonce;
+
+    CSHA256 hasher;
+    hasher.Write((unsigned char*)&(*stream.begin()), stream.end() - stream.begin());
+
+    uint256 shorttxidhash;
+    hasher.Finalize(shorttxidhash.begin());
+
+    shorttxidk0 = shorttxidhash.GetUint64(0);
+    shorttxidk1 = shorttxidhash.GetUint64(1);
+}
+
+uint64_t CBlockHeaderAndShortTxIDs::GetShortID(const uint256& txhash) const
+{
+    static_assert(SHORTTXIDS_LENGTH == 6, "shorttxids calculation assumes 6-byte shorttxids");
+
+    return SipHashUint256(shorttxidk0, shorttxidk1, txhash) & 0xffffffffffffL;
+}
+
+// -----------------------------------------------------------------------------
+// Class: PartiallyDownloadedBlock
+// -----------------------------------------------------------------------------
+
+ReadStatus PartiallyDownloadedBlock::InitData(const CBlockHeaderAndShortTxIDs& cmpctblock)
+{
+    if (cmpctblock.header.IsNull()
+        || (cmpctblock.shorttxids.empty() && cmpctblock.prefilledtxn.empty()))
+    {
+        return READ_STATUS_INVALID;
+    }
+
+    if (cmpctblock.BlockTxCount() > MAX_BLOCK_SIZE / MIN_COMPACT_TRANSACTION_SIZE) {
+        return READ_STATUS_INVALID;
+    }
+
+    assert(header.IsNull() && txn_available.empty());
+
+    header = cmpctblock.header;
+    vchBlockSig = cmpctblock.vchBlockSig;
+    txn_available.resize(cmpctblock.BlockTxCount());
+
+    for (const auto& prefilled : cmpctblock.prefilledtxn) {
+        if (prefilled.index >= txn_available.size() || txn_available[prefilled.index]) {
+            return READ_STATUS_INVALID;
+        }
+
+        txn_available[prefilled.index] = prefilled.tx;
+    }
+
+    prefilled_count = cmpctblock.prefilledtxn.size();
+
+    // Map each short ID to the position of its transaction in the block. A
+    // short ID that appears twice prevents reconstruction from the pool:
+    //
+    std::unordered_map<uint64_t, uint16_t> shorttxids;
+    shorttxids.reserve(cmpctblock.shorttxids.size());
+
+    size_t index = 0;
+
+    for (const auto& shorttxid : cmpctblock.shorttxids) {
+        while (txn_available[index]) {
+            ++index;
+        }
+
+        if (!shorttxids.emplace(shorttxid, index).second) {
+            return READ_STATUS_FAILED;
+        }
+
+        ++index;
+    }
+
+    // Track the short IDs matched by more than one pool transaction so that
+    // we never fill a slot with the wrong transaction. The node fetches the
+    // transaction from the peer instead:
+    //
+    std::vector<bool> have_collision(txn_available.size(), false);
+
+    LOCK(pool->cs);
+
+    for (const auto& entry : pool->mapTx) {
+        const auto iter = shorttxids.find(cmpctblock.GetShortID(entry.first));
+
+        if (iter == shorttxids.end()) {
+            continue;
+        }
+
+        if (have_collision[iter->second]) {
+            continue;
+        }
+
+        if (txn_available[iter->second]) {
+            txn_available[iter->second].reset();
+            have_collision[iter->second] = true;
+            --mempool_count;
+            continue;
+        }
+
+        txn_available[iter->second] = entry.second;
+        ++mempool_count;
+
+        if (mempool_count == shorttxids.size()) {
+            break;
+        }
+    }
+
+    LogPrint(BCLog::LogFlags::NET,
+             "Initialized PartiallyDownloadedBlock for block %s using a cmpctblock of size %lu",
+             cmpctblock.header.GetHash().ToString(),
+             GetSerializeSize(cmpctblock, SER_NETWORK, PROTOCOL_VERSION));
+
+    return READ_STATUS_OK;
+}
+
+bool PartiallyDownloadedBlock::IsTxAvailable(size_t index) const
+{
+    assert(!header.IsNull());
+    assert(index < txn_available.size());
+
+    return txn_available[index].has_value();
+}
+
+std::vector<uint16_t> PartiallyDownloadedBlock::GetMissingIndexes() const
+{
+    std::vector<uint16_t> missing;
+
+    for (size_t i = 0; i < txn_available.size(); ++i) {
+        if (!txn_available[i]) {
+            missing.push_back(i);
+        }
+    }
+
+    return missing;
+}
+
+ReadStatus PartiallyDownloadedBlock::FillBlock(
+    CBlock& block,
+    const std::vector<CTransaction>& vtx_missing)
+{
+    assert(!header.IsNull());
+
+    block = CBlock(header);
+    block.vtx.reserve(txn_available.size());
+
+    size_t tx_missing_offset = 0;
+
+    for (auto& tx : txn_available) {
+        if (!tx) {
+            if (tx_missing_offset >= vtx_missing.size()) {
+                return READ_STATUS_INVALID;
+            }
+
+            block.vtx.push_back(vtx_missing[tx_missing_offset++]);
+        } else {
+            block.vtx.push_back(std::move(*tx));
+        }
+    }
+
+    block.vchBlockSig = std::move(vchBlockSig);
+
+    // Make sure the object can't be used again:
+    header.SetNull();
+    txn_available.clear();
+
+    if (vtx_missing.size() != tx_missing_offset) {
+        return READ_STATUS_INVALID;
+    }
+
+    // A short ID collision with a pool transaction produces a block with the
+    // wrong transactions. The merkle root exposes it, and the caller falls
+    // back to requesting the full block:
+    //
+    bool mutated = false;
+
+    if (BlockMerkleRoot(block, &mutated) != block.hashMerkleRoot || mutated) {
+        return READ_STATUS_FAILED;
+    }
+
+    LogPrint(BCLog::LogFlags::NET,
+             "Successfully reconstructed block %s with %lu txn prefilled, %lu txn from mempool and %lu txn requested",
+             block.GetHash(true).ToString(),
+             prefilled_count,
+             mempool_count,
+             vtx_missing.size());
+
+    return READ_STATUS_OK;
+}
@@ -0,0 +1,305 @@
+// Copyright (c) 2016-2018 The Bitcoin Core developers
+// Copyright (c) 2021 The Gridcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BLOCKENCODINGS_H
+#define BITCOIN_BLOCKENCODINGS_H
+
+#include "main.h"
+
+#include <ios>
+#include <limits>
+#include <optional>
+
+class CTxMemPool;
+
+//!
+//! \brief The network protocol version that introduced compact block relay.
+//!
+//! Nodes request a block as a compact block (MSG_CMPCT_BLOCK) from peers at
+//! or above this version when the node is not in initial block download.
+//!
+static const int COMPACT_BLOCKS_VERSION = 180327;
+
+//!
+//! \brief The minimum serialized size of a transaction. Bounds the number of
+//! transactions that a compact block message may claim a block contains.
+//!
+static const unsigned int MIN_COMPACT_TRANSACTION_SIZE = 60;
+
+//!
+//! \brief Requests the transactions at the specified indexes of a block that
+//! a node failed to reconstruct from its memory pool.
+//!
+class BlockTransactionsRequest
+{
+public:
+    uint256 blockhash;             //!< Hash of the block to fetch from.
+    std::vector<uint16_t> indexes; //!< Positions of the missing transactions.
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        READWRITE(blockhash);
+
+        uint64_t indexes_size = (uint64_t)indexes.size();
+        READWRITE(COMPACTSIZE(indexes_size));
+
+        if (ser_action.ForRead()) {
+            if (indexes_size > MAX_BLOCK_SIZE / MIN_COMPACT_TRANSACTION_SIZE) {
+                throw std::ios_base::failure("indexes overflowed the maximum block size");
+            }
+
+            indexes.resize(indexes_size);
+        }
+
+        // Each index is encoded as the difference from the previous index
+        // to keep the request small:
+        //
+        uint64_t offset = 0;
+
+        for (size_t i = 0; i < indexes.size(); ++i) {
+            uint64_t index = ser_action.ForRead() ? 0 : indexes[i] - offset;
+            READWRITE(COMPACTSIZE(index));
+
+            if (ser_action.ForRead()) {
+                index += offset;
+
+                if (index > std::numeric_limits<uint16_t>::max()) {
+                    throw std::ios_base::failure("index overflowed 16 bits");
+                }
+
+                indexes[i] = index;
+            }
+
+            offset = (uint64_t)indexes[i] + 1;
+        }
+    }
+};
+
+//!
+//! \brief Contains the transactions sent in response to a
+//! BlockTransactionsRequest in the order of the requested indexes.
+//!
+class BlockTransactions
+{
+public:
+    uint256 blockhash;             //!< Hash of the block the transactions belong to.
+    std::vector<CTransaction> txn; //!< The requested transactions.
+
+    BlockTransactions()
+    {
+    }
+
+    explicit BlockTransactions(const BlockTransactionsRequest& req)
+        : blockhash(req.blockhash)
+        , txn(req.indexes.size())
+    {
+    }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        READWRITE(blockhash);
+        READWRITE(txn);
+    }
+};
+
+//!
+//! \brief A transaction sent in full with a compact block, such as the
+//! coinbase that carries the claim and the coinstake.
+//!
+class PrefilledTransaction
+{
+public:
+    uint16_t index;  //!< Position of the transaction in the block.
+    CTransaction tx; //!< The full transaction.
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        uint64_t idx = index;
+        READWRITE(COMPACTSIZE(idx));
+
+        if (idx > std::numeric_limits<uint16_t>::max()) {
+            throw std::ios_base::failure("index overflowed 16 bits");
+        }
+
+        index = idx;
+        READWRITE(tx);
+    }
+};
+
+//!
+//! \brief Result of an attempt to reconstruct a block from a compact block.
+//!
+enum ReadStatus
+{
+    READ_STATUS_OK,
+    READ_STATUS_INVALID, //!< The peer sent invalid data. Ban-worthy.
+    READ_STATUS_FAILED,  //!< Reconstruction failed. Fall back to a full block.
+};
+
+//!
+//! \brief A block announced as its header, signature, and prefilled coinbase
+//! and coinstake followed by 6-byte short IDs of the remaining transactions.
+//!
+//! Short IDs are SipHash-2-4 digests of the transaction hashes keyed by the
+//! block header and a random nonce chosen by the sender so that collisions
+//! cannot be precomputed for every peer at once.
+//!
+class CBlockHeaderAndShortTxIDs
+{
+public:
+    static constexpr int SHORTTXIDS_LENGTH = 6;
+
+    CBlockHeader header;
+    std::vector<unsigned char> vchBlockSig;
+    std::vector<uint64_t> shorttxids;
+    std::vector<PrefilledTransaction> prefilledtxn;
+
+    //!
+    //! \brief Initialize an empty compact block for deserialization.
+    //!
+    CBlockHeaderAndShortTxIDs()
+    {
+    }
+
+    //!
+    //! \brief Encode a block as a compact block.
+    //!
+    //! \param block The block to encode. Its coinbase and, for proof-of-stake
+    //! blocks, the coinstake travel in full because peers never have them.
+    //!
+    explicit CBlockHeaderAndShortTxIDs(const CBlock& block);
+
+    //!
+    //! \brief Calculate the short ID of a transaction for this block.
+    //!
+    uint64_t GetShortID(const uint256& txhash) const;
+
+    //!
+    //! \brief Get the number of transactions in the encoded block.
+    //!
+    size_t BlockTxCount() const
+    {
+        return shorttxids.size() + prefilledtxn.size();
+    }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        READWRITE(header);
+        READWRITE(vchBlockSig);
+        READWRITE(nonce);
+
+        uint64_t shorttxids_size = (uint64_t)shorttxids.size();
+        READWRITE(COMPACTSIZE(shorttxids_size));
+
+        static_assert(SHORTTXIDS_LENGTH == 6, "serialization assumes 6-byte short IDs");
+
+        if (ser_action.ForRead()) {
+            if (shorttxids_size > MAX_BLOCK_SIZE / MIN_COMPACT_TRANSACTION_SIZE) {
+                throw std::ios_base::failure("short IDs overflowed the maximum block size");
+            }
+
+            shorttxids.resize(shorttxids_size);
+        }
+
+        for (auto& shorttxid : shorttxids) {
+            uint32_t lsb = shorttxid & 0xffffffff;
+            uint16_t msb = (shorttxid >> 32) & 0xffff;
+
+            READWRITE(lsb);
+            READWRITE(msb);
+
+            shorttxid = (uint64_t(msb) << 32) | uint64_t(lsb);
+        }
+
+        READWRITE(prefilledtxn);
+
+        if (ser_action.ForRead()) {
+            FillShortTxIDSelector();
+        }
+    }
+
+private:
+    uint64_t nonce = 0;
+    mutable uint64_t shorttxidk0 = 0;
+    mutable uint64_t shorttxidk1 = 0;
+
+    void FillShortTxIDSelector() const;
+
+    friend class PartiallyDownloadedBlock;
+};
+
+//!
+//! \brief Reconstructs a block from a compact block and the transactions in
+//! the memory pool, and tracks which transactions must be fetched.
+//!
+class PartiallyDownloadedBlock
+{
+public:
+    CBlockHeader header;
+
+    //!
+    //! \brief Initialize the reconstruction state.
+    //!
+    //! \param pool Memory pool to look up announced transactions in.
+    //!
+    explicit PartiallyDownloadedBlock(CTxMemPool* pool) : pool(pool)
+    {
+    }
+
+    //!
+    //! \brief Fill in the block's transactions from a compact block and the
+    //! memory pool.
+    //!
+    //! \param cmpctblock The compact block received from a peer.
+    //!
+    //! \return READ_STATUS_INVALID when the compact block is malformed, or
+    //! READ_STATUS_FAILED when short IDs collide and the caller should fall
+    //! back to requesting the full block.
+    //!
+    ReadStatus InitData(const CBlockHeaderAndShortTxIDs& cmpctblock);
+
+    //!
+    //! \brief Determine whether the transaction at the index is present.
+    //!
+    bool IsTxAvailable(size_t index) const;
+
+    //!
+    //! \brief Get the indexes of the transactions missing from the block.
+    //!
+    std::vector<uint16_t> GetMissingIndexes() const;
+
+    //!
+    //! \brief Assemble the block from the available transactions and the
+    //! missing transactions fetched from a peer.
+    //!
+    //! \param block      Receives the reconstructed block.
+    //! \param vtx_missing Transactions in the order of GetMissingIndexes().
+    //!
+    //! \return READ_STATUS_FAILED when the transactions do not hash to the
+    //! header's merkle root, as happens when a short ID collides.
+    //!
+    ReadStatus FillBlock(CBlock& block, const std::vector<CTransaction>& vtx_missing);
+
+private:
+    std::vector<std::optional<CTransaction>> txn_available;
+    std::vector<unsigned char> vchBlockSig;
+    size_t prefilled_count = 0;
+    size_t mempool_count = 0;
+    CTxMemPool* pool;
+};
+
+#endif // BITCOIN_BLOCKENCODINGS_H
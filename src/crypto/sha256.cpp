@@ -22,11 +22,13 @@ void Transform(uint32_t* s, const unsigned char* chunk, size_t blocks);
 namespace sha256d64_sse41
 {
 void Transform_4way(unsigned char* out, const unsigned char* in);
+void Transform_4way_single(unsigned char* out, const unsigned char* in);
 }
 
 namespace sha256d64_avx2
 {
 void Transform_8way(unsigned char* out, const unsigned char* in);
+void Transform_8way_single(unsigned char* out, const unsigned char* in);
 }
 
 namespace sha256d64_shani
@@ -456,11 +458,47 @@ void TransformD64Wrapper(unsigned char* out, const unsigned char* in)
     WriteBE32(out + 28, s[7]);
 }
 
+/** Double-SHA256 of a message that fits in one 64-byte block with its padding. */
+template<TransformType tr>
+void TransformSingleWrapper(unsigned char* out, const unsigned char* in)
+{
+    uint32_t s[8];
+    unsigned char buffer2[64] = {
+        0,    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0,    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0,    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0
+    };
+    sha256::Initialize(s);
+    tr(s, in, 1);
+    WriteBE32(buffer2 + 0, s[0]);
+    WriteBE32(buffer2 + 4, s[1]);
+    WriteBE32(buffer2 + 8, s[2]);
+    WriteBE32(buffer2 + 12, s[3]);
+    WriteBE32(buffer2 + 16, s[4]);
+    WriteBE32(buffer2 + 20, s[5]);
+    WriteBE32(buffer2 + 24, s[6]);
+    WriteBE32(buffer2 + 28, s[7]);
+    sha256::Initialize(s);
+    tr(s, buffer2, 1);
+    WriteBE32(out + 0, s[0]);
+    WriteBE32(out + 4, s[1]);
+    WriteBE32(out + 8, s[2]);
+    WriteBE32(out + 12, s[3]);
+    WriteBE32(out + 16, s[4]);
+    WriteBE32(out + 20, s[5]);
+    WriteBE32(out + 24, s[6]);
+    WriteBE32(out + 28, s[7]);
+}
+
 TransformType Transform = sha256::Transform;
 TransformD64Type TransformD64 = sha256::TransformD64;
 TransformD64Type TransformD64_2way = nullptr;
 TransformD64Type TransformD64_4way = nullptr;
 TransformD64Type TransformD64_8way = nullptr;
+TransformD64Type TransformSingle = TransformSingleWrapper<sha256::Transform>;
+TransformD64Type TransformSingle_4way = nullptr;
+TransformD64Type TransformSingle_8way = nullptr;
 
 bool SelfTest() {
     // Input state (equal to the initial SHA256 state)
@@ -544,6 +582,28 @@ bool SelfTest() {
         if (!std::equal(out, out + 256, result_d64)) return false;
     }
 
+    // Test TransformSingle against separate Transform() calls. The 64-byte
+    // messages here do not carry valid padding, but the multi-way versions
+    // must produce the same output for arbitrary blocks.
+    unsigned char result_single[256];
+    for (size_t i = 0; i < 8; ++i) {
+        TransformSingle(result_single + i * 32, data + 1 + i * 64);
+    }
+
+    // Test TransformSingle_4way, if available.
+    if (TransformSingle_4way) {
+        unsigned char out[128];
+        TransformSingle_4way(out, data + 1);
+        if (!std::equal(out, out + 128, result_single)) return false;
+    }
+
+    // Test TransformSingle_8way, if available.
+    if (TransformSingle_8way) {
+        unsigned char out[256];
+        TransformSingle_8way(out, data + 1);
+        if (!std::equal(out, out + 256, result_single)) return false;
+    }
+
     return true;
 }
 
@@ -608,6 +668,7 @@ std::string SHA256AutoDetect()
         Transform = sha256_shani::Transform;
         TransformD64 = TransformD64Wrapper<sha256_shani::Transform>;
         TransformD64_2way = sha256d64_shani::Transform_2way;
+        TransformSingle = TransformSingleWrapper<sha256_shani::Transform>;
         ret = "shani(1way,2way)";
         have_sse4 = false; // Disable SSE4/AVX2;
         have_avx2 = false;
@@ -618,10 +679,12 @@ std::string SHA256AutoDetect()
 #if defined(__x86_64__) || defined(__amd64__)
         Transform = sha256_sse4::Transform;
         TransformD64 = TransformD64Wrapper<sha256_sse4::Transform>;
+        TransformSingle = TransformSingleWrapper<sha256_sse4::Transform>;
         ret = "sse4(1way)";
 #endif
 #if defined(ENABLE_SSE41) && !defined(BUILD_BITCOIN_INTERNAL)
         TransformD64_4way = sha256d64_sse41::Transform_4way;
+        TransformSingle_4way = sha256d64_sse41::Transform_4way_single;
         ret += ",sse41(4way)";
 #endif
     }
@@ -629,6 +692,7 @@ std::string SHA256AutoDetect()
 #if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
     if (have_avx2 && have_avx && enabled_avx) {
         TransformD64_8way = sha256d64_avx2::Transform_8way;
+        TransformSingle_8way = sha256d64_avx2::Transform_8way_single;
         ret += ",avx2(8way)";
     }
 #endif
@@ -728,3 +792,29 @@ void SHA256D64(unsigned char* out, const unsigned char* in, size_t blocks)
         --blocks;
     }
 }
+
+void SHA256DSingle(unsigned char* out, const unsigned char* in, size_t blocks)
+{
+    if (TransformSingle_8way) {
+        while (blocks >= 8) {
+            TransformSingle_8way(out, in);
+            out += 256;
+            in += 512;
+            blocks -= 8;
+        }
+    }
+    if (TransformSingle_4way) {
+        while (blocks >= 4) {
+            TransformSingle_4way(out, in);
+            out += 128;
+            in += 256;
+            blocks -= 4;
+        }
+    }
+    while (blocks) {
+        TransformSingle(out, in);
+        out += 32;
+        in += 64;
+        --blocks;
+    }
+}
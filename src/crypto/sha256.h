@@ -38,4 +38,13 @@ std::string SHA256AutoDetect();
  */
 void SHA256D64(unsigned char* output, const unsigned char* input, size_t blocks);
 
+/** Compute multiple double-SHA256's of messages of at most 55 bytes.
+ *  The caller appends the SHA256 padding so that each message fills exactly
+ *  one 64-byte block.
+ *  output:  pointer to a blocks*32 byte output buffer
+ *  input:   pointer to a blocks*64 byte input buffer of padded messages
+ *  blocks:  the number of hashes to compute.
+ */
+void SHA256DSingle(unsigned char* output, const unsigned char* input, size_t blocks);
+
 #endif // BITCOIN_CRYPTO_SHA256_H
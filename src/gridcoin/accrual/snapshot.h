@@ -6,6 +6,7 @@
 
 #include "amount.h"
 #include "arith_uint256.h"
+#include "crypto/common.h"
 #include "fs.h"
 #include "gridcoin/account.h"
 #include "gridcoin/accrual/computer.h"
@@ -13,10 +14,14 @@
 #include "gridcoin/cpid.h"
 #include "gridcoin/superblock.h"
 #include "gridcoin/support/filehash.h"
+#include "hash.h"
 #include "serialize.h"
 #include "streams.h"
 #include "tinyformat.h"
 
+#include <algorithm>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <memory>
 #include <unordered_map>
 
 class CBlockIndex;
@@ -420,6 +425,17 @@ fs::path SnapshotPath(const uint64_t height)
     return SnapshotDirectory() / strprintf("%" PRIu64 ".dat", height);
 }
 
+//!
+//! \brief Get the path to the research account checkpoint file.
+//!
+//! The checkpoint lives in the snapshot directory so that erasing the accrual
+//! snapshots also discards it.
+//!
+fs::path TallyCheckpointPath()
+{
+    return SnapshotDirectory() / "tally.dat";
+}
+
 //!
 //! \brief Contains a snapshot of pending research reward accrual for CPIDs in
 //! the network at a point in time.
@@ -429,25 +445,49 @@ fs::path SnapshotPath(const uint64_t height)
 //! reading superblocks from disk to recalculate accrual upon start-up and when
 //! reorganizing the chain.
 //!
+//! Version 1: A header with the version and height followed by CPID/accrual
+//! pairs in no particular order until the end of the file.
+//!
+//! Version 2: A header with the version, height, and number of records, then
+//! fixed-width CPID/accrual records sorted by CPID, and a trailing SHA256 hash
+//! of the preceding bytes. Readers map the file into memory and search the
+//! records in place instead of building a hash map.
+//!
 class AccrualSnapshot
 {
 public:
-    using AccrualMap = std::unordered_map<Cpid, int64_t>;
-
     //!
     //! \brief Version number of the current format for a serialized snapshot.
     //!
-    static constexpr uint32_t CURRENT_VERSION = 1;
+    static constexpr uint32_t CURRENT_VERSION = 2;
 
-    uint32_t m_version; //!< Version of the serialized snapshot format.
-    uint64_t m_height;  //!< Block height of the snapshot.
+    //!
+    //! \brief Byte length of the version 2 header: the version, height, and
+    //! number of records.
+    //!
+    static constexpr size_t HEADER_SIZE = 4 + 8 + 8;
 
     //!
-    //! \brief Maps CPIDs to rewards accrued at the time of the snapshot.
+    //! \brief Byte length of a record: the CPID and an 8-byte accrual value.
     //!
-    //! Accrual values stored in units of of 1/100000000 GRC.
+    static constexpr size_t RECORD_SIZE = 16 + 8;
+
     //!
-    AccrualMap m_records;
+    //! \brief Byte length of the hash at the end of a version 2 snapshot.
+    //!
+    static constexpr size_t TRAILER_SIZE = 32;
+
+    //!
+    //! \brief A CPID to accrual mapping in the snapshot.
+    //!
+    struct Record
+    {
+        Cpid m_cpid;       //!< Identifies the owner of the accrual.
+        int64_t m_accrual; //!< Accrual in units of 1/100000000 GRC.
+    };
+
+    uint32_t m_version; //!< Version of the serialized snapshot format.
+    uint64_t m_height;  //!< Block height of the snapshot.
 
     //!
     //! \brief Initialize an empty accrual snapshot.
@@ -455,29 +495,52 @@ public:
     AccrualSnapshot()
         : m_version(CURRENT_VERSION)
         , m_height(0)
+        , m_size(0)
     {
     }
 
     //!
-    //! \brief Initialize an accrual snapshot by deserializing it from the
-    //! provided file.
+    //! \brief Initialize an accrual snapshot over records stored in the disk
+    //! format.
+    //!
+    //! \param version Version of the serialized snapshot format.
+    //! \param height  Block height of the snapshot.
+    //! \param records Points to the records sorted by CPID. Shares ownership
+    //! of the memory that contains the records.
+    //! \param size    Number of records.
+    //!
+    AccrualSnapshot(
+        const uint32_t version,
+        const uint64_t height,
+        std::shared_ptr<const unsigned char> records,
+        const size_t size)
+        : m_version(version)
+        , m_height(height)
+        , m_records(std::move(records))
+        , m_size(size)
+    {
+    }
+
+    //!
+    //! \brief Initialize an accrual snapshot by deserializing a version 1
+    //! snapshot from the provided file.
     //!
     //! \param s The input stream.
     //!
     AccrualSnapshot(deserialize_type, CAutoHasherFile& file)
+        : m_size(0)
     {
-        m_records.clear();
+        std::vector<Record> records;
 
         file >> m_version;
         file >> m_height;
 
         while (true) {
-            Cpid cpid;
-            int64_t accrual;
+            Record record;
 
             try {
-                file >> cpid;
-                file >> accrual;
+                file >> record.m_cpid;
+                file >> record.m_accrual;
             } catch (const std::ios_base::failure& e) {
                 if (feof(file.Get())) {
                     break;
@@ -487,9 +550,59 @@ public:
             }
 
             if (!(file.GetType() & SER_GETHASH)) {
-                m_records.emplace(cpid, accrual);
+                records.emplace_back(record);
             }
         }
+
+        // Version 1 snapshots do not sort the records. Convert these to the
+        // version 2 layout so that lookups work the same way. The first of a
+        // duplicate CPID wins as it did when the records filled a hash map:
+        //
+        std::stable_sort(records.begin(), records.end(), [](const Record& a, const Record& b) {
+            return a.m_cpid < b.m_cpid;
+        });
+
+        records.erase(
+            std::unique(records.begin(), records.end(), [](const Record& a, const Record& b) {
+                return a.m_cpid == b.m_cpid;
+            }),
+            records.end());
+
+        auto buffer = std::make_shared<std::vector<unsigned char>>(records.size() * RECORD_SIZE);
+        unsigned char* out = buffer->data();
+
+        for (const auto& record : records) {
+            out = std::copy(record.m_cpid.Raw().begin(), record.m_cpid.Raw().end(), out);
+            WriteLE64(out, record.m_accrual);
+            out += 8;
+        }
+
+        m_records = std::shared_ptr<const unsigned char>(buffer, buffer->data());
+        m_size = records.size();
+    }
+
+    //!
+    //! \brief Get the number of records in the snapshot.
+    //!
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    //!
+    //! \brief Get the record at the specified position in CPID order.
+    //!
+    //! \param index Position of the record less than size().
+    //!
+    Record operator[](const size_t index) const
+    {
+        const unsigned char* const data = m_records.get() + index * RECORD_SIZE;
+
+        Record record;
+        std::copy(data, data + 16, record.m_cpid.Raw().begin());
+        record.m_accrual = ReadLE64(data + 16);
+
+        return record;
     }
 
     //!
@@ -503,14 +616,39 @@ public:
     //!
     CAmount GetAccrual(const Cpid cpid) const
     {
-        auto iter = m_records.find(cpid);
+        const unsigned char* const key = cpid.Raw().data();
+        size_t low = 0;
+        size_t high = m_size;
 
-        if (iter == m_records.end()) {
-            return 0;
+        while (low < high) {
+            const size_t mid = low + (high - low) / 2;
+            const unsigned char* const data = m_records.get() + mid * RECORD_SIZE;
+            const int cmp = memcmp(data, key, 16);
+
+            if (cmp == 0) {
+                return ReadLE64(data + 16);
+            }
+
+            if (cmp < 0) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
         }
 
-        return iter->second;
+        return 0;
     }
+
+private:
+    //!
+    //! \brief Records in the version 2 disk layout sorted by CPID.
+    //!
+    //! Points into a memory-mapped snapshot file or into a buffer converted
+    //! from a version 1 snapshot.
+    //!
+    std::shared_ptr<const unsigned char> m_records;
+
+    size_t m_size; //!< Number of records.
 }; // AccrualSnapshot
 
 constexpr uint32_t AccrualSnapshot::CURRENT_VERSION; // for clang
@@ -600,15 +738,23 @@ public:
     //!
     //! \brief Get the hash of the snapshot after reading or writing the file.
     //!
+    //! For version 2 snapshots, the hash covers the bytes before the trailer
+    //! and equals the trailer.
+    //!
     //! \return SHA256 hash of the snapshot file.
     //!
     uint256 GetHash()
     {
-        return m_file.GetHash();
+        if (m_hash.IsNull()) {
+            m_hash = m_file.GetHash();
+        }
+
+        return m_hash;
     }
 
 protected:
     CAutoHasherFile m_file; //!< Abstracts snapshot file operations.
+    uint256 m_hash;         //!< Hash of the snapshot once finished.
 }; // AccrualSnapshotFile
 
 //!
@@ -625,6 +771,7 @@ public:
     //!
     AccrualSnapshotReader(const fs::path& snapshot_path, const int ser_type)
         : AccrualSnapshotFile(fsbridge::fopen(snapshot_path, "rb"), ser_type)
+        , m_path(snapshot_path)
     {
     }
 
@@ -664,13 +811,95 @@ public:
     }
 
     //!
-    //! \brief Deserialize the snapshot file from disk.
+    //! \brief Load the snapshot file from disk.
     //!
     //! \return The contents of the snapshot file.
     //!
+    //! \throws std::ios_base::failure If the file failed to open, is truncated,
+    //! has an unknown format version, or does not match its trailing hash.
+    //!
     AccrualSnapshot Read()
     {
-        return AccrualSnapshot(deserialize, m_file);
+        if (m_file.IsNull()) {
+            throw std::ios_base::failure("failed to open accrual snapshot");
+        }
+
+        switch (PeekVersion()) {
+            case 1:
+                return AccrualSnapshot(deserialize, m_file);
+            case 2:
+                return ReadMapped();
+            case 0:
+                throw std::ios_base::failure("accrual snapshot truncated");
+            default:
+                throw std::ios_base::failure("unknown accrual snapshot version");
+        }
+    }
+
+private:
+    const fs::path m_path; //!< Path to the snapshot file to map.
+
+    //!
+    //! \brief Read the snapshot format version from the start of the file and
+    //! rewind it.
+    //!
+    //! \return Zero if the file is too short to contain a version.
+    //!
+    uint32_t PeekVersion()
+    {
+        FILE* const file = m_file.Get();
+        unsigned char bytes[4];
+
+        const bool ok = fread(bytes, 1, sizeof(bytes), file) == sizeof(bytes);
+
+        if (fseek(file, 0, SEEK_SET) != 0) {
+            throw std::ios_base::failure("failed to rewind accrual snapshot");
+        }
+
+        return ok ? ReadLE32(bytes) : 0;
+    }
+
+    //!
+    //! \brief Map a version 2 snapshot file into memory and verify it.
+    //!
+    //! \return A snapshot that references the records in the mapped file.
+    //!
+    AccrualSnapshot ReadMapped()
+    {
+        const auto mapping = std::make_shared<boost::iostreams::mapped_file_source>(m_path.string());
+        const unsigned char* const data = reinterpret_cast<const unsigned char*>(mapping->data());
+        const size_t size = mapping->size();
+
+        constexpr size_t overhead = AccrualSnapshot::HEADER_SIZE + AccrualSnapshot::TRAILER_SIZE;
+
+        if (size < overhead) {
+            throw std::ios_base::failure("accrual snapshot truncated");
+        }
+
+        const uint32_t version = ReadLE32(data);
+        const uint64_t height = ReadLE64(data + 4);
+        const uint64_t count = ReadLE64(data + 12);
+
+        if (count != (size - overhead) / AccrualSnapshot::RECORD_SIZE
+            || (size - overhead) % AccrualSnapshot::RECORD_SIZE != 0)
+        {
+            throw std::ios_base::failure("accrual snapshot record count mismatch");
+        }
+
+        const unsigned char* const trailer = data + size - AccrualSnapshot::TRAILER_SIZE;
+        const uint256 hash = ::Hash(data, trailer);
+
+        if (memcmp(hash.begin(), trailer, AccrualSnapshot::TRAILER_SIZE) != 0) {
+            throw std::ios_base::failure("accrual snapshot hash mismatch");
+        }
+
+        m_hash = hash;
+
+        return AccrualSnapshot(
+            version,
+            height,
+            std::shared_ptr<const unsigned char>(mapping, data + AccrualSnapshot::HEADER_SIZE),
+            count);
     }
 }; // AccrualSnapshotReader
 
@@ -694,16 +923,20 @@ public:
     //! \brief Write the header of an accrual snapshot.
     //!
     //! \param height Block height of the snapshot. Usually a superblock.
+    //! \param count  Number of records that follow.
     //!
-    void WriteHeader(const uint64_t height)
+    void WriteHeader(const uint64_t height, const uint64_t count)
     {
         m_file << AccrualSnapshot::CURRENT_VERSION;
         m_file << height;
+        m_file << count;
     }
 
     //!
     //! \brief Write a CPID to accrual mapping to the snapshot file.
     //!
+    //! Records must follow in CPID order.
+    //!
     //! \param cpid    Identifies the owner of the accrual.
     //! \param accrual Accrued research rewards in units of 1/100000000 GRC.
     //!
@@ -711,6 +944,17 @@ public:
     {
         m_file << cpid << accrual;
     }
+
+    //!
+    //! \brief Write the hash of the header and records to finish the file.
+    //!
+    void WriteTrailer()
+    {
+        const uint256 hash = GetHash();
+
+        // Bypass the hasher so that the hash covers only the preceding data:
+        static_cast<CAutoFile&>(m_file) << hash;
+    }
 }; // AccrualSnapshotWriter
 
 //!
@@ -1319,7 +1563,9 @@ public:
         for (const auto& file : fs::directory_iterator(SnapshotDirectory())) {
             const fs::path& file_path = file.path();
 
-            if (file_path.filename() == "registry.dat") {
+            if (file_path.filename() == "registry.dat"
+                || file_path.filename() == TallyCheckpointPath().filename())
+            {
                 continue;
             }
 
@@ -1382,16 +1628,27 @@ public:
             return error("%s: failed to open %" PRIu64, __func__, height);
         }
 
+        std::vector<AccrualSnapshot::Record> records;
+        records.reserve(accounts.size());
+
+        for (const auto& account_pair : accounts) {
+            if (account_pair.second.m_accrual > 0) {
+                records.push_back({ account_pair.first, account_pair.second.m_accrual });
+            }
+        }
+
+        std::sort(records.begin(), records.end(), [](const auto& a, const auto& b) {
+            return a.m_cpid < b.m_cpid;
+        });
+
         try {
-            writer.WriteHeader(height);
+            writer.WriteHeader(height, records.size());
 
-            for (const auto& account_pair : accounts) {
-                if (account_pair.second.m_accrual > 0) {
-                    writer.WriteRecord(
-                        account_pair.first, // CPID
-                        account_pair.second.m_accrual);
-                }
+            for (const auto& record : records) {
+                writer.WriteRecord(record.m_cpid, record.m_accrual);
             }
+
+            writer.WriteTrailer();
         } catch (const std::exception& e) {
             return error("%s: %s", __func__, e.what());
         }
@@ -1456,9 +1713,11 @@ public:
         // Apply snapshot accrual for any CPIDs with no accounting record as
         // of the last superblock:
         //
-        for (const auto& cpid_pair : snapshot.m_records) {
-            if (accounts.find(cpid_pair.first) == accounts.end()) {
-                accounts[cpid_pair.first].m_accrual = cpid_pair.second;
+        for (size_t i = 0; i < snapshot.size(); ++i) {
+            const AccrualSnapshot::Record record = snapshot[i];
+
+            if (accounts.find(record.m_cpid) == accounts.end()) {
+                accounts[record.m_cpid].m_accrual = record.m_accrual;
             }
         }
 
@@ -0,0 +1,305 @@
+// Copyright (c) 2014-2021 The Gridcoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include "gridcoin/scraper/scraper_net.h"
+#include "gridcoin/superblock.h"
+#include "gridcoin/support/combination_search.h"
+#include "uint256.h"
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace GRC {
+//!
+//! \brief Maps candidate project part hashes to a set of scrapers.
+//!
+//! Each set must hold at least the minimum number of scraper IDs for a
+//! supermajority for a project part to be considered for convergence.
+//!
+typedef std::map<uint256, std::set<ScraperID>> CandidatePartHashMap;
+
+//!
+//! \brief Represents a locally-available manifest project part resolved
+//! from a hint in a superblock.
+//!
+struct ResolvedPart
+{
+    uint256 m_part_hash;            //!< Hash of the resolved part.
+    uint256 m_source_manifest_hash; //!< Manifest that contains this part.
+    int64_t m_source_manifest_time; //!< For selecting the beacon list.
+
+    //!
+    //! \brief Project statistics loaded from the part once by the
+    //! \c ProjectCombiner and shared by every combination that uses it.
+    //!
+    std::shared_ptr<const ScraperStats> m_stats;
+
+    ResolvedPart(
+        uint256 part_hash,
+        uint256 source_manifest_hash,
+        int64_t source_manifest_time)
+        : m_part_hash(part_hash)
+        , m_source_manifest_hash(source_manifest_hash)
+        , m_source_manifest_time(source_manifest_time)
+    {
+    }
+};
+
+//!
+//! \brief Maintains the context of a whitelisted project for validating
+//! fallback-to-project convergence scenarios.
+//!
+struct ResolvedProject
+{
+    //!
+    //! \brief The manifest part hashes procured from the convergence hints
+    //! in the superblock that may correspond to the parts of this project.
+    //!
+    //! The \c ProjectResolver will attempt to match these hashes to a part
+    //! contained in a manifest for each scraper to find a supermajority.
+    //!
+    //! Each set must hold at least the minimum number of scraper IDs for a
+    //! supermajority for each project or the superblock validation fails.
+    //!
+    CandidatePartHashMap m_candidate_hashes;
+
+    //!
+    //! \brief The manifest part hashes found in a manifest published by a
+    //! scraper used to retrieve the part for the project to construct the
+    //! convergence for comparison to the superblock.
+    //!
+    //! After successfully matching each of the convergence hints in the
+    //! superblock to a manifest project, the \c ProjectCombiner selects
+    //! a combination of the resolved parts from each \c ResolvedProject
+    //! to construct convergences until one matches the superblock.
+    //!
+    std::vector<ResolvedPart> m_resolved_parts;
+
+    //!
+    //! \brief Initialize a new project context object.
+    //!
+    ResolvedProject()
+    {
+    }
+
+    //!
+    //! \brief Initialize a new project context object with the provided
+    //! manifest part hashes.
+    //!
+    //! \param candidate hashes The manifest part hashes procured from the
+    //! convergence hints in the superblock.
+    //!
+    ResolvedProject(CandidatePartHashMap candidate_hashes)
+        : m_candidate_hashes(std::move(candidate_hashes))
+    {
+    }
+
+    //!
+    //! \brief Determine whether the supplied manifest part matches a part
+    //! for the convergence of this project.
+    //!
+    //! \param part_hash The hash of a project part from a manifest.
+    //!
+    //! \return \c true if the part hash matches a part annotated for this
+    //! project by a hint in the validated superblock.
+    //!
+    bool Expects(const uint256& part_hash) const
+    {
+        return m_candidate_hashes.count(part_hash) > 0;
+    }
+
+    //!
+    //! \brief Associate a scraper for the specified part.
+    //!
+    //! \param part_hash     Hash of the project part to tally.
+    //! \param scraper_id    The scraper that published the specified part.
+    //! \param supermajority Number of scrapers that must agree on a part.
+    //!
+    //! \return \c true if the part is associated with a supermajority of
+    //! scrapers.
+    //!
+    bool Tally(const uint256& part_hash, ScraperID scraper_id, size_t supermajority)
+    {
+        auto& scrapers = m_candidate_hashes.at(part_hash);
+
+        scrapers.emplace(std::move(scraper_id));
+
+        return scrapers.size() >= supermajority;
+    }
+
+    //!
+    //! \brief Commit the part hash to this project and record the timestamp
+    //! of the manifest.
+    //!
+    //! \param part Hashes of the candidate part and source manifest.
+    //!
+    void LinkPart(ResolvedPart part)
+    {
+        m_candidate_hashes.erase(part.m_part_hash);
+
+        m_resolved_parts.emplace_back(part);
+    }
+};
+
+//!
+//! \brief Constructs by-project convergences from the supplied set of the
+//! project parts resolved from the superblock.
+//!
+//! Nodes validate superblocks in by-project fallback convergence cases by
+//! matching manifest project parts to the convergence hints embedded in a
+//! superblock project section. These hints are truncated SHA256 hashes so
+//! a hint can qualify more than one manifest part for consideration while
+//! reconstructing a convergence for validation.
+//!
+//! This class searches each combination of the parts it is initialized
+//! with for a convergence that produces the hash of the superblock. Since
+//! the superblock contains the statistics of each project, a part that
+//! produces different project statistics cannot belong to the matching
+//! convergence. The combiner loads the statistics of each part only once
+//! and prunes these parts before it hashes any combinations.
+//!
+//! We have built here a catapult that fires a huge boulder to kill a tiny
+//! bird--the chance of a project part hash collision resolved by the hint
+//! in the superblock is incredibly small, but this provision prevents the
+//! validation of a superblock from failing if a collision ever occurs.
+//!
+class ProjectCombiner
+{
+public:
+    //!
+    //! \brief Initialize a project combiner with the provided collection
+    //! of resolved projects.
+    //!
+    //! \param projects Contains matching manifest parts hashes for each
+    //! project hinted in the superblock.
+    //!
+    ProjectCombiner(std::map<std::string, ResolvedProject> projects)
+        : m_projects(std::move(projects))
+    {
+    }
+
+    //!
+    //! \brief Initialize a project combiner that produces no results.
+    //!
+    ProjectCombiner()
+    {
+    }
+
+    //!
+    //! \brief Get the total number of possible project part combinations
+    //! that the object can create convergences from.
+    //!
+    //! \return Product of the number of parts resolved for each project.
+    //!
+    size_t TotalCombinations() const;
+
+    //!
+    //! \brief Load the statistics of each resolved part and discard the
+    //! parts with project statistics that differ from the superblock.
+    //!
+    //! \param superblock The superblock under validation.
+    //!
+    void Prune(const Superblock& superblock);
+
+    //!
+    //! \brief Search the combinations of the resolved parts for one that
+    //! produces the specified superblock hash.
+    //!
+    //! Call Prune() first to load the statistics of each part.
+    //!
+    //! \param quorum_hash Hash of the superblock under validation.
+    //!
+    //! \return \c true if a combination of the parts matches the hash.
+    //!
+    bool FindMatch(const QuorumHash& quorum_hash) const;
+
+private:
+    //!
+    //! \brief The collection of manifest project parts grouped by project
+    //! to create convergence combinations from.
+    //!
+    std::map<std::string, ResolvedProject> m_projects;
+
+    //!
+    //! \brief Generates a superblock hash from the contained convergence of
+    //! manifest parts.
+    //!
+    class ConvergenceCandidate;
+
+    //!
+    //! \brief Locally-available beacon parts of a manifest.
+    //!
+    struct BeaconParts
+    {
+        CSplitBlob::CPart* m_beacon_list = nullptr;      //!< Always first.
+        CSplitBlob::CPart* m_verified_beacons = nullptr; //!< Optional.
+    };
+
+    //!
+    //! \brief Create a search over the combinations of resolved parts in
+    //! the order of the projects.
+    //!
+    CombinationSearch Search() const;
+
+    //!
+    //! \brief Calculate a superblock hash from the memoized statistics of
+    //! the selected parts.
+    //!
+    //! \param selection Index of the part selected for each project.
+    //!
+    //! \return A hash that matches the hash of a superblock generated from
+    //! the convergence of the selected parts.
+    //!
+    QuorumHash ComputeQuorumHash(const std::vector<size_t>& selection) const;
+
+    //!
+    //! \brief Generate the convergence of the selected parts.
+    //!
+    //! \param selection Index of the part selected for each project.
+    //!
+    //! \return A convergence to generate a superblock hash from.
+    //!
+    ConvergenceCandidate BuildConvergence(const std::vector<size_t>& selection) const;
+
+    //!
+    //! \brief Determine whether the project statistics loaded from a part
+    //! match the statistics of the project in the superblock.
+    //!
+    //! \param stats        Statistics loaded from a project part.
+    //! \param project_name Name of the project that the part belongs to.
+    //! \param expected     Project statistics from the superblock.
+    //!
+    //! \return \c true if the part's statistics round to the same values
+    //! that the superblock contains for the project.
+    //!
+    static bool MatchesProjectStats(
+        const ScraperStats& stats,
+        const std::string& project_name,
+        const Superblock::ProjectStats& expected);
+
+    //!
+    //! \brief Fetch the project part data for the specified part hash.
+    //!
+    //! \param part_hash Identifies the project part to fetch.
+    //!
+    //! \return Serialized binary data of the part to add to a convergence.
+    //!
+    static CSplitBlob::CPart* GetResolvedPartPtr(const uint256& part_hash);
+
+    //!
+    //! \brief Find the beacon list and verified beacons parts in the
+    //! specified manifest.
+    //!
+    //! \param manifest_hash Identifies the manifest to fetch the parts from.
+    //!
+    //! \return The parts found in the manifest.
+    //!
+    static BeaconParts FindBeaconParts(const uint256& manifest_hash);
+}; // ProjectCombiner
+} // namespace GRC
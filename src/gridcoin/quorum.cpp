@@ -6,9 +6,11 @@
 #include "main.h"
 #include "gridcoin/claim.h"
 #include "gridcoin/magnitude.h"
+#include "gridcoin/project_combiner.h"
 #include "gridcoin/quorum.h"
 #include "gridcoin/scraper/scraper_net.h"
 #include "gridcoin/superblock.h"
+#include "util/parallel.h"
 #include "util/reverse_iterator.h"
 
 #include <openssl/md5.h>
@@ -20,6 +22,8 @@ using namespace GRC;
 ScraperStatsAndVerifiedBeacons  GetScraperStatsByConvergedManifest(const ConvergedManifest& StructConvergedManifest);
 ScraperStatsAndVerifiedBeacons  GetScraperStatsFromSingleManifest(CScraperManifest_shared_ptr& manifest);
 unsigned int NumScrapersForSupermajority(unsigned int nScraperCount);
+bool LoadProjectObjectToStatsByCPID(const std::string& project, const CSerializeData& ProjectData, const double& projectmag, ScraperStats& mScraperStats);
+bool ProcessNetworkWideFromProjectStats(ScraperStats& mScraperStats);
 mmCSManifestsBinnedByScraper ScraperCullAndBinCScraperManifests();
 Superblock ScraperGetSuperblockContract(
     bool bStoreConvergedStats = false,
@@ -28,6 +32,7 @@ Superblock ScraperGetSuperblockContract(
 
 extern CCriticalSection cs_ConvergedScraperStatsCache;
 extern ConvergedScraperStats ConvergedScraperStatsCache;
+extern double NETWORK_MAGNITUDE;
 
 namespace {
 //!
@@ -172,6 +177,10 @@ public:
     //!
     void Reload(const CBlockIndex* pindexLast)
     {
+        if (m_history_loaded) {
+            ReloadHistory(pindexLast);
+        }
+
         // Version 11+ blocks no longer rely on the tally trigger heights. We
         // just find and load the most recent superblock:
         //
@@ -227,6 +236,90 @@ public:
             pindexLast = pindexLast->pprev;
         }
     }
+    //!
+    //! \brief Record a superblock connected to the main chain in the ordered
+    //! history of superblocks.
+    //!
+    //! \param pindex Block index entry of the block that contains the
+    //! superblock.
+    //!
+    void AddToHistory(const CBlockIndex* const pindex)
+    {
+        // Build the history on demand. Until then, nothing looks it up:
+        //
+        if (!m_history_loaded) {
+            return;
+        }
+
+        while (!m_history.empty() && m_history.back()->nHeight >= pindex->nHeight) {
+            PopHistory();
+        }
+
+        PushHistory(pindex);
+    }
+
+    //!
+    //! \brief Remove a superblock disconnected from the main chain from the
+    //! ordered history of superblocks.
+    //!
+    //! \param pindex Block index entry of the block that contains the
+    //! superblock.
+    //!
+    void RemoveFromHistory(const CBlockIndex* const pindex)
+    {
+        if (!m_history.empty() && m_history.back() == pindex) {
+            PopHistory();
+        }
+    }
+
+    //!
+    //! \brief Find the last superblock in the main chain with a timestamp at
+    //! or before the specified time.
+    //!
+    //! \param time Timestamp to find the superblock for.
+    //!
+    //! \return Block index entry of the block that contains the superblock, or
+    //! \c nullptr when no superblock in the main chain is that old.
+    //!
+    const CBlockIndex* FindByTime(const int64_t time)
+    {
+        if (!m_history_loaded) {
+            if (!pindexBest) {
+                return nullptr;
+            }
+
+            ReloadHistory(pindexBest);
+        }
+
+        // Superblocks follow each other by at least the superblock spacing,
+        // so their timestamps normally increase with height. Fall back to a
+        // linear search if the chain ever contains an out-of-order pair:
+        //
+        if (m_history_inversions > 0) {
+            for (auto iter = m_history.rbegin(); iter != m_history.rend(); ++iter) {
+                if ((*iter)->GetBlockTime() <= time) {
+                    return *iter;
+                }
+            }
+
+            return nullptr;
+        }
+
+        const auto iter = std::upper_bound(
+            m_history.begin(),
+            m_history.end(),
+            time,
+            [](const int64_t time, const CBlockIndex* const pindex) {
+                return time < pindex->GetBlockTime();
+            });
+
+        if (iter == m_history.begin()) {
+            return nullptr;
+        }
+
+        return *std::prev(iter);
+    }
+
 private:
     //!
     //! \brief A set of recently-added superblocks not yet activated by the
@@ -240,6 +333,90 @@ private:
     //! TODO: refactor this for superblock windows.
     //!
     std::deque<SuperblockPtr> m_cache;
+
+    //!
+    //! \brief Block index entries of every superblock in the main chain in
+    //! order of height.
+    //!
+    std::vector<const CBlockIndex*> m_history;
+
+    //!
+    //! \brief Number of adjacent superblocks in the history with timestamps
+    //! that do not increase. Binary search by time requires zero.
+    //!
+    size_t m_history_inversions = 0;
+
+    //!
+    //! \brief Whether the history reflects the main chain. The index scans
+    //! the chain for the history when first needed.
+    //!
+    bool m_history_loaded = false;
+
+    //!
+    //! \brief Append a superblock to the end of the history.
+    //!
+    void PushHistory(const CBlockIndex* const pindex)
+    {
+        if (!m_history.empty() && m_history.back()->nTime >= pindex->nTime) {
+            ++m_history_inversions;
+        }
+
+        m_history.push_back(pindex);
+    }
+
+    //!
+    //! \brief Remove the superblock at the end of the history.
+    //!
+    void PopHistory()
+    {
+        const size_t size = m_history.size();
+
+        if (size >= 2 && m_history[size - 2]->nTime >= m_history[size - 1]->nTime) {
+            --m_history_inversions;
+        }
+
+        m_history.pop_back();
+    }
+
+    //!
+    //! \brief Bring the history up to date with a new chain tip.
+    //!
+    //! Scans backward from the tip only until it reaches a superblock that
+    //! the history already contains, so reloading after a reorganization or
+    //! a disconnected superblock costs no more than the blocks that changed.
+    //!
+    //! \param pindexLast The block to begin scanning backward from.
+    //!
+    void ReloadHistory(const CBlockIndex* const pindexLast)
+    {
+        std::vector<const CBlockIndex*> found;
+        const CBlockIndex* pindex = pindexLast;
+
+        for (; pindex; pindex = pindex->pprev) {
+            while (!m_history.empty() && m_history.back()->nHeight > pindex->nHeight) {
+                PopHistory();
+            }
+
+            if (!m_history.empty() && m_history.back() == pindex) {
+                break;
+            }
+
+            if (pindex->IsSuperblock()) {
+                found.push_back(pindex);
+            }
+        }
+
+        if (!pindex) {
+            m_history.clear();
+            m_history_inversions = 0;
+        }
+
+        for (auto iter = found.rbegin(); iter != found.rend(); ++iter) {
+            PushHistory(*iter);
+        }
+
+        m_history_loaded = true;
+    }
 }; // SuperblockIndex
 
 //!
@@ -653,421 +830,6 @@ public:
 
 private: // SuperblockValidator classes
 
-    //!
-    //! \brief Maps candidate project part hashes to a set of scrapers.
-    //!
-    //! Each set must hold at least the minimum number of scraper IDs for a
-    //! supermajority for a project part to be considered for convergence.
-    //!
-    typedef std::map<uint256, std::set<ScraperID>> CandidatePartHashMap;
-
-    //!
-    //! \brief Represents a locally-available manifest project part resolved
-    //! from a hint in a superblock.
-    //!
-    struct ResolvedPart
-    {
-        uint256 m_part_hash;            //!< Hash of the resolved part.
-        uint256 m_source_manifest_hash; //!< Manifest that contains this part.
-        int64_t m_source_manifest_time; //!< For selecting the beacon list.
-
-        ResolvedPart(
-            uint256 part_hash,
-            uint256 source_manifest_hash,
-            int64_t source_manifest_time)
-            : m_part_hash(part_hash)
-            , m_source_manifest_hash(source_manifest_hash)
-            , m_source_manifest_time(source_manifest_time)
-        {
-        }
-    };
-
-    //!
-    //! \brief Maintains the context of a whitelisted project for validating
-    //! fallback-to-project convergence scenarios.
-    //!
-    struct ResolvedProject
-    {
-        //!
-        //! \brief The manifest part hashes procured from the convergence hints
-        //! in the superblock that may correspond to the parts of this project.
-        //!
-        //! The \c ProjectResolver will attempt to match these hashes to a part
-        //! contained in a manifest for each scraper to find a supermajority.
-        //!
-        //! Each set must hold at least the minimum number of scraper IDs for a
-        //! supermajority for each project or the superblock validation fails.
-        //!
-        CandidatePartHashMap m_candidate_hashes;
-
-        //!
-        //! \brief The manifest part hashes found in a manifest published by a
-        //! scraper used to retrieve the part for the project to construct the
-        //! convergence for comparison to the superblock.
-        //!
-        //! After successfully matching each of the convergence hints in the
-        //! superblock to a manifest project, the \c ProjectCombiner selects
-        //! a combination of the resolved parts from each \c ResolvedProject
-        //! to construct convergences until one matches the superblock.
-        //!
-        std::vector<ResolvedPart> m_resolved_parts;
-
-        //!
-        //! \brief Divisor set by the \c ProjectCombiner for iteraton over each
-        //! convergence combination.
-        //!
-        size_t m_combiner_mask;
-
-        //!
-        //! \brief Initialize a new project context object.
-        //!
-        ResolvedProject() : m_combiner_mask(0)
-        {
-        }
-
-        //!
-        //! \brief Initialize a new project context object with the provided
-        //! manifest part hashes.
-        //!
-        //! \param candidate hashes The manifest part hashes procured from the
-        //! convergence hints in the superblock.
-        //!
-        ResolvedProject(CandidatePartHashMap candidate_hashes)
-            : m_candidate_hashes(std::move(candidate_hashes))
-            , m_combiner_mask(0)
-        {
-        }
-
-        //!
-        //! \brief Determine whether the supplied manifest part matches a part
-        //! for the convergence of this project.
-        //!
-        //! \param part_hash The hash of a project part from a manifest.
-        //!
-        //! \return \c true if the part hash matches a part annotated for this
-        //! project by a hint in the validated superblock.
-        //!
-        bool Expects(const uint256& part_hash) const
-        {
-            return m_candidate_hashes.count(part_hash) > 0;
-        }
-
-        //!
-        //! \brief Associate a scraper for the specified part.
-        //!
-        //! \param part_hash     Hash of the project part to tally.
-        //! \param scraper_id    The scraper that published the specified part.
-        //! \param supermajority Number of scrapers that must agree on a part.
-        //!
-        //! \return \c true if the part is associated with a supermajority of
-        //! scrapers.
-        //!
-        bool Tally(const uint256& part_hash, ScraperID scraper_id, size_t supermajority)
-        {
-            auto& scrapers = m_candidate_hashes.at(part_hash);
-
-            scrapers.emplace(std::move(scraper_id));
-
-            return scrapers.size() >= supermajority;
-        }
-
-        //!
-        //! \brief Commit the part hash to this project and record the timestamp
-        //! of the manifest.
-        //!
-        //! \param part Hashes of the candidate part and source manifest.
-        //!
-        void LinkPart(ResolvedPart part)
-        {
-            m_candidate_hashes.erase(part.m_part_hash);
-
-            m_resolved_parts.emplace_back(part);
-        }
-    };
-
-    //!
-    //! \brief Generates a superblock hash from the contained convergence of
-    //! manifest parts for comparison to the validated superblock.
-    //!
-    class ConvergenceCandidate
-    {
-    public:
-        //!
-        //! \brief Add the provided manifest part to the convergence.
-        //!
-        //! \param project_name      Identifies the project to add.
-        //! \param project_part_data Serialized project stats of the part.
-        //!
-        void AddPart(std::string project_name, CSplitBlob::CPart* project_part_ptr)
-        {
-            m_convergence.ConvergedManifestPartPtrsMap.emplace(
-                std::move(project_name),
-                std::move(project_part_ptr));
-        }
-
-        //!
-        //! \brief Calculate a superblock hash from the supplied manifest data
-        //! that matches the set of resolved project parts.
-        //!
-        //! \return A superblock hash generated from the convergence to compare
-        //! to the superblock under validation.
-        //!
-        QuorumHash ComputeQuorumHash() const
-        {
-            const ScraperStatsAndVerifiedBeacons stats_and_verified_beacons = GetScraperStatsByConvergedManifest(m_convergence);
-
-            return QuorumHash::Hash(stats_and_verified_beacons);
-        }
-
-    private:
-        ConvergedManifest m_convergence; //!< Used to compute a superblock hash
-    };
-
-    //!
-    //! \brief Constructs by-project convergences from the supplied set of the
-    //! project parts resolved from the superblock.
-    //!
-    //! Nodes validate superblocks in by-project fallback convergence cases by
-    //! matching manifest project parts to the convergence hints embedded in a
-    //! superblock project section. These hints are truncated SHA256 hashes so
-    //! a hint can qualify more than one manifest part for consideration while
-    //! reconstructing a convergence for validation.
-    //!
-    //! This class behaves like a cursor through each combination of the parts
-    //! it is initialized with. For each call to \c GetNextConvergence(), this
-    //! class generates a convergence using a new combination of project parts
-    //! until it exhausts every combination or until the client code matches a
-    //! superblock with one of the results.
-    //!
-    //! We have built here a catapult that fires a huge boulder to kill a tiny
-    //! bird--the chance of a project part hash collision resolved by the hint
-    //! in the superblock is incredibly small, but this provision prevents the
-    //! validation of a superblock from failing if a collision ever occurs.
-    //!
-    class ProjectCombiner
-    {
-    public:
-        //!
-        //! \brief Initialize a project combiner with the provided collection
-        //! of resolved projects.
-        //!
-        //! \param projects Contains matching manifest parts hashes for each
-        //! project hinted in the superblock.
-        //!
-        ProjectCombiner(std::map<std::string, ResolvedProject> projects)
-            : m_projects(std::move(projects))
-            , m_total_combinations(1)
-            , m_current_combination(0)
-        {
-            for (auto& project_pair : reverse_iterate(m_projects)) {
-                project_pair.second.m_combiner_mask = m_total_combinations;
-                m_total_combinations *= project_pair.second.m_resolved_parts.size();
-            }
-        }
-
-        //!
-        //! \brief Initialize a project combiner that produces no results.
-        //!
-        ProjectCombiner()
-            : m_total_combinations(0)
-            , m_current_combination(0)
-        {
-        }
-
-        //!
-        //! \brief Get the total number of possible project part combinations
-        //! that the object can create convergences from.
-        //!
-        //! \return
-        //!
-        size_t TotalCombinations() const
-        {
-            return m_total_combinations;
-        }
-
-        //!
-        //! \brief Generate the next convergence in sequence from the resolved
-        //! project parts.
-        //!
-        //! Jim Owens enlightens us with a stimulating description of his algorithm:
-        //!
-        //! Compute number of permutations and cumulative placevalue. For instance, if there were 4 projects, and
-        //! the number of candidate parts for each of the projects were 2, 3, 2, and 2, then the total number of
-        //! permutations would be 2 * 3 * 2 * 2 = 24, and the cumulative placevalue would be
-        //! -------------------- 12,  4,  2,  1. Notice we will use a reverse iterator to fill in the placevalue
-        //! as we compute the total number of permutations. This is ridiculous of course because 99.99999% of the
-        //! time it is going to be 1 1 1 1 1 1 1 1 1 1 1 1 1 1 1 1 1 1 1 (one permutation) or at most something like
-        //! 1 1 1 1 1 1 1 1 2 1 1 1 1 1 1 1 1 1 1, which will resolve to two permutations, but I am doing the full algorithm
-        //! to be thorough.
-        //!
-        //! A further explanation...
-        //!
-        //! The easiest way to understand this algorithm is to compare it to a binary number....
-        //! Each place has two possibilities, so the total possibilities are 2^n where you have n places.
-        //! I.e if you had 4 places (think four projects) each with 2 candidate parts, you would have 0000 to 1111.
-        //! This is permutation index 0 to 7 for a total of eight permutations. If the outer loop is the
-        //! permutation index, you derive the place values by multiplying the combinations for the places
-        //! up to but not including the place for the four digit binary number ... the place values are 8, 4, 2, 1.
-        //!
-        //! So, if you are at index 5 this is, starting at the most significant digit,
-        //! 5/8 = 0 remainder 5.
-        //! 5/4 = 1 remainder 1.
-        //! 1/2 = 0 remainder 1.
-        //! 1/1 = 1 remainder 0.
-        //! (This of course is 0101 binary for 5.)
-        //!
-        //! If the number of candidate parts varies for each project (which it will in this problem), the place
-        //! is a different base for each place, and then you track the number of possibilities in each place with
-        //! the helper as I described in the comments. This allows the outer loop to simply run consecutively through
-        //! the permutation index from 0 to n-1 permutations, and then for each permutation index value the repeated
-        //! division in the inner loop  “decodes” the index into the selected part for each placeholder (project).
-        //! Since you calculated the permutation index max n by multiplying all of the possibilities together for each
-        //! place you know you have covered them all. I think it is a pretty elegant approach to the problem with iteration.
-        //!
-        //! \return A convergence to generate a superblock hash from if a new
-        //! combination is possible.
-        //!
-        std::optional<ConvergenceCandidate> GetNextConvergence()
-        {
-            if (m_current_combination == m_total_combinations) {
-                return std::nullopt;
-            }
-
-            ConvergenceCandidate convergence;
-            size_t remainder = m_current_combination;
-            uint256 latest_manifest;
-            int64_t latest_manifest_time = 0;
-
-            for (const auto& project_pair : m_projects) {
-                const ResolvedProject& project = project_pair.second;
-                const size_t part_index = remainder / project.m_combiner_mask;
-
-                    LogPrint(BCLog::LogFlags::VERBOSE,
-                        "ValidateSuperblock(): uncached by project: "
-                        "%" PRIszu "/%" PRIszu " = part_index = %" PRIszu " index max = %" PRIszu,
-                        remainder,
-                        project.m_combiner_mask,
-                        part_index,
-                        project.m_resolved_parts.size() - 1);
-
-                const auto& resolved_part = project.m_resolved_parts[part_index];
-
-                convergence.AddPart(
-                    project_pair.first, // project name
-                    GetResolvedPartPtr(resolved_part.m_part_hash));
-
-                remainder -= part_index * project.m_combiner_mask;
-
-                // Find the most recent manifest that provided one of the parts
-                // to fetch the beacon list from:
-                //
-                if (resolved_part.m_source_manifest_time > latest_manifest_time) {
-                    latest_manifest = resolved_part.m_source_manifest_hash;
-                    latest_manifest_time = resolved_part.m_source_manifest_time;
-                }
-            }
-
-            AddBeaconPartsData(convergence, latest_manifest);
-
-            ++m_current_combination;
-
-            return std::make_optional(std::move(convergence));
-        }
-
-    private:
-        //!
-        //! \brief The collection of manifest project parts grouped by project
-        //! to create convergence combinations from.
-        //!
-        std::map<std::string, ResolvedProject> m_projects;
-
-        size_t m_total_combinations;  //!< Number of project part combinations.
-        size_t m_current_combination; //!< Number of the combination to try.
-
-        //!
-        //! \brief Fetch the project part data for the specified part hash.
-        //!
-        //! \param part_hash Identifies the project part to fetch.
-        //!
-        //! \return Serialized binary data of the part to add to a convergence.
-        //!
-        static CSplitBlob::CPart* GetResolvedPartPtr(const uint256& part_hash)
-        {
-            LOCK(CSplitBlob::cs_mapParts);
-
-            const auto iter = CSplitBlob::mapParts.find(part_hash);
-
-            // If the resolved part disappeared, we cannot proceed, but
-            // the most recent project part should always exist:
-            if (iter == CSplitBlob::mapParts.end()) {
-                LogPrintf("ValidateSuperblock(): project part disappeared.");
-                return nullptr;
-            }
-
-            return &(iter->second);
-        }
-
-        //!
-        //! \brief Insert the beacon list and verified beacons part data from
-        //! the specified manifest into the provided convergence candidate.
-        //!
-        //! \param convergence   Convergence to add the beacon parts to.
-        //! \param manifest_hash Identifies the manifest to fetch the parts from.
-        //!
-        static void AddBeaconPartsData(
-            ConvergenceCandidate& convergence,
-            const uint256& manifest_hash)
-        {
-            LOCK(CScraperManifest::cs_mapManifest);
-
-            const auto iter = CScraperManifest::mapManifest.find(manifest_hash);
-
-            // If the manifest for the beacon list disappeared, we cannot
-            // proceed, but the most recent manifest should always exist:
-            if (iter == CScraperManifest::mapManifest.end()) {
-                LogPrintf("ValidateSuperblock(): beacon manifest disappeared.");
-                return;
-            }
-
-            const CScraperManifest_shared_ptr manifest = iter->second;
-
-            // If the manifest for the beacon list is now empty, we cannot
-            // proceed, but ProjectResolver should always select manifests
-            // with a beacon list part:
-            if (manifest->vParts.empty()) {
-                LogPrintf("ValidateSuperblock(): beacon list part missing.");
-                return;
-            }
-
-            convergence.AddPart("BeaconList", manifest->vParts[0]);
-
-            // Find the offset of the verified beacons project part. Typically
-            // this exists at vParts offset 1 when a scraper verified at least
-            // one pending beacon. If it doesn't exist, omit the part from the
-            // reconstructed convergence:
-            const auto verified_beacons_entry_iter = std::find_if(
-                manifest->projects.begin(),
-                manifest->projects.end(),
-                [](const CScraperManifest::dentry& entry) {
-                    return entry.project == "VerifiedBeacons";
-                });
-
-            if (verified_beacons_entry_iter == manifest->projects.end()) {
-                LogPrintf("ValidateSuperblock(): verified beacon project missing.");
-                return;
-            }
-
-            const size_t part_offset = verified_beacons_entry_iter->part1;
-
-            if (part_offset == 0 || part_offset >= manifest->vParts.size()) {
-                LogPrintf("ValidateSuperblock(): out-of-range verified beacon part.");
-                return;
-            }
-
-            convergence.AddPart("VerifiedBeacons", manifest->vParts[part_offset]);
-        }
-    }; // ProjectCombiner
-
     //!
     //! \brief Prepares a set of manifest parts for each project hinted in the
     //! superblock to find a supermajority for every project.
@@ -1413,13 +1175,13 @@ private: // SuperblockValidator methods
                  "ValidateSuperblock(): by-project possible combinations: %" PRIszu,
                  combiner.TotalCombinations());
 
-        while (const auto combination_option = combiner.GetNextConvergence()) {
-            if (combination_option->ComputeQuorumHash() == m_quorum_hash) {
-                return true;
-            }
-        }
+        combiner.Prune(*m_superblock);
 
-        return false;
+        LogPrint(BCLog::LogFlags::VERBOSE,
+                 "ValidateSuperblock(): by-project combinations after pruning: %" PRIszu,
+                 combiner.TotalCombinations());
+
+        return combiner.FindMatch(m_quorum_hash);
     }
 
     //!
@@ -1699,11 +1461,12 @@ Superblock Quorum::CreateSuperblock()
     return ScraperGetSuperblockContract();
 }
 
-void Quorum::PushSuperblock(SuperblockPtr superblock)
+void Quorum::PushSuperblock(SuperblockPtr superblock, const CBlockIndex* const pindex)
 {
     LogPrintf("Quorum::PushSuperblock(%" PRId64 ")", superblock.m_height);
 
     g_superblock_index.PushSuperblock(std::move(superblock));
+    g_superblock_index.AddToHistory(pindex);
 }
 
 void Quorum::PopSuperblock(const CBlockIndex* const pindex)
@@ -1711,9 +1474,325 @@ void Quorum::PopSuperblock(const CBlockIndex* const pindex)
     LogPrintf("Quorum::PopSuperblock(%" PRId64 ")", pindex->nHeight);
 
     g_superblock_index.PopSuperblock();
+    g_superblock_index.RemoveFromHistory(pindex);
+}
+
+const CBlockIndex* Quorum::FindSuperblockAt(const int64_t time)
+{
+    return g_superblock_index.FindByTime(time);
 }
 
 bool Quorum::CommitSuperblock(const uint32_t height)
 {
     return g_superblock_index.Commit(height);
 }
+
+// -----------------------------------------------------------------------------
+// Class: ProjectCombiner
+// -----------------------------------------------------------------------------
+
+//!
+//! \brief Generates a superblock hash from the contained convergence of
+//! manifest parts for comparison to the validated superblock.
+//!
+class ProjectCombiner::ConvergenceCandidate
+{
+public:
+    //!
+    //! \brief Add the provided manifest part to the convergence.
+    //!
+    //! \param project_name      Identifies the project to add.
+    //! \param project_part_data Serialized project stats of the part.
+    //!
+    void AddPart(std::string project_name, CSplitBlob::CPart* project_part_ptr)
+    {
+        m_convergence.ConvergedManifestPartPtrsMap.emplace(
+            std::move(project_name),
+            std::move(project_part_ptr));
+    }
+
+    //!
+    //! \brief Calculate a superblock hash from the supplied manifest data
+    //! that matches the set of resolved project parts.
+    //!
+    //! \return A superblock hash generated from the convergence to compare
+    //! to the superblock under validation.
+    //!
+    QuorumHash ComputeQuorumHash() const
+    {
+        const ScraperStatsAndVerifiedBeacons stats_and_verified_beacons = GetScraperStatsByConvergedManifest(m_convergence);
+
+        return QuorumHash::Hash(stats_and_verified_beacons);
+    }
+
+private:
+    ConvergedManifest m_convergence; //!< Used to compute a superblock hash
+}; // ProjectCombiner::ConvergenceCandidate
+
+size_t ProjectCombiner::TotalCombinations() const
+{
+    return Search().TotalCombinations();
+}
+
+void ProjectCombiner::Prune(const Superblock& superblock)
+{
+    std::vector<std::pair<const std::string*, ResolvedPart*>> parts;
+
+    for (auto& project_pair : m_projects) {
+        for (auto& part : project_pair.second.m_resolved_parts) {
+            parts.emplace_back(&project_pair.first, &part);
+        }
+    }
+
+    // Every combination contains each project once, so each project
+    // receives the same share of the network magnitude as it does in
+    // GetScraperStatsByConvergedManifest():
+    //
+    const double magnitude_per_project = NETWORK_MAGNITUDE / m_projects.size();
+
+    ParallelFor(parts.size(), [&](const size_t i) {
+        const std::string& project_name = *parts[i].first;
+        ResolvedPart& part = *parts[i].second;
+        const CSplitBlob::CPart* const part_ptr = GetResolvedPartPtr(part.m_part_hash);
+
+        if (!part_ptr) {
+            return;
+        }
+
+        auto stats = std::make_shared<ScraperStats>();
+
+        try {
+            LoadProjectObjectToStatsByCPID(project_name, part_ptr->data, magnitude_per_project, *stats);
+        } catch (const std::exception& e) {
+            LogPrintf("ValidateSuperblock(): failed to load project part: %s", e.what());
+            return;
+        }
+
+        part.m_stats = std::move(stats);
+    });
+
+    for (auto& project_pair : m_projects) {
+        const Superblock::ProjectStatsOption expected = superblock.m_projects.Try(project_pair.first);
+        std::vector<ResolvedPart>& resolved_parts = project_pair.second.m_resolved_parts;
+
+        resolved_parts.erase(
+            std::remove_if(
+                resolved_parts.begin(),
+                resolved_parts.end(),
+                [&](const ResolvedPart& part) {
+                    return !part.m_stats
+                        || (expected && !MatchesProjectStats(*part.m_stats, project_pair.first, *expected));
+                }),
+            resolved_parts.end());
+    }
+}
+
+bool ProjectCombiner::FindMatch(const QuorumHash& quorum_hash) const
+{
+    const CombinationSearch search = Search();
+
+    // Refuse to search a range that the combination numbers cannot cover
+    // instead of checking only part of it:
+    //
+    if (search.Saturated()) {
+        LogPrintf("ValidateSuperblock(): too many by-project combinations to search.");
+        return false;
+    }
+
+    return search.FindFirst([&](const std::vector<size_t>& selection) {
+        return ComputeQuorumHash(selection) == quorum_hash;
+    }).has_value();
+}
+
+CombinationSearch ProjectCombiner::Search() const
+{
+    std::vector<size_t> group_sizes;
+    group_sizes.reserve(m_projects.size());
+
+    for (const auto& project_pair : m_projects) {
+        group_sizes.push_back(project_pair.second.m_resolved_parts.size());
+    }
+
+    return CombinationSearch(group_sizes);
+}
+
+QuorumHash ProjectCombiner::ComputeQuorumHash(const std::vector<size_t>& selection) const
+{
+    ScraperStatsAndVerifiedBeacons stats_and_verified_beacons;
+    uint256 latest_manifest;
+    int64_t latest_manifest_time = 0;
+    size_t project_index = 0;
+
+    for (const auto& project_pair : m_projects) {
+        const ResolvedProject& project = project_pair.second;
+        const ResolvedPart& resolved_part = project.m_resolved_parts[selection[project_index++]];
+
+        stats_and_verified_beacons.mScraperStats.insert(
+            resolved_part.m_stats->begin(),
+            resolved_part.m_stats->end());
+
+        // Find the most recent manifest that provided one of the parts
+        // to fetch the beacon list from:
+        //
+        if (resolved_part.m_source_manifest_time > latest_manifest_time) {
+            latest_manifest = resolved_part.m_source_manifest_hash;
+            latest_manifest_time = resolved_part.m_source_manifest_time;
+        }
+    }
+
+    const BeaconParts beacon_parts = FindBeaconParts(latest_manifest);
+
+    // Without the beacon list, the scraper's count of projects in the
+    // convergence differs from the number of projects that the stats
+    // were loaded for. Build the convergence in full instead:
+    //
+    if (!beacon_parts.m_beacon_list) {
+        return BuildConvergence(selection).ComputeQuorumHash();
+    }
+
+    if (beacon_parts.m_verified_beacons) {
+        ScraperPendingBeaconMap verified_beacons;
+        CDataStream part(beacon_parts.m_verified_beacons->data, SER_NETWORK, 1);
+
+        try {
+            part >> verified_beacons;
+        } catch (const std::exception& e) {
+            LogPrintf("ValidateSuperblock(): failed to deserialize verified beacons part: %s", e.what());
+        }
+
+        stats_and_verified_beacons.mVerifiedMap = std::move(verified_beacons);
+    }
+
+    ProcessNetworkWideFromProjectStats(stats_and_verified_beacons.mScraperStats);
+
+    return QuorumHash::Hash(stats_and_verified_beacons);
+}
+
+ProjectCombiner::ConvergenceCandidate ProjectCombiner::BuildConvergence(const std::vector<size_t>& selection) const
+{
+    ConvergenceCandidate convergence;
+    uint256 latest_manifest;
+    int64_t latest_manifest_time = 0;
+    size_t project_index = 0;
+
+    for (const auto& project_pair : m_projects) {
+        const ResolvedProject& project = project_pair.second;
+        const ResolvedPart& resolved_part = project.m_resolved_parts[selection[project_index++]];
+
+        convergence.AddPart(
+            project_pair.first, // project name
+            GetResolvedPartPtr(resolved_part.m_part_hash));
+
+        if (resolved_part.m_source_manifest_time > latest_manifest_time) {
+            latest_manifest = resolved_part.m_source_manifest_hash;
+            latest_manifest_time = resolved_part.m_source_manifest_time;
+        }
+    }
+
+    const BeaconParts beacon_parts = FindBeaconParts(latest_manifest);
+
+    if (beacon_parts.m_beacon_list) {
+        convergence.AddPart("BeaconList", beacon_parts.m_beacon_list);
+    }
+
+    if (beacon_parts.m_verified_beacons) {
+        convergence.AddPart("VerifiedBeacons", beacon_parts.m_verified_beacons);
+    }
+
+    return convergence;
+}
+
+bool ProjectCombiner::MatchesProjectStats(
+    const ScraperStats& stats,
+    const std::string& project_name,
+    const Superblock::ProjectStats& expected)
+{
+    const auto iter = stats.find(ScraperObjectStatsKey { statsobjecttype::byProject, project_name });
+
+    if (iter == stats.end()) {
+        return false;
+    }
+
+    const ScraperObjectStatsValue& value = iter->second.statsvalue;
+
+    // Round the values in the same way that superblocks load them:
+    const Superblock::ProjectStats actual(
+        std::nearbyint(value.dTC),
+        std::nearbyint(value.dAvgRAC),
+        std::nearbyint(value.dRAC));
+
+    return actual.m_total_credit == expected.m_total_credit
+        && actual.m_average_rac == expected.m_average_rac
+        && actual.m_rac == expected.m_rac;
+}
+
+CSplitBlob::CPart* ProjectCombiner::GetResolvedPartPtr(const uint256& part_hash)
+{
+    LOCK(CSplitBlob::cs_mapParts);
+
+    const auto iter = CSplitBlob::mapParts.find(part_hash);
+
+    // If the resolved part disappeared, we cannot proceed, but
+    // the most recent project part should always exist:
+    if (iter == CSplitBlob::mapParts.end()) {
+        LogPrintf("ValidateSuperblock(): project part disappeared.");
+        return nullptr;
+    }
+
+    return &(iter->second);
+}
+
+ProjectCombiner::BeaconParts ProjectCombiner::FindBeaconParts(const uint256& manifest_hash)
+{
+    BeaconParts beacon_parts;
+
+    LOCK(CScraperManifest::cs_mapManifest);
+
+    const auto iter = CScraperManifest::mapManifest.find(manifest_hash);
+
+    // If the manifest for the beacon list disappeared, we cannot
+    // proceed, but the most recent manifest should always exist:
+    if (iter == CScraperManifest::mapManifest.end()) {
+        LogPrintf("ValidateSuperblock(): beacon manifest disappeared.");
+        return beacon_parts;
+    }
+
+    const CScraperManifest_shared_ptr manifest = iter->second;
+
+    // If the manifest for the beacon list is now empty, we cannot
+    // proceed, but ProjectResolver should always select manifests
+    // with a beacon list part:
+    if (manifest->vParts.empty()) {
+        LogPrintf("ValidateSuperblock(): beacon list part missing.");
+        return beacon_parts;
+    }
+
+    beacon_parts.m_beacon_list = manifest->vParts[0];
+
+    // Find the offset of the verified beacons project part. Typically
+    // this exists at vParts offset 1 when a scraper verified at least
+    // one pending beacon. If it doesn't exist, omit the part from the
+    // reconstructed convergence:
+    const auto verified_beacons_entry_iter = std::find_if(
+        manifest->projects.begin(),
+        manifest->projects.end(),
+        [](const CScraperManifest::dentry& entry) {
+            return entry.project == "VerifiedBeacons";
+        });
+
+    if (verified_beacons_entry_iter == manifest->projects.end()) {
+        LogPrintf("ValidateSuperblock(): verified beacon project missing.");
+        return beacon_parts;
+    }
+
+    const size_t part_offset = verified_beacons_entry_iter->part1;
+
+    if (part_offset == 0 || part_offset >= manifest->vParts.size()) {
+        LogPrintf("ValidateSuperblock(): out-of-range verified beacon part.");
+        return beacon_parts;
+    }
+
+    beacon_parts.m_verified_beacons = manifest->vParts[part_offset];
+
+    return beacon_parts;
+}
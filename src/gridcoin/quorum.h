@@ -215,8 +215,9 @@ public:
     //! \brief Push a new superblock into the tally.
     //!
     //! \param superblock Contains the superblock data to load.
+    //! \param pindex     Represents the block that contains the superblock.
     //!
-    static void PushSuperblock(SuperblockPtr superblock);
+    static void PushSuperblock(SuperblockPtr superblock, const CBlockIndex* const pindex);
 
     //!
     //! \brief Drop the last superblock loaded into the tally.
@@ -225,6 +226,20 @@ public:
     //!
     static void PopSuperblock(const CBlockIndex* const pindex);
 
+    //!
+    //! \brief Find the last superblock in the main chain with a timestamp at
+    //! or before the specified time.
+    //!
+    //! The first call scans the chain to build an ordered index of superblock
+    //! heights and times. Later calls search the index in logarithmic time.
+    //!
+    //! \param time Timestamp to find the active superblock for.
+    //!
+    //! \return Block index entry of the block that contains the superblock, or
+    //! \c nullptr when no superblock in the main chain is that old.
+    //!
+    static const CBlockIndex* FindSuperblockAt(const int64_t time);
+
     //!
     //! \brief Activate the superblock received at or below the specified
     //! height.
@@ -1286,8 +1286,7 @@ bool Researcher::IsInvestor() const
 GRC::Magnitude Researcher::Magnitude() const
 {
     if (const auto cpid_option = m_mining_id.TryCpid()) {
-        LOCK(cs_main);
-        return Quorum::GetMagnitude(*cpid_option);
+        return Tally::CurrentSnapshot()->m_superblock->m_cpids.MagnitudeOf(*cpid_option);
     }
 
     return GRC::Magnitude::Zero();
@@ -1311,16 +1310,15 @@ bool Researcher::HasRAC() const
 CAmount Researcher::Accrual() const
 {
     const CpidOption cpid = m_mining_id.TryCpid();
+    const TallySnapshotPtr tally = Tally::CurrentSnapshot();
 
-    if (!cpid || !pindexBest) {
+    if (!cpid || !tally->m_pindex) {
         return 0;
     }
 
-    const int64_t now = OutOfSyncByAge() ? pindexBest->nTime : GetAdjustedTime();
-
-    LOCK(cs_main);
+    const int64_t now = OutOfSyncByAge() ? tally->m_pindex->nTime : GetAdjustedTime();
 
-    return Tally::GetAccrual(*cpid, now, pindexBest);
+    return tally->GetAccrual(*cpid, now);
 }
 
 ResearcherStatus Researcher::Status() const
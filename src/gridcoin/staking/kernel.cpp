@@ -5,6 +5,8 @@
 
 #include "amount.h"
 #include "arith_uint256.h"
+#include "crypto/common.h"
+#include "crypto/sha256.h"
 #include "gridcoin/staking/kernel.h"
 #include "txdb.h"
 #include "main.h"
@@ -517,6 +519,138 @@ uint256 GRC::CalculateStakeHashV8(
     return ss.GetHash();
 }
 
+// -----------------------------------------------------------------------------
+// Class: StakeKernelPrefix
+// -----------------------------------------------------------------------------
+
+StakeKernelPrefix::StakeKernelPrefix()
+{
+    m_bytes.fill(0);
+}
+
+StakeKernelPrefix::StakeKernelPrefix(
+    uint64_t StakeModifier,
+    unsigned int nBlockTime,
+    const uint256& hashTx,
+    unsigned CoinTxN)
+{
+    CDataStream ss(SER_GETHASH, 0);
+
+    ss << StakeModifier;
+    ss << MaskStakeTime((uint32_t) nBlockTime);
+    ss << hashTx;
+    ss << CoinTxN;
+
+    assert(ss.size() == SIZE);
+
+    std::copy(ss.begin(), ss.end(), m_bytes.begin());
+}
+
+uint256 StakeKernelPrefix::Hash(unsigned nTimeTx) const
+{
+    CHashWriter ss(SER_GETHASH, 0);
+
+    ss.write((const char*)m_bytes.data(), m_bytes.size());
+    ss << MaskStakeTime(nTimeTx);
+
+    return ss.GetHash();
+}
+
+std::vector<uint256> GRC::CalculateStakeHashesV8(
+    const std::vector<const StakeKernelPrefix*>& kernels,
+    unsigned nTimeTx)
+{
+    // The kernel message is the prefix followed by the 4-byte masked time. It
+    // must leave room for the SHA256 padding in a single 64-byte block:
+    constexpr size_t message_size = StakeKernelPrefix::SIZE + sizeof(uint32_t);
+    static_assert(message_size <= 55, "kernel message exceeds one SHA256 block");
+
+    const uint32_t masked_time = MaskStakeTime((uint32_t) nTimeTx);
+
+    std::vector<unsigned char> blocks(kernels.size() * 64, 0);
+    std::vector<unsigned char> digests(kernels.size() * 32);
+
+    for (size_t i = 0; i < kernels.size(); ++i) {
+        unsigned char* block = &blocks[i * 64];
+
+        std::copy(kernels[i]->Raw().begin(), kernels[i]->Raw().end(), block);
+        WriteLE32(block + StakeKernelPrefix::SIZE, masked_time);
+        block[message_size] = 0x80;
+        WriteBE64(block + 56, message_size * 8);
+    }
+
+    SHA256DSingle(digests.data(), blocks.data(), kernels.size());
+
+    std::vector<uint256> hashes(kernels.size());
+
+    for (size_t i = 0; i < hashes.size(); ++i) {
+        std::copy(&digests[i * 32], &digests[i * 32] + 32, hashes[i].begin());
+    }
+
+    return hashes;
+}
+
+bool GRC::CheckStakeKernelHashV8(const uint256& hash, unsigned int nBits, int64_t Weight)
+{
+    bool negative;
+    bool overflow;
+    arith_uint256 target;
+
+    target.SetCompact(nBits, &negative, &overflow);
+
+    // A zero base target or weight produces a zero weighted target that only
+    // a zero hash can meet:
+    if (Weight == 0 || (target == 0 && !overflow)) {
+        return hash.IsNull();
+    }
+
+    // No hash meets a negative weighted target:
+    if (negative != (Weight < 0)) {
+        return false;
+    }
+
+    // The base target alone exceeds 256 bits, so any hash meets it:
+    if (overflow) {
+        return true;
+    }
+
+    const uint64_t abs_weight = Weight < 0 ? 0 - (uint64_t)Weight : (uint64_t)Weight;
+    const uint32_t weight_limbs[2] = { (uint32_t)abs_weight, (uint32_t)(abs_weight >> 32) };
+    const uint256 target_bytes = ArithToUint256(target);
+
+    // Multiply the 256-bit target by the 64-bit weight in 32-bit limbs:
+    uint32_t product[10] = { };
+
+    for (int j = 0; j < 2; ++j) {
+        uint64_t carry = 0;
+
+        for (int i = 0; i < 8; ++i) {
+            uint64_t n = carry + product[i + j]
+                + (uint64_t)ReadLE32(target_bytes.begin() + i * 4) * weight_limbs[j];
+
+            product[i + j] = (uint32_t)n;
+            carry = n >> 32;
+        }
+
+        product[8 + j] = (uint32_t)carry;
+    }
+
+    // The weighted target exceeds the range of any hash:
+    if (product[8] != 0 || product[9] != 0) {
+        return true;
+    }
+
+    for (int i = 7; i >= 0; --i) {
+        const uint32_t hash_limb = ReadLE32(hash.begin() + i * 4);
+
+        if (hash_limb != product[i]) {
+            return hash_limb < product[i];
+        }
+    }
+
+    return true;
+}
+
 int64_t GRC::CalculateStakeWeightV8(const CTransaction &CoinTx, unsigned CoinTxN)
 {
     CAmount nValueIn = CoinTx.vout[CoinTxN].nValue;
@@ -600,24 +734,23 @@ bool GRC::CheckProofOfStakeV8(
 
     //Stake refactoring TomasBrod
     int64_t Weight = CalculateStakeWeightV8(txPrev, prevout.n);
-    CBigNum bnHashProof(hashProofOfStake);
-
-    // Base target
-    CBigNum bnTarget;
-    bnTarget.SetCompact(Block.nBits);
-    // Weighted target
-    bnTarget *= Weight;
 
-
-    LogPrint(BCLog::LogFlags::VERBOSE,
-             "CheckProofOfStakeV8:%s Time1 %.f, Time2 %.f, Time3 %.f, Bits %u, Weight %.f\n"
-             " Stk %72s\n"
-             " Trg %72s", generated_by_me?" Local,":"",
-             (double)header.nTime, (double)txPrev.nTime, (double)tx.nTime,
-             Block.nBits, (double)Weight,
-             CBigNum(hashProofOfStake).GetHex(), bnTarget.GetHex()
-             );
+    if (LogInstance().WillLogCategory(BCLog::LogFlags::VERBOSE)) {
+        // Base target
+        CBigNum bnTarget;
+        bnTarget.SetCompact(Block.nBits);
+        // Weighted target
+        bnTarget *= Weight;
+
+        LogPrintf("CheckProofOfStakeV8:%s Time1 %.f, Time2 %.f, Time3 %.f, Bits %u, Weight %.f\n"
+                  " Stk %72s\n"
+                  " Trg %72s", generated_by_me?" Local,":"",
+                  (double)header.nTime, (double)txPrev.nTime, (double)tx.nTime,
+                  Block.nBits, (double)Weight,
+                  CBigNum(hashProofOfStake).GetHex(), bnTarget.GetHex()
+                  );
+    }
 
     // Now check if proof-of-stake hash meets target protocol
-    return bnHashProof <= bnTarget;
+    return CheckStakeKernelHashV8(hashProofOfStake, Block.nBits, Weight);
 }
@@ -8,6 +8,8 @@
 #include "amount.h"
 #include "main.h"
 
+#include <array>
+
 namespace GRC {
 // To decrease granularity of timestamp
 // Supposed to be 2^n-1
@@ -118,6 +120,95 @@ uint256 CalculateStakeHashV8(
     unsigned nTimeTx,
     uint64_t StakeModifier);
 
+//!
+//! \brief Holds the serialized inputs of the version 8 stake kernel hash that
+//! do not change between staking attempts for an output.
+//!
+//! The kernel hash digests the stake modifier, the masked time of the block
+//! that contains the staked output, the output's transaction hash and index,
+//! and the masked coinstake time. Only the coinstake time changes while the
+//! miner searches for a kernel, so it serializes the rest once per output.
+//!
+class StakeKernelPrefix
+{
+public:
+    //!
+    //! \brief Number of bytes in the serialized prefix.
+    //!
+    static constexpr size_t SIZE = sizeof(uint64_t) + sizeof(uint32_t) + sizeof(uint256) + sizeof(uint32_t);
+
+    //!
+    //! \brief Initialize an empty prefix.
+    //!
+    StakeKernelPrefix();
+
+    //!
+    //! \brief Serialize the kernel inputs for an output.
+    //!
+    //! \param StakeModifier Stake modifier of the chain tip.
+    //! \param nBlockTime    Time of the block that contains the output.
+    //! \param hashTx        Hash of the transaction that contains the output.
+    //! \param CoinTxN       Index of the output in the transaction.
+    //!
+    StakeKernelPrefix(
+        uint64_t StakeModifier,
+        unsigned int nBlockTime,
+        const uint256& hashTx,
+        unsigned CoinTxN);
+
+    //!
+    //! \brief Calculate the kernel hash for a coinstake timestamp.
+    //!
+    //! \param nTimeTx Time of the coinstake transaction.
+    //!
+    //! \return The same value as \c CalculateStakeHashV8() for the output.
+    //!
+    uint256 Hash(unsigned nTimeTx) const;
+
+    //!
+    //! \brief Get the serialized kernel inputs.
+    //!
+    const std::array<unsigned char, SIZE>& Raw() const
+    {
+        return m_bytes;
+    }
+
+private:
+    std::array<unsigned char, SIZE> m_bytes; //!< Serialized kernel inputs.
+};
+
+//!
+//! \brief Calculate the kernel hashes of several outputs for one coinstake time.
+//!
+//! The kernel message fits in a single SHA256 block, so this hashes batches of
+//! outputs in parallel with the multi-way SHA256 implementations when the CPU
+//! supports them.
+//!
+//! \param kernels Serialized kernel inputs of the outputs to hash.
+//! \param nTimeTx Time of the coinstake transaction.
+//!
+//! \return The kernel hash of each output in the same order as the input.
+//!
+std::vector<uint256> CalculateStakeHashesV8(
+    const std::vector<const StakeKernelPrefix*>& kernels,
+    unsigned nTimeTx);
+
+//!
+//! \brief Determine whether a version 8 kernel hash meets the weighted stake
+//! target.
+//!
+//! This produces the same result as expanding the compact target to a CBigNum,
+//! multiplying it by the weight, and comparing the hash to the product. It uses
+//! fixed-width integers instead so that the staker and block validation avoid
+//! heap allocations and OpenSSL calls for each kernel.
+//!
+//! \param hash   Kernel hash of the staked output.
+//! \param nBits  Compact representation of the block's target.
+//! \param Weight Stake weight of the staked output.
+//!
+//! \return \c true if the hash is less than or equal to the weighted target.
+//!
+bool CheckStakeKernelHashV8(const uint256& hash, unsigned int nBits, int64_t Weight);
 
 int64_t CalculateStakeWeightV8(const CTransaction &CoinTx, unsigned CoinTxN);
 int64_t CalculateStakeWeightV8(const CAmount& nValueIn);
@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "compat/endian.h"
+#include "crypto/common.h"
 #include "hash.h"
 #include "main.h"
 #include "gridcoin/superblock.h"
@@ -735,33 +736,7 @@ double Superblock::CpidIndex::AverageMagnitude() const
 
 Magnitude Superblock::CpidIndex::MagnitudeOf(const Cpid& cpid) const
 {
-    if (m_legacy) {
-        const auto iter = std::lower_bound(
-            m_legacy_magnitudes.begin(),
-            m_legacy_magnitudes.end(),
-            cpid,
-            Superblock::CompareCpidOfPairLessThan);
-
-        if (iter == m_legacy_magnitudes.end() || iter->first != cpid) {
-            return Magnitude::Zero();
-        }
-
-        return Magnitude::FromScaled(iter->second * Magnitude::SCALE_FACTOR);
-    }
-
-    if (const auto mag_option = m_small_magnitudes.MagnitudeOf(cpid)) {
-        return *mag_option;
-    }
-
-    if (const auto mag_option = m_medium_magnitudes.MagnitudeOf(cpid)) {
-        return *mag_option;
-    }
-
-    if (const auto mag_option = m_large_magnitudes.MagnitudeOf(cpid)) {
-        return *mag_option;
-    }
-
-    return Magnitude::Zero();
+    return m_lookup.Find(cpid);
 }
 
 Superblock::CpidIndex::const_iterator
@@ -773,6 +748,8 @@ Superblock::CpidIndex::At(const size_t offset) const
 
 void Superblock::CpidIndex::Add(const Cpid cpid, const Magnitude magnitude)
 {
+    Magnitude stored = Magnitude::Zero();
+
     // Only increment the total magnitude if the CPID does not already
     // exist in the index:
     switch (magnitude.Which()) {
@@ -781,19 +758,21 @@ void Superblock::CpidIndex::Add(const Cpid cpid, const Magnitude magnitude)
             return;
 
         case Magnitude::Kind::SMALL:
-            m_small_magnitudes.Add(cpid, magnitude);
+            stored = m_small_magnitudes.Add(cpid, magnitude);
             break;
 
         case Magnitude::Kind::MEDIUM:
-            m_medium_magnitudes.Add(cpid, magnitude);
+            stored = m_medium_magnitudes.Add(cpid, magnitude);
             break;
 
         case Magnitude::Kind::LARGE:
-            m_large_magnitudes.Add(cpid, magnitude);
+            stored = m_large_magnitudes.Add(cpid, magnitude);
             break;
     }
 
     m_total_magnitude += magnitude.Scaled();
+
+    m_lookup.Add(cpid, stored.Scaled());
 }
 
 void Superblock::CpidIndex::AddLegacy(const Cpid cpid, const uint16_t magnitude)
@@ -801,6 +780,30 @@ void Superblock::CpidIndex::AddLegacy(const Cpid cpid, const uint16_t magnitude)
     m_legacy_magnitudes.emplace_back(cpid, magnitude);
 
     m_total_magnitude += magnitude * Magnitude::SCALE_FACTOR;
+
+    m_lookup.Add(cpid, magnitude * Magnitude::SCALE_FACTOR);
+}
+
+void Superblock::CpidIndex::RebuildLookup()
+{
+    // Adding the segments in order makes the lookup table keep the magnitude
+    // of a CPID from the first segment that contains it:
+    //
+    const auto add_segment = [&](const auto& segment, const uint32_t scale) {
+        for (const auto& cpid_pair : segment) {
+            m_lookup.Add(cpid_pair.first, cpid_pair.second * scale);
+        }
+    };
+
+    m_lookup.Clear(size());
+
+    if (m_legacy) {
+        add_segment(m_legacy_magnitudes, Magnitude::SCALE_FACTOR);
+    } else {
+        add_segment(m_small_magnitudes, decltype(m_small_magnitudes)::SCALE_FACTOR);
+        add_segment(m_medium_magnitudes, decltype(m_medium_magnitudes)::SCALE_FACTOR);
+        add_segment(m_large_magnitudes, decltype(m_large_magnitudes)::SCALE_FACTOR);
+    }
 }
 
 uint256 Superblock::CpidIndex::HashSegments() const
@@ -814,6 +817,134 @@ uint256 Superblock::CpidIndex::HashSegments() const
     return hasher.GetHash();
 }
 
+// -----------------------------------------------------------------------------
+// Class: Superblock::CpidIndex::LookupTable
+// -----------------------------------------------------------------------------
+
+Superblock::CpidIndex::LookupKey::LookupKey(const Cpid& cpid)
+    : m_high(ReadBE64(cpid.Raw().data()))
+    , m_low(ReadBE64(cpid.Raw().data() + 8))
+{
+}
+
+Superblock::CpidIndex::LookupTable::LookupTable() : m_sorted(true)
+{
+}
+
+Superblock::CpidIndex::LookupTable::LookupTable(const LookupTable& other)
+    : m_sorted(true)
+{
+    other.Sort();
+
+    m_keys = other.m_keys;
+    m_magnitudes = other.m_magnitudes;
+}
+
+Superblock::CpidIndex::LookupTable&
+Superblock::CpidIndex::LookupTable::operator=(const LookupTable& other)
+{
+    if (this != &other) {
+        other.Sort();
+
+        m_keys = other.m_keys;
+        m_magnitudes = other.m_magnitudes;
+        m_sorted = true;
+    }
+
+    return *this;
+}
+
+void Superblock::CpidIndex::LookupTable::Clear(const size_t capacity)
+{
+    m_keys.clear();
+    m_magnitudes.clear();
+    m_keys.reserve(capacity);
+    m_magnitudes.reserve(capacity);
+    m_sorted = true;
+}
+
+void Superblock::CpidIndex::LookupTable::Add(const Cpid& cpid, const uint32_t scaled_magnitude)
+{
+    const LookupKey key(cpid);
+
+    // Defer sorting a CPID that arrives out of order to the next lookup. An
+    // index built from sorted statistics never needs to sort:
+    //
+    if (!m_keys.empty() && !(m_keys.back() < key)) {
+        m_sorted = false;
+    }
+
+    m_keys.push_back(key);
+    m_magnitudes.push_back(scaled_magnitude);
+}
+
+Magnitude Superblock::CpidIndex::LookupTable::Find(const Cpid& cpid) const
+{
+    Sort();
+
+    if (m_keys.empty()) {
+        return Magnitude::Zero();
+    }
+
+    const LookupKey key(cpid);
+    const LookupKey* const keys = m_keys.data();
+    const LookupKey* base = keys;
+    size_t count = m_keys.size();
+
+    // Branch-free lower bound: the number of steps depends only on the size
+    // of the table, and each step selects the next half with a conditional
+    // move instead of a jump that the processor may mispredict.
+    //
+    while (count > 1) {
+        const size_t half = count / 2;
+        base = base[half] < key ? base + half : base;
+        count -= half;
+    }
+
+    const size_t offset = (base - keys) + (*base < key);
+
+    if (offset == m_keys.size() || !(keys[offset] == key)) {
+        return Magnitude::Zero();
+    }
+
+    return Magnitude::FromScaled(m_magnitudes[offset]);
+}
+
+void Superblock::CpidIndex::LookupTable::Sort() const
+{
+    if (m_sorted.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_sort_mutex);
+
+    // Another thread may have sorted the table while this one waited:
+    if (m_sorted.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    std::vector<std::pair<LookupKey, uint32_t>> entries;
+    entries.reserve(m_keys.size());
+
+    for (size_t i = 0; i < m_keys.size(); ++i) {
+        entries.emplace_back(m_keys[i], m_magnitudes[i]);
+    }
+
+    // A stable sort keeps the first of any duplicate CPIDs in the order that
+    // they were added:
+    //
+    std::stable_sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+        m_keys[i] = entries[i].first;
+        m_magnitudes[i] = entries[i].second;
+    }
+
+    m_sorted.store(true, std::memory_order_release);
+}
+
 // -----------------------------------------------------------------------------
 // Class: Superblock::ProjectStats
 // -----------------------------------------------------------------------------
@@ -10,10 +10,13 @@
 #include "serialize.h"
 #include "uint256.h"
 
+#include <atomic>
 #include <optional>
 #include <iterator>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 extern int64_t SCRAPER_CMANIFEST_RETENTION_TIME;
 
@@ -379,11 +382,15 @@ public:
         //! \param cpid      The CPID to add.
         //! \param magnitude Total magnitude to associate with the CPID.
         //!
-        void Add(const Cpid& cpid, const Magnitude magnitude)
+        //! \return The magnitude as stored at the precision of the segment.
+        //!
+        Magnitude Add(const Cpid& cpid, const Magnitude magnitude)
         {
             const uint16_t compact = magnitude.Scaled() / Scale;
 
             m_magnitudes.emplace_back(cpid, compact);
+
+            return Magnitude::FromScaled(compact * Scale);
         }
 
         //!
@@ -872,9 +879,99 @@ public:
             m_large_magnitudes.Unserialize(stream, m_total_magnitude);
 
             VARINT(m_zero_magnitude_count).Unserialize(stream);
+
+            RebuildLookup();
         }
 
     private:
+        //!
+        //! \brief A CPID in the magnitude lookup table.
+        //!
+        //! Stores the bytes of a CPID as two big-endian words. Keys compare in
+        //! the same order as the CPIDs without a loop over the bytes.
+        //!
+        struct LookupKey
+        {
+            uint64_t m_high; //!< First eight bytes of the CPID.
+            uint64_t m_low;  //!< Last eight bytes of the CPID.
+
+            explicit LookupKey(const Cpid& cpid);
+
+            bool operator==(const LookupKey& other) const
+            {
+                return (m_high == other.m_high) & (m_low == other.m_low);
+            }
+
+            bool operator<(const LookupKey& other) const
+            {
+                return (m_high < other.m_high)
+                    | ((m_high == other.m_high) & (m_low < other.m_low));
+            }
+        };
+
+        //!
+        //! \brief Maps the CPIDs of every magnitude segment to magnitudes for
+        //! MagnitudeOf().
+        //!
+        //! The segments partition CPIDs by magnitude size, so a lookup in the
+        //! segments needs up to three searches. This table searches one sorted
+        //! contiguous array of keys instead. The magnitudes live in a parallel
+        //! array so that the keys pack densely for the search.
+        //!
+        //! Adding a CPID appends it to the table. The table sorts itself once
+        //! on the first lookup after a CPID arrives out of order, so building
+        //! an index from unsorted input does not sort the table repeatedly.
+        //!
+        class LookupTable
+        {
+        public:
+            LookupTable();
+
+            //!
+            //! \brief Copy a table. Sorts the source table first so that a
+            //! copy never races a lookup that sorts the source.
+            //!
+            LookupTable(const LookupTable& other);
+            LookupTable& operator=(const LookupTable& other);
+
+            //!
+            //! \brief Remove every CPID from the table.
+            //!
+            //! \param capacity Number of CPIDs to reserve space for.
+            //!
+            void Clear(const size_t capacity = 0);
+
+            //!
+            //! \brief Append a CPID to the table.
+            //!
+            //! When the table contains a CPID more than once, lookups return
+            //! the magnitude added first.
+            //!
+            //! \param cpid             The CPID to add.
+            //! \param scaled_magnitude Magnitude of the CPID at normal scale.
+            //!
+            void Add(const Cpid& cpid, const uint32_t scaled_magnitude);
+
+            //!
+            //! \brief Get the magnitude of the specified CPID.
+            //!
+            //! \return Zero if the table does not contain the CPID.
+            //!
+            Magnitude Find(const Cpid& cpid) const;
+
+        private:
+            mutable std::vector<LookupKey> m_keys;      //!< CPIDs to search.
+            mutable std::vector<uint32_t> m_magnitudes; //!< At key offsets.
+            mutable std::atomic<bool> m_sorted;         //!< Keys are sorted.
+            mutable std::mutex m_sort_mutex;            //!< Serializes Sort().
+
+            //!
+            //! \brief Sort the keys and magnitudes if a CPID was added out of
+            //! order since the last sort.
+            //!
+            void Sort() const;
+        }; // LookupTable
+
         //!
         //! \brief Maps external CPIDs to magnitudes for magnitudes smaller
         //! than 1. These serialize as one byte.
@@ -937,6 +1034,22 @@ public:
         //! collection instead of incrementing the zero-magnitude counter.
         //!
         bool m_legacy;
+
+        //!
+        //! \brief The CPIDs and magnitudes of every magnitude segment.
+        //!
+        //! Not serialized--memory only.
+        //!
+        LookupTable m_lookup;
+
+        //!
+        //! \brief Rebuild the lookup table from the magnitude segments.
+        //!
+        //! When more than one segment contains a CPID, the table keeps the
+        //! magnitude from the first segment in the order of small, medium,
+        //! and large.
+        //!
+        void RebuildLookup();
     }; // CpidIndex
 
     //!
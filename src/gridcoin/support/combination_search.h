@@ -0,0 +1,151 @@
+// Copyright (c) 2014-2021 The Gridcoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include "util/parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <optional>
+#include <vector>
+
+namespace GRC {
+//!
+//! \brief Searches the combinations that select one candidate from each of a
+//! set of groups for a combination that satisfies a predicate.
+//!
+//! The search numbers combinations as a mixed-radix number with the first
+//! group as the most significant place. For example, three groups of sizes
+//! 2, 3, and 2 produce 12 combinations with place values of 6, 2, and 1, and
+//! combination number 9 selects candidates 1, 1, and 1.
+//!
+class CombinationSearch
+{
+public:
+    //!
+    //! \brief Initialize a search over the specified group sizes.
+    //!
+    //! \param group_sizes Number of candidates in each group. A search with an
+    //! empty group or with no groups produces no combinations.
+    //!
+    explicit CombinationSearch(const std::vector<size_t>& group_sizes)
+        : m_place_values(group_sizes.size())
+        , m_total_combinations(group_sizes.empty() ? 0 : 1)
+        , m_saturated(false)
+    {
+        if (std::find(group_sizes.begin(), group_sizes.end(), 0) != group_sizes.end()) {
+            m_total_combinations = 0;
+            return;
+        }
+
+        for (size_t i = group_sizes.size(); i-- > 0;) {
+            m_place_values[i] = m_total_combinations;
+
+            if (m_total_combinations > std::numeric_limits<size_t>::max() / group_sizes[i]) {
+                m_total_combinations = std::numeric_limits<size_t>::max();
+                m_saturated = true;
+                return;
+            }
+
+            m_total_combinations *= group_sizes[i];
+        }
+    }
+
+    //!
+    //! \brief Determine whether the number of combinations exceeds the range
+    //! of \c size_t.
+    //!
+    //! A saturated search cannot number its combinations. It reports the
+    //! maximum \c size_t value as the total and FindFirst() finds nothing.
+    //!
+    bool Saturated() const
+    {
+        return m_saturated;
+    }
+
+    //!
+    //! \brief Get the number of combinations that the search covers.
+    //!
+    size_t TotalCombinations() const
+    {
+        return m_total_combinations;
+    }
+
+    //!
+    //! \brief Get the candidate selected from each group by a combination.
+    //!
+    //! \param combination Number of the combination less than the total.
+    //!
+    //! \return The index of the selected candidate for each group.
+    //!
+    std::vector<size_t> Decode(size_t combination) const
+    {
+        std::vector<size_t> selection(m_place_values.size());
+
+        for (size_t i = 0; i < m_place_values.size(); ++i) {
+            selection[i] = combination / m_place_values[i];
+            combination -= selection[i] * m_place_values[i];
+        }
+
+        return selection;
+    }
+
+    //!
+    //! \brief Find the lowest-numbered combination that satisfies a predicate.
+    //!
+    //! Checks combinations on several threads. The threads claim combinations
+    //! in order and stop claiming them after the first match, so every lower
+    //! numbered combination is already being checked. The lowest match wins,
+    //! so the result does not depend on the number of threads or on their
+    //! scheduling.
+    //!
+    //! \param predicate   Called with the selection for a combination as from
+    //! Decode(). Must be safe to call concurrently.
+    //! \param max_threads Upper bound on the number of threads. Zero selects
+    //! the number of hardware threads.
+    //!
+    //! \return The number of the first matching combination, if any. Always
+    //! empty for a saturated search.
+    //!
+    template <typename Predicate>
+    std::optional<size_t> FindFirst(Predicate&& predicate, const size_t max_threads = 0) const
+    {
+        if (m_saturated) {
+            return std::nullopt;
+        }
+
+        constexpr size_t NONE = std::numeric_limits<size_t>::max();
+        std::atomic<size_t> found { NONE };
+
+        ParallelForUntil(m_total_combinations, [&](const size_t combination) {
+            if (combination > found) {
+                return true;
+            }
+
+            if (!predicate(Decode(combination))) {
+                return false;
+            }
+
+            size_t lowest = found;
+
+            while (combination < lowest && !found.compare_exchange_weak(lowest, combination));
+
+            return true;
+        }, max_threads);
+
+        if (found == NONE) {
+            return std::nullopt;
+        }
+
+        return found.load();
+    }
+
+private:
+    std::vector<size_t> m_place_values; //!< Divisor for each group's place.
+    size_t m_total_combinations;        //!< Product of the group sizes.
+    bool m_saturated;                   //!< Product exceeds the range of size_t.
+}; // CombinationSearch
+} // namespace GRC
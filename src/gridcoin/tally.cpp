@@ -16,6 +16,7 @@
 #include "gridcoin/tally.h"
 #include "util.h"
 
+#include <atomic>
 #include <unordered_map>
 
 using namespace GRC;
@@ -184,7 +185,9 @@ public:
     //! network.
     //!
     //! This scans historical block metadata to create an in-memory database of
-    //! the pending accrual owed to each CPID in the network.
+    //! the pending accrual owed to each CPID in the network. When a checkpoint
+    //! of the research accounts exists on disk, it only scans the blocks above
+    //! the checkpoint.
     //!
     //! \param pindex Index for the first research age block.
     //! \param current_superblock Used to bootstrap snapshot accrual.
@@ -197,6 +200,9 @@ public:
 
         m_start_pindex = pindex;
 
+        ResearchAccountMap checkpoint_accounts;
+        const CBlockIndex* const checkpoint_pindex = TallyCheckpoint::Load(checkpoint_accounts);
+
         for (; pindex; pindex = pindex->pnext) {
             if (pindex->nHeight + 1 == Params().GetConsensus().BlockV11Height) {
                 // Set the timestamp for the block version 11 threshold. This
@@ -208,7 +214,11 @@ public:
 
                 // This will finish loading the research accounting context
                 // for snapshot accrual (block version 11+):
-                return ActivateSnapshotAccrual(pindex, current_superblock);
+                return ActivateSnapshotAccrual(
+                    pindex,
+                    current_superblock,
+                    checkpoint_pindex,
+                    std::move(checkpoint_accounts));
             }
 
             if (pindex->ResearchSubsidy() <= 0) {
@@ -220,7 +230,10 @@ public:
                     RepairZeroCpidIndex(pindex);
                 }
 
-                RecordRewardBlock(*cpid, pindex);
+                // The checkpoint already contains the legacy reward blocks:
+                if (!checkpoint_pindex) {
+                    RecordRewardBlock(*cpid, pindex);
+                }
             }
         }
 
@@ -264,6 +277,14 @@ public:
         return iter->second;
     }
 
+    //!
+    //! \brief Copy the research accounts to publish in a tally snapshot.
+    //!
+    ResearchAccountMap CopyAccounts() const
+    {
+        return m_researchers;
+    }
+
     //!
     //! \brief Record a block's research reward data in the tally.
     //!
@@ -339,10 +360,12 @@ public:
     //! \brief Update the account data with information from a new superblock.
     //!
     //! \param superblock Refers to the current active superblock.
+    //! \param pindex     Index of the block that contains the superblock. When
+    //! not \c nullptr, the tally writes a checkpoint of the research accounts.
     //!
     //! \return \c false if an IO error occurred while processing the superblock.
     //!
-    bool ApplySuperblock(SuperblockPtr superblock)
+    bool ApplySuperblock(SuperblockPtr superblock, const CBlockIndex* const pindex)
     {
         // The network publishes version 2+ superblocks after the mandatory
         // switch to block version 11.
@@ -353,6 +376,17 @@ public:
             if (!m_snapshots.Store(superblock.m_height, m_researchers)) {
                 return false;
             }
+
+            // The node applies the superblock before it records the reward
+            // for the block that contains it, so the accounts reflect every
+            // reward block through the previous block. A checkpoint is only
+            // an optimization for the next startup:
+            //
+            if (pindex && pindex->pprev
+                && !TallyCheckpoint::Store(pindex->pprev, m_researchers))
+            {
+                LogPrintf("WARNING: %s: failed to store tally checkpoint", __func__);
+            }
         }
 
         m_current_superblock = std::move(superblock);
@@ -393,15 +427,20 @@ public:
     //! \brief Switch from legacy research age accrual calculations to the
     //! superblock snapshot accrual system.
     //!
-    //! \param pindex     Index of the block to enable snapshot accrual for.
-    //! \param superblock Refers to the current active superblock.
+    //! \param pindex              Index of the block to enable snapshot accrual for.
+    //! \param superblock          Refers to the current active superblock.
+    //! \param checkpoint_pindex   Last block reflected by the checkpoint accounts,
+    //! or \c nullptr to scan every block above the threshold.
+    //! \param checkpoint_accounts Research accounts loaded from the checkpoint.
     //!
     //! \return \c false if the snapshot system failed to initialize because of
     //! an error.
     //!
     bool ActivateSnapshotAccrual(
         const CBlockIndex* const baseline_pindex,
-        SuperblockPtr superblock)
+        SuperblockPtr superblock,
+        const CBlockIndex* const checkpoint_pindex = nullptr,
+        ResearchAccountMap checkpoint_accounts = { })
     {
         if (!baseline_pindex || !IsV11Enabled(baseline_pindex->nHeight + 1)) {
             return false;
@@ -420,6 +459,13 @@ public:
             // baseline snapshot and scan context for the remaining blocks:
             //
             if (!m_snapshots.HasBaseline()) {
+                // The legacy scan skipped the reward blocks contained in the
+                // checkpoint, so the baseline needs a full rescan:
+                //
+                if (checkpoint_pindex) {
+                    return RebuildAccrualSnapshots();
+                }
+
                 return BuildAccrualSnapshots();
             }
 
@@ -429,11 +475,23 @@ public:
                 m_snapshots.AssertMatch(pindex->nHeight);
             }
 
+            const CBlockIndex* scan_pindex = baseline_pindex;
+
+            if (checkpoint_pindex) {
+                LogPrintf("%s: loaded %" PRIszu " research accounts from checkpoint at %d",
+                    __func__,
+                    checkpoint_accounts.size(),
+                    checkpoint_pindex->nHeight);
+
+                m_researchers = std::move(checkpoint_accounts);
+                scan_pindex = checkpoint_pindex->pnext;
+            }
+
             // Finish loading the research account context for the remaining
-            // blocks after the snapshot accrual threshold. Verify snapshots
-            // along the way:
+            // blocks after the snapshot accrual threshold or the checkpoint.
+            // Verify snapshots along the way:
             //
-            for (const CBlockIndex* pindex = baseline_pindex;
+            for (const CBlockIndex* pindex = scan_pindex;
                 pindex;
                 pindex = pindex->pnext)
             {
@@ -741,7 +799,7 @@ private:
             pindex = pindex->pnext)
         {
             if (pindex->IsSuperblock()) {
-                if (!ApplySuperblock(SuperblockPtr::ReadFromDisk(pindex))) {
+                if (!ApplySuperblock(SuperblockPtr::ReadFromDisk(pindex), nullptr)) {
                     return false;
                 }
             }
@@ -802,8 +860,224 @@ public:
 ResearcherTally g_researcher_tally; //!< Tracks lifetime research rewards.
 NetworkTally g_network_tally;       //!< Tracks legacy two-week network averages.
 
+//!
+//! \brief The latest tally snapshot published for readers that do not lock
+//! cs_main.
+//!
+//! THREAD SAFETY: Access only with std::atomic_load() and std::atomic_store().
+//!
+TallySnapshotPtr g_tally_snapshot = std::make_shared<const TallySnapshot>();
+
+//!
+//! \brief Time in milliseconds of the last tally snapshot publication.
+//!
+std::atomic<int64_t> g_tally_snapshot_time { 0 };
+
 } // Anonymous namespace
 
+// -----------------------------------------------------------------------------
+// Class: TallySnapshot
+// -----------------------------------------------------------------------------
+
+const ResearchAccount& TallySnapshot::GetAccount(const Cpid cpid) const
+{
+    static const ResearchAccount new_account;
+
+    const auto iter = m_accounts.find(cpid);
+
+    if (iter == m_accounts.end()) {
+        return new_account;
+    }
+
+    return iter->second;
+}
+
+AccrualComputer TallySnapshot::GetComputer(const Cpid cpid, const int64_t payment_time) const
+{
+    if (!m_pindex || m_pindex->nVersion < 11) {
+        return std::make_unique<NullAccrualComputer>();
+    }
+
+    return Tally::GetSnapshotComputer(
+        cpid,
+        GetAccount(cpid),
+        payment_time,
+        m_pindex,
+        m_superblock);
+}
+
+CAmount TallySnapshot::GetAccrual(const Cpid cpid, const int64_t payment_time) const
+{
+    return GetComputer(cpid, payment_time)->Accrual();
+}
+
+// -----------------------------------------------------------------------------
+// Class: TallyCheckpoint
+// -----------------------------------------------------------------------------
+
+constexpr uint32_t TallyCheckpoint::CURRENT_VERSION; // for clang
+
+bool TallyCheckpoint::Store(const CBlockIndex* const pindex, const ResearchAccountMap& accounts)
+{
+    const fs::path path = TallyCheckpointPath();
+    const fs::path tmp_path = path.string() + ".new";
+
+    CAutoHasherFile file(fsbridge::fopen(tmp_path, "wb"), SER_DISK, CURRENT_VERSION);
+
+    if (file.IsNull()) {
+        return error("%s: failed to open %s", __func__, tmp_path.string());
+    }
+
+    uint64_t count = 0;
+
+    for (const auto& account_pair : accounts) {
+        if (account_pair.second.m_first_block_ptr != nullptr) {
+            ++count;
+        }
+    }
+
+    try {
+        file << CURRENT_VERSION;
+        file << pindex->GetBlockHash();
+        file << pindex->nHeight;
+        WriteCompactSize(file, count);
+
+        for (const auto& account_pair : accounts) {
+            const ResearchAccount& account = account_pair.second;
+
+            if (account.m_first_block_ptr == nullptr) {
+                continue;
+            }
+
+            file << account_pair.first;
+            file << account.m_total_research_subsidy;
+            file << account.m_total_magnitude;
+            file << account.m_accuracy;
+            file << account.m_first_block_ptr->GetBlockHash();
+            file << account.m_last_block_ptr->GetBlockHash();
+        }
+
+        const uint256 hash = file.GetHash();
+        static_cast<CAutoFile&>(file) << hash;
+    } catch (const std::exception& e) {
+        return error("%s: %s", __func__, e.what());
+    }
+
+    if (!FileCommit(file.Get())) {
+        return error("%s: failed to flush %s", __func__, tmp_path.string());
+    }
+
+    file.fclose();
+
+    if (!RenameOver(tmp_path, path)) {
+        return error("%s: failed to replace %s", __func__, path.string());
+    }
+
+    LogPrint(LogFlags::TALLY,
+        "TallyCheckpoint: stored %" PRIu64 " accounts through %d",
+        count,
+        pindex->nHeight);
+
+    return true;
+}
+
+const CBlockIndex* TallyCheckpoint::Load(ResearchAccountMap& accounts)
+{
+    const fs::path path = TallyCheckpointPath();
+
+    if (!fs::exists(path)) {
+        return nullptr;
+    }
+
+    CAutoHasherFile file(fsbridge::fopen(path, "rb"), SER_DISK, CURRENT_VERSION);
+
+    if (file.IsNull()) {
+        error("%s: failed to open %s", __func__, path.string());
+        return nullptr;
+    }
+
+    ResearchAccountMap loaded;
+    const CBlockIndex* pindex = nullptr;
+
+    try {
+        uint32_t version;
+        file >> version;
+
+        if (version != CURRENT_VERSION) {
+            LogPrintf("%s: ignoring checkpoint version %u", __func__, version);
+            return nullptr;
+        }
+
+        uint256 block_hash;
+        int height;
+        file >> block_hash;
+        file >> height;
+
+        pindex = FindMainChainBlock(block_hash);
+
+        if (!pindex || pindex->nHeight != height) {
+            LogPrintf("%s: checkpoint block %d is not in the main chain", __func__, height);
+            return nullptr;
+        }
+
+        const uint64_t count = ReadCompactSize(file);
+
+        for (uint64_t i = 0; i < count; ++i) {
+            Cpid cpid;
+            file >> cpid;
+
+            ResearchAccount& account = loaded[cpid];
+
+            file >> account.m_total_research_subsidy;
+            file >> account.m_total_magnitude;
+            file >> account.m_accuracy;
+
+            file >> block_hash;
+            account.m_first_block_ptr = FindMainChainBlock(block_hash);
+
+            file >> block_hash;
+            account.m_last_block_ptr = FindMainChainBlock(block_hash);
+
+            if (!account.m_first_block_ptr
+                || !account.m_last_block_ptr
+                || account.m_last_block_ptr->nHeight > pindex->nHeight)
+            {
+                LogPrintf("%s: checkpoint reward block for %s is not in the main chain",
+                    __func__,
+                    cpid.ToString());
+
+                return nullptr;
+            }
+        }
+
+        const uint256 expected_hash = file.GetHash();
+        uint256 stored_hash;
+        static_cast<CAutoFile&>(file) >> stored_hash;
+
+        if (stored_hash != expected_hash) {
+            error("%s: checkpoint hash mismatch", __func__);
+            return nullptr;
+        }
+    } catch (const std::exception& e) {
+        error("%s: %s", __func__, e.what());
+        return nullptr;
+    }
+
+    accounts = std::move(loaded);
+
+    return pindex;
+}
+
+const CBlockIndex* TallyCheckpoint::FindMainChainBlock(const uint256& block_hash)
+{
+    const auto iter = mapBlockIndex.find(block_hash);
+
+    if (iter == mapBlockIndex.end() || !iter->second->IsInMainChain()) {
+        return nullptr;
+    }
+
+    return iter->second;
+}
 // -----------------------------------------------------------------------------
 // Class: Tally
 // -----------------------------------------------------------------------------
@@ -843,6 +1117,8 @@ bool Tally::Initialize(CBlockIndex* pindex)
         "Tally initialization complete. Scan time %15" PRId64 "ms\n",
         GetTimeMillis() - start_time);
 
+    PublishSnapshot(pindexBest);
+
     return true;
 }
 
@@ -910,6 +1186,34 @@ const ResearchAccount& Tally::GetAccount(const Cpid cpid)
     return g_researcher_tally.GetAccount(cpid);
 }
 
+TallySnapshotPtr Tally::CurrentSnapshot()
+{
+    return std::atomic_load(&g_tally_snapshot);
+}
+
+void Tally::PublishSnapshot(const CBlockIndex* const pindex, const bool throttle)
+{
+    // Copying the accounts for every block slows down the initial sync. Only
+    // refresh the snapshot periodically until the node catches up:
+    //
+    constexpr int64_t THROTTLE_INTERVAL_MS = 5000;
+
+    const int64_t now = GetTimeMillis();
+
+    if (throttle && now - g_tally_snapshot_time < THROTTLE_INTERVAL_MS) {
+        return;
+    }
+
+    auto snapshot = std::make_shared<TallySnapshot>();
+
+    snapshot->m_accounts = g_researcher_tally.CopyAccounts();
+    snapshot->m_superblock = Quorum::CurrentSuperblock();
+    snapshot->m_pindex = pindex;
+
+    std::atomic_store(&g_tally_snapshot, TallySnapshotPtr(std::move(snapshot)));
+    g_tally_snapshot_time = now;
+}
+
 CAmount Tally::GetAccrual(
     const Cpid cpid,
     const int64_t payment_time,
@@ -925,6 +1229,14 @@ CAmount Tally::GetAccrual(
 //! \param superblock that is the high point of the accrual correction
 //!
 CAmount Tally::GetNewbieSuperblockAccrualCorrection(const Cpid& cpid, const SuperblockPtr& current_superblock)
+{
+    return GetNewbieSuperblockAccrualCorrection(cpid, current_superblock, SuperblockPtr::ReadFromDisk);
+}
+
+CAmount Tally::GetNewbieSuperblockAccrualCorrection(
+    const Cpid& cpid,
+    const SuperblockPtr& current_superblock,
+    const SuperblockLoader& load_superblock)
 {
     // This function was moved from the anonymous namespace and private, to public and made static, because it has
     // to be called from ClaimValidator::CheckResearchReward() directly too. Why?
@@ -1079,7 +1391,7 @@ CAmount Tally::GetNewbieSuperblockAccrualCorrection(const Cpid& cpid, const Supe
     {
         if (pindex->IsSuperblock())
         {
-            superblock = SuperblockPtr::ReadFromDisk(pindex);
+            superblock = load_superblock(pindex);
 
             const GRC::Magnitude magnitude = superblock->m_cpids.MagnitudeOf(cpid);
 
@@ -1204,9 +1516,9 @@ void Tally::ForgetRewardBlock(const CBlockIndex* const pindex)
     }
 }
 
-bool Tally::ApplySuperblock(SuperblockPtr superblock)
+bool Tally::ApplySuperblock(SuperblockPtr superblock, const CBlockIndex* const pindex)
 {
-    return g_researcher_tally.ApplySuperblock(std::move(superblock));
+    return g_researcher_tally.ApplySuperblock(std::move(superblock), pindex);
 }
 
 bool Tally::RevertSuperblock()
@@ -7,13 +7,133 @@
 #include "amount.h"
 #include "gridcoin/account.h"
 #include "gridcoin/accrual/computer.h"
+#include "gridcoin/superblock.h"
+
+#include <functional>
+#include <memory>
 
 class CBlockIndex;
 
 namespace GRC {
 
-class Cpid;
-class SuperblockPtr;
+//!
+//! \brief An immutable copy of the research accounts and the current superblock
+//! as of a chain tip.
+//!
+//! The tally publishes a new snapshot when the chain tip changes. Readers like
+//! RPC commands and the GUI take a reference to the latest snapshot without a
+//! lock on cs_main. Published snapshots never change, so a reader may hold one
+//! as long as it needs while the node connects blocks.
+//!
+class TallySnapshot
+{
+public:
+    ResearchAccountMap m_accounts;   //!< Research accounts as of the tip.
+    SuperblockPtr m_superblock;      //!< Active superblock as of the tip.
+    const CBlockIndex* m_pindex;     //!< Chain tip of the snapshot.
+
+    //!
+    //! \brief Initialize an empty snapshot for a node without a chain tip.
+    //!
+    TallySnapshot() : m_pindex(nullptr)
+    {
+    }
+
+    //!
+    //! \brief Get the research account for the specified CPID.
+    //!
+    //! \param cpid The CPID of the account to fetch.
+    //!
+    //! \return An account that matches the CPID or a blank account if no
+    //! research reward data exists for the CPID.
+    //!
+    const ResearchAccount& GetAccount(const Cpid cpid) const;
+
+    //!
+    //! \brief Get an accrual calculator for the specified CPID as of the tip
+    //! of the snapshot.
+    //!
+    //! Snapshots only support the snapshot accrual rules of block version 11+.
+    //! For an earlier tip, this returns a calculator that reports no accrual.
+    //!
+    //! THREAD SAFETY: The calculator refers to an account in this snapshot, so
+    //! keep a reference to the snapshot while using it. The accrual age of a
+    //! CPID that never staked a block depends on the beacon registry, so lock
+    //! cs_main before asking for the accrual age of a new account.
+    //!
+    //! \param cpid         CPID to calculate research accrual for.
+    //! \param payment_time Time of payment to calculate rewards at.
+    //!
+    //! \return An accrual calculator initialized with the supplied parameters.
+    //!
+    AccrualComputer GetComputer(const Cpid cpid, const int64_t payment_time) const;
+
+    //!
+    //! \brief Calculate the research reward accrual for the specified CPID as
+    //! of the tip of the snapshot.
+    //!
+    //! \param cpid         CPID to calculate research accrual for.
+    //! \param payment_time Time of payment to calculate rewards at.
+    //!
+    //! \return Research reward accrual in units of 1/100000000 GRC.
+    //!
+    CAmount GetAccrual(const Cpid cpid, const int64_t payment_time) const;
+}; // TallySnapshot
+
+//!
+//! \brief A shared reference to a published tally snapshot.
+//!
+typedef std::shared_ptr<const TallySnapshot> TallySnapshotPtr;
+
+//!
+//! \brief Stores the reward block data of the research accounts to disk so
+//! that the tally can skip the chain scan below it at startup.
+//!
+//! The node writes a checkpoint at each superblock. A checkpoint records the
+//! block that the research accounts reflect every reward block through, and
+//! for each account with reward blocks, the totals and the hashes of the first
+//! and last reward blocks. A hash of the contents follows as a trailer.
+//!
+//! Checkpoints do not contain accrual. The snapshot repository restores the
+//! accrual of the accounts from the latest accrual snapshot.
+//!
+class TallyCheckpoint
+{
+public:
+    //!
+    //! \brief Version number of the current checkpoint file format.
+    //!
+    static constexpr uint32_t CURRENT_VERSION = 1;
+
+    //!
+    //! \brief Write a checkpoint of the research accounts to disk.
+    //!
+    //! \param pindex   The last block that the accounts reflect.
+    //! \param accounts The research accounts to store.
+    //!
+    //! \return \c false if an IO error occurred.
+    //!
+    static bool Store(const CBlockIndex* const pindex, const ResearchAccountMap& accounts);
+
+    //!
+    //! \brief Load the research accounts from the checkpoint on disk.
+    //!
+    //! \param accounts Receives the research accounts. Unchanged on failure.
+    //!
+    //! \return The last block that the loaded accounts reflect, or \c nullptr
+    //! if no checkpoint exists or if it does not match the hash in the file or
+    //! the main chain.
+    //!
+    static const CBlockIndex* Load(ResearchAccountMap& accounts);
+
+private:
+    //!
+    //! \brief Look up the index entry of a block in the main chain.
+    //!
+    //! \return \c nullptr if the block does not exist in the main chain.
+    //!
+    static const CBlockIndex* FindMainChainBlock(const uint256& block_hash);
+}; // TallyCheckpoint
 
 //!
 //! \brief The core Gridcoin tally system that processes magnitudes and reward
@@ -24,7 +144,8 @@ class SuperblockPtr;
 //! build a database of research reward context for each CPID in the network.
 //!
 //! THREAD SAFETY: This tally system interacts closely with pointers to blocks
-//! in the chain index. Always lock cs_main before calling its methods.
+//! in the chain index. Always lock cs_main before calling its methods, except
+//! for CurrentSnapshot().
 //!
 class Tally
 {
@@ -118,6 +239,27 @@ public:
     //!
     static const ResearchAccount& GetAccount(const Cpid cpid);
 
+    //!
+    //! \brief Get the latest published snapshot of the research accounts and
+    //! the current superblock.
+    //!
+    //! THREAD SAFETY: Does not require a lock on cs_main.
+    //!
+    //! \return The snapshot published for the latest chain tip.
+    //!
+    static TallySnapshotPtr CurrentSnapshot();
+
+    //!
+    //! \brief Publish a snapshot of the research accounts and the current
+    //! superblock for readers that do not lock cs_main.
+    //!
+    //! \param pindex   The current chain tip.
+    //! \param throttle If \c true, skip publication when the tally published a
+    //! snapshot in the last few seconds. Set this during the initial block
+    //! download to avoid copying the accounts for every block.
+    //!
+    static void PublishSnapshot(const CBlockIndex* const pindex, const bool throttle = false);
+
     //!
     //! \brief Calculate the research reward accrual for the specified CPID.
     //!
@@ -132,6 +274,11 @@ public:
         const int64_t payment_time,
         const CBlockIndex* const last_block_ptr);
 
+    //!
+    //! \brief Reads the superblock contained in a block.
+    //!
+    using SuperblockLoader = std::function<SuperblockPtr(const CBlockIndex* const)>;
+
     //!
     //! \brief Compute "catch-up" accrual to correct for newbie accrual bug.
     //!
@@ -139,6 +286,20 @@ public:
     //!
     static CAmount GetNewbieSuperblockAccrualCorrection(const Cpid& cpid, const SuperblockPtr& current_superblock);
 
+    //!
+    //! \brief Compute "catch-up" accrual to correct for newbie accrual bug.
+    //!
+    //! \param cpid               for which to calculate the accrual correction.
+    //! \param current_superblock The high point of the accrual correction.
+    //! \param load_superblock    Reads the superblocks in scope of the accrual.
+    //! Callers that already hold the superblocks can avoid reading each one
+    //! from disk again.
+    //!
+    static CAmount GetNewbieSuperblockAccrualCorrection(
+        const Cpid& cpid,
+        const SuperblockPtr& current_superblock,
+        const SuperblockLoader& load_superblock);
+
     //!
     //! \brief Get an initialized research reward accrual calculator.
     //!
@@ -232,10 +393,13 @@ public:
     //! \brief Update the account data with information from a new superblock.
     //!
     //! \param superblock Refers to the current active superblock.
+    //! \param pindex     Index of the block that contains the superblock. The
+    //! tally checkpoints the research accounts at this block to speed up the
+    //! next startup.
     //!
     //! \return \c false if an IO error occurred while processing the superblock.
     //!
-    static bool ApplySuperblock(SuperblockPtr superblock);
+    static bool ApplySuperblock(SuperblockPtr superblock, const CBlockIndex* const pindex);
 
     //!
     //! \brief Reset the account data to a state before the provided superblock.
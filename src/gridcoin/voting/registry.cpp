@@ -307,6 +307,7 @@ int64_t PollReference::Expiration() const
 void PollReference::LinkVote(const uint256 txid)
 {
     m_votes.emplace_back(txid);
+    m_result_cache.reset();
 }
 
 void PollReference::UnlinkVote(const uint256 txid)
@@ -314,6 +315,7 @@ void PollReference::UnlinkVote(const uint256 txid)
     for (auto it = m_votes.crbegin(), end = m_votes.crend(); it != end; ++it) {
         if (*it == txid) {
             m_votes.erase(std::next(it).base());
+            m_result_cache.reset();
             return;
         }
     }
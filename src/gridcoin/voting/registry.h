@@ -7,10 +7,13 @@
 #include "gridcoin/contract/handler.h"
 #include "gridcoin/voting/fwd.h"
 
+#include <memory>
+
 class CTxDB;
 
 namespace GRC {
 
+class CachedPollResult;
 class Contract;
 class PollRegistry;
 
@@ -27,6 +30,7 @@ class PollRegistry;
 class PollReference
 {
     friend class PollRegistry;
+    friend class PollResult;
 
 public:
     //!
@@ -111,6 +115,15 @@ private:
     int64_t m_timestamp;          //!< Timestamp of the poll transaction.
     uint32_t m_duration_days;     //!< Number of days the poll remains active.
     std::vector<uint256> m_votes; //!< Hashes of the linked vote transactions.
+
+    //!
+    //! \brief The result last tallied for the poll.
+    //!
+    //! PollResult::BuildFor() stores the tally here and reuses it while the
+    //! chain context that it depends on stays the same. Linking or unlinking
+    //! a vote discards it.
+    //!
+    mutable std::shared_ptr<const CachedPollResult> m_result_cache;
 }; // PollReference
 
 //!
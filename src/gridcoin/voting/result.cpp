@@ -11,10 +11,13 @@
 #include "gridcoin/voting/poll.h"
 #include "gridcoin/voting/vote.h"
 #include "txdb.h"
+#include "util/parallel.h"
 #include "util/reverse_iterator.h"
 
+#include <algorithm>
 #include <optional>
 #include <queue>
+#include <tuple>
 #include <unordered_set>
 
 using namespace GRC;
@@ -111,7 +114,7 @@ public:
 
 private:
     const CTransaction m_tx;         //!< Transaction that contains a vote.
-    const Contract& m_contract;      //!< The vote contract.
+    const Contract m_contract;       //!< The vote contract.
     const ContractPayload m_payload; //!< Contains the body of the vote.
 }; // VoteCandidate
 
@@ -144,6 +147,55 @@ public:
         m_superblock = std::move(superblock);
     }
 
+    //!
+    //! \brief Load the outputs claimed by the supplied votes and verify the
+    //! signatures of their address claims before resolving the votes.
+    //!
+    //! Resolving the votes one by one reads each claimed transaction from a
+    //! random position in the block files and checks each signature in turn.
+    //! This instead reads the transactions of every vote in the order of the
+    //! disk positions and verifies the signatures on worker threads. Resolve()
+    //! consumes the results in the original vote order, so duplicate claims
+    //! filter the same way.
+    //!
+    //! \param candidates Non-legacy votes that the resolver will resolve.
+    //!
+    void Prefetch(const std::vector<const VoteCandidate*>& candidates)
+    {
+        std::vector<ClaimMessage> messages;
+        std::vector<std::pair<const AddressClaim*, const ClaimMessage*>> claims;
+        std::set<uint256> txids;
+
+        messages.reserve(candidates.size());
+
+        for (const auto& candidate : candidates) {
+            messages.emplace_back(candidate->PackMessage());
+
+            const BalanceClaim& claim = candidate->Vote().m_claim.m_balance_claim;
+
+            for (const auto& address_claim : claim.m_address_claims) {
+                claims.emplace_back(&address_claim, &messages.back());
+
+                for (const auto& txo : address_claim.m_outpoints) {
+                    txids.emplace(txo.hash);
+                }
+            }
+        }
+
+        LoadTransactions(txids);
+
+        // std::vector<bool> packs bits and cannot be written concurrently:
+        std::vector<uint8_t> valid(claims.size(), false);
+
+        ParallelFor(claims.size(), [&](const size_t i) {
+            valid[i] = claims[i].first->VerifySignature(*claims[i].second);
+        });
+
+        for (size_t i = 0; i < claims.size(); ++i) {
+            m_verified_claims.emplace(claims[i].first, valid[i]);
+        }
+    }
+
     //!
     //! \brief Resolve the voting weight for the provided vote.
     //!
@@ -185,6 +237,136 @@ private:
     //!
     std::unordered_set<Cpid> m_seen_cpids;
 
+    //!
+    //! \brief A claimed transaction and the context of the block that
+    //! contains it loaded from disk.
+    //!
+    struct ResolvedTx
+    {
+        bool m_indexed = false;       //!< Whether the tx index entry exists.
+        bool m_loaded = false;        //!< Whether the tx was read from disk.
+        int64_t m_block_time = 0;     //!< Timestamp of the containing block.
+        bool m_in_main_chain = false; //!< Whether the block is in the main chain.
+        CTxIndex m_tx_index;          //!< Disk position and spent outputs.
+        CTransaction m_tx;            //!< The claimed transaction.
+    };
+
+    //!
+    //! \brief Claimed transactions loaded for the poll keyed by hash.
+    //!
+    std::map<uint256, ResolvedTx> m_txs;
+
+    //!
+    //! \brief Results of the address claim signatures verified in advance.
+    //!
+    std::map<const AddressClaim*, bool> m_verified_claims;
+
+    //!
+    //! \brief Read the specified transactions from disk in the order of their
+    //! positions in the block files.
+    //!
+    //! \param txids Hashes of the transactions to load.
+    //!
+    void LoadTransactions(const std::set<uint256>& txids)
+    {
+        std::vector<std::pair<CDiskTxPos, ResolvedTx*>> positions;
+        positions.reserve(txids.size());
+
+        for (const auto& txid : txids) {
+            ResolvedTx& resolved = m_txs[txid];
+
+            if (resolved.m_indexed) {
+                continue;
+            }
+
+            if (!m_txdb.ReadTxIndex(txid, resolved.m_tx_index)) {
+                continue;
+            }
+
+            resolved.m_indexed = true;
+            positions.emplace_back(resolved.m_tx_index.pos, &resolved);
+        }
+
+        std::sort(positions.begin(), positions.end(), [](const auto& a, const auto& b) {
+            return std::tie(a.first.nFile, a.first.nBlockPos, a.first.nTxPos)
+                < std::tie(b.first.nFile, b.first.nBlockPos, b.first.nTxPos);
+        });
+
+        for (auto iter = positions.begin(); iter != positions.end();) {
+            const unsigned int file_number = iter->first.nFile;
+            CAutoFile file(::OpenBlockFile(file_number, 0, "rb"), SER_DISK, CLIENT_VERSION);
+
+            if (file.IsNull()) {
+                error("%s: OpenBlockFile failed", __func__);
+            }
+
+            for (; iter != positions.end() && iter->first.nFile == file_number; ++iter) {
+                if (!file.IsNull()) {
+                    LoadTransaction(file, iter->first, *iter->second);
+                }
+            }
+        }
+    }
+
+    //!
+    //! \brief Read a transaction and the header of its block from a block file.
+    //!
+    //! \param file     Open block file that contains the transaction.
+    //! \param pos      Location of the transaction in the file.
+    //! \param resolved Receives the transaction and block context.
+    //!
+    static void LoadTransaction(CAutoFile& file, const CDiskTxPos& pos, ResolvedTx& resolved)
+    {
+        CBlockHeader header;
+
+        if (fseek(file.Get(), pos.nBlockPos, SEEK_SET) != 0) {
+            error("%s: block fseek failed", __func__);
+            return;
+        }
+
+        try {
+            file >> header;
+        } catch (...) {
+            error("%s: deserialize or I/O error for block header", __func__);
+            return;
+        }
+
+        if (fseek(file.Get(), pos.nTxPos, SEEK_SET) != 0) {
+            error("%s: tx fseek failed", __func__);
+            return;
+        }
+
+        try {
+            file >> resolved.m_tx;
+        } catch (...) {
+            error("%s: deserialize or I/O error for tx", __func__);
+            return;
+        }
+
+        resolved.m_block_time = header.nTime;
+        resolved.m_in_main_chain = IsInMainChain(header);
+        resolved.m_loaded = true;
+    }
+
+    //!
+    //! \brief Get a claimed transaction, loading it from disk if the resolver
+    //! did not prefetch it.
+    //!
+    //! \param txid Hash of the transaction to get.
+    //!
+    const ResolvedTx& FetchTransaction(const uint256& txid)
+    {
+        const auto iter = m_txs.find(txid);
+
+        if (iter != m_txs.end()) {
+            return iter->second;
+        }
+
+        LoadTransactions({ txid });
+
+        return m_txs[txid];
+    }
+
     //!
     //! \brief Resolve the claimed magnitude for a vote.
     //!
@@ -308,7 +490,13 @@ private:
     //!
     CAmount Resolve(const AddressClaim& claim, const ClaimMessage& message)
     {
-        if (!claim.VerifySignature(message)) {
+        const auto verified = m_verified_claims.find(&claim);
+
+        const bool valid = verified != m_verified_claims.end()
+            ? verified->second
+            : claim.VerifySignature(message);
+
+        if (!valid) {
             LogPrint(LogFlags::VOTE, "%s: bad address signature", __func__);
             throw InvalidVoteError();
         }
@@ -341,52 +529,29 @@ private:
             return 0;
         }
 
-        CTxIndex tx_index;
+        const ResolvedTx& resolved = FetchTransaction(txo.hash);
 
-        if (!m_txdb.ReadTxIndex(txo.hash, tx_index)) {
+        if (!resolved.m_indexed) {
             LogPrint(LogFlags::VOTE, "%s: failed to read tx index", __func__);
             return 0;
         }
 
-        CAutoFile file(OpenBlockFile(tx_index.pos), SER_DISK, CLIENT_VERSION);
-
-        if (file.IsNull()) {
-            error("%s: OpenBlockFile failed", __func__);
-            throw InvalidVoteError();
-        }
-
-        CBlockHeader header;
-
-        try {
-            file >> header;
-        } catch (...) {
-            error("%s: deserialize or I/O error for block header", __func__);
-            throw InvalidVoteError();
+        if (!resolved.m_loaded) {
+            throw InvalidVoteError(); // Logged when loading the tx
         }
 
-        if (m_poll.Expired(header.nTime)) {
+        if (m_poll.Expired(resolved.m_block_time)) {
             LogPrint(LogFlags::VOTE, "%s: txo confirmed after poll", __func__);
             throw InvalidVoteError();
         }
 
-        if (!IsInMainChain(header)) {
+        if (!resolved.m_in_main_chain) {
             LogPrint(LogFlags::VOTE, "%s: txo not in main chain", __func__);
             return 0;
         }
 
-        if (fseek(file.Get(), tx_index.pos.nTxPos, SEEK_SET) != 0) {
-            error("%s: tx fseek failed", __func__);
-            throw InvalidVoteError();
-        }
-
-        CTransaction tx;
-
-        try {
-            file >> tx;
-        } catch (...) {
-            error("%s: deserialize or I/O error for tx", __func__);
-            throw InvalidVoteError();
-        }
+        const CTransaction& tx = resolved.m_tx;
+        const CTxIndex& tx_index = resolved.m_tx_index;
 
         if (txo.n >= tx.vout.size()) {
             LogPrint(LogFlags::VOTE, "%s: txo out of range", __func__);
@@ -774,13 +939,43 @@ public:
     {
         m_votes.reserve(vote_txids.size());
 
+        // Load every vote first so that the resolver can batch the disk reads
+        // and signature checks for the claims. Votes then resolve in reverse
+        // order as before so that the newest vote wins a duplicate claim:
+        //
+        std::vector<std::pair<uint256, std::optional<VoteCandidate>>> candidates;
+        std::vector<const VoteCandidate*> prefetch;
+
+        candidates.reserve(vote_txids.size());
+        prefetch.reserve(vote_txids.size());
+
         for (const auto& txid : reverse_iterate(vote_txids)) {
+            candidates.emplace_back(txid, std::nullopt);
+
             try {
-                ProcessVoteCandidate(FetchVoteCandidate(txid));
+                candidates.back().second.emplace(FetchVoteCandidate(txid));
+            } catch (const InvalidVoteError& e) {
+                continue;
+            }
+
+            if (!candidates.back().second->IsLegacy()) {
+                prefetch.emplace_back(&*candidates.back().second);
+            }
+        }
+
+        m_resolver.Prefetch(prefetch);
+
+        for (const auto& candidate : candidates) {
+            try {
+                if (!candidate.second) {
+                    throw InvalidVoteError();
+                }
+
+                ProcessVoteCandidate(*candidate.second);
             } catch (const InvalidVoteError& e) {
                 LogPrint(LogFlags::VOTE, "%s: skipped invalid vote: %s",
                     __func__,
-                    txid.ToString());
+                    candidate.first.ToString());
 
                 ++result.m_invalid_votes;
             }
@@ -791,6 +986,17 @@ public:
         }
     }
 
+    //!
+    //! \brief Determine whether the counter tallied any legacy votes.
+    //!
+    //! The weight of legacy votes depends on the current chain tip rather
+    //! than on the poll window. See LegacyVoteCounterContext.
+    //!
+    bool CountedLegacyVotes() const
+    {
+        return m_counted_legacy;
+    }
+
 private:
     CTxDB& m_txdb;
     const Poll& m_poll;
@@ -798,6 +1004,7 @@ private:
     Weight m_magnitude_factor;
     VoteResolver m_resolver;
     LegacyVoteCounterContext m_legacy;
+    bool m_counted_legacy = false;
 
     //!
     //! \brief Read a vote contract from disk for the specified transaction.
@@ -929,6 +1136,7 @@ private:
 
         m_votes.emplace_back(std::move(detail));
         m_legacy.RememberKey(vote.m_key);
+        m_counted_legacy = true;
     }
 
     //!
@@ -999,22 +1207,90 @@ SuperblockPtr ResolveSuperblockForPoll(const Poll& poll)
         return superblock;
     }
 
-    const CBlockIndex* pindex = pindexBest;
+    // Find the superblock active at the end of the poll:
+    if (const CBlockIndex* const pindex = Quorum::FindSuperblockAt(poll.Expiration())) {
+        superblock = SuperblockPtr::ReadFromDisk(pindex);
+    }
 
-    // Seek past the current superblock:
-    for (; pindex && pindex->nHeight >= superblock.m_height; pindex = pindex->pprev);
+    return superblock;
+}
 
-    // Find the superblock active at the end of the poll:
-    for (; pindex; pindex = pindex->pprev) {
-        if (!pindex->IsSuperblock() || poll.Expired(pindex->nTime)) {
-            continue;
+//!
+//! \brief Find the last block in the main chain within the specified poll's
+//! window.
+//!
+//! \param poll Poll to find the block for.
+//!
+//! \return The last block with a timestamp at or before the poll expiration.
+//!
+const CBlockIndex* ResolveLastBlockForPoll(const Poll& poll)
+{
+    const CBlockIndex* pindex = pindexBest;
+    const int64_t poll_expiration = poll.Expiration();
+
+    // Start from the last superblock in the poll window instead of the tip
+    // and scan forward to the first block with a median time past beyond the
+    // expiration. Every block after that one has a later timestamp than the
+    // median, so it cannot fall inside the window:
+    //
+    if (const CBlockIndex* const pindex_superblock = Quorum::FindSuperblockAt(poll_expiration)) {
+        pindex = pindex_superblock;
+
+        while (pindex->pnext
+            && (pindex->GetBlockTime() <= poll_expiration
+                || pindex->GetMedianTimePast() <= poll_expiration))
+        {
+            pindex = pindex->pnext;
         }
+    }
 
-        superblock = SuperblockPtr::ReadFromDisk(pindex);
-        break;
+    for (; pindex && pindex->nTime > poll_expiration; pindex = pindex->pprev);
+
+    return pindex;
+}
+
+//!
+//! \brief Find the block in the main chain that closes the specified poll's
+//! window.
+//!
+//! A block must have a timestamp later than the median time past of its
+//! parent, and the median time past never decreases along a chain. So every
+//! block after the first one with a median time past beyond the expiration
+//! falls outside the poll window. While this block stays in the main chain, no
+//! reorganization can add a block to the window.
+//!
+//! \param poll Poll to find the block for.
+//!
+//! \return The first block with a median time past later than the poll
+//! expiration, or \c nullptr if the poll window is still open.
+//!
+const CBlockIndex* ResolveClosingBlockForPoll(const Poll& poll)
+{
+    const int64_t poll_expiration = poll.Expiration();
+
+    if (!pindexBest || pindexBest->GetMedianTimePast() <= poll_expiration) {
+        return nullptr;
     }
 
-    return superblock;
+    // Start from the last superblock in the poll window instead of the tip
+    // when one exists. Its median time past may already exceed the expiration
+    // if the block timestamps around it are out of order, so step back first:
+    //
+    const CBlockIndex* pindex = Quorum::FindSuperblockAt(poll_expiration);
+
+    if (!pindex) {
+        pindex = pindexBest;
+    }
+
+    while (pindex->pprev && pindex->pprev->GetMedianTimePast() > poll_expiration) {
+        pindex = pindex->pprev;
+    }
+
+    while (pindex->pnext && pindex->GetMedianTimePast() <= poll_expiration) {
+        pindex = pindex->pnext;
+    }
+
+    return pindex;
 }
 
 //!
@@ -1032,12 +1308,7 @@ CAmount ResolveMoneySupplyForPoll(const Poll& poll)
         return pindexBest->nMoneySupply;
     }
 
-    const CBlockIndex* pindex = pindexBest;
-    const int64_t poll_expiration = poll.Expiration();
-
-    for (; pindex && pindex->nTime > poll_expiration; pindex = pindex->pprev);
-
-    return pindex->nMoneySupply;
+    return ResolveLastBlockForPoll(poll)->nMoneySupply;
 }
 } // Anonymous namespace
 
@@ -1075,8 +1346,22 @@ PollResult::PollResult(Poll poll)
 
 PollResultOption PollResult::BuildFor(const PollReference& poll_ref)
 {
-    if (PollOption poll = poll_ref.TryReadFromDisk()) {
-        CTxDB txdb("r");
+    if (poll_ref.m_result_cache && poll_ref.m_result_cache->IsCurrent()) {
+        return poll_ref.m_result_cache->m_result;
+    }
+
+    CTxDB txdb("r");
+
+    if (PollOption poll = poll_ref.TryReadFromDisk(txdb)) {
+        // Results of closed polls do not change, so serve them from the
+        // archive instead of recounting the votes:
+        //
+        if (auto archived = PollResultArchive::Load(txdb, poll_ref.Txid(), *poll)) {
+            poll_ref.m_result_cache = std::move(archived);
+
+            return poll_ref.m_result_cache->m_result;
+        }
+
         PollResult result(std::move(*poll));
         VoteCounter counter(txdb, result.m_poll);
 
@@ -1088,6 +1373,18 @@ PollResultOption PollResult::BuildFor(const PollReference& poll_ref)
 
         counter.CountVotes(result, poll_ref.Votes());
 
+        poll_ref.m_result_cache = std::make_shared<const CachedPollResult>(
+            result,
+            counter.CountedLegacyVotes());
+
+        if (poll_ref.m_result_cache->m_frozen
+            && !PollResultArchive::Store(poll_ref.Txid(), *poll_ref.m_result_cache))
+        {
+            LogPrint(LogFlags::VOTE, "%s: failed to archive result for %s",
+                __func__,
+                poll_ref.Txid().ToString());
+        }
+
         return result;
     }
 
@@ -1144,3 +1441,188 @@ bool VoteDetail::Empty() const
 {
     return m_amount == 0 && m_magnitude == 0;
 }
+
+// -----------------------------------------------------------------------------
+// Class: CachedPollResult
+// -----------------------------------------------------------------------------
+
+CachedPollResult::CachedPollResult(PollResult result, const bool depends_on_tip)
+    : m_result(std::move(result))
+    , m_pindex(pindexBest)
+    , m_frozen(false)
+{
+    if (depends_on_tip) {
+        return;
+    }
+
+    if (const CBlockIndex* const pindex_closing = ResolveClosingBlockForPoll(m_result.m_poll)) {
+        m_pindex = pindex_closing;
+        m_frozen = true;
+    }
+}
+
+CachedPollResult::CachedPollResult(PollResult result, const CBlockIndex* const pindex_closing)
+    : m_result(std::move(result))
+    , m_pindex(pindex_closing)
+    , m_frozen(true)
+{
+}
+
+bool CachedPollResult::IsCurrent() const
+{
+    if (m_frozen) {
+        return m_pindex->IsInMainChain();
+    }
+
+    return m_pindex == pindexBest;
+}
+
+// -----------------------------------------------------------------------------
+// Class: PollResultArchive
+// -----------------------------------------------------------------------------
+
+constexpr uint32_t PollResultArchive::CURRENT_VERSION; // for clang
+
+//!
+//! \brief The serialized form of a result in the archive.
+//!
+//! Does not contain the poll itself. The node reads it from the poll
+//! transaction.
+//!
+class PollResultArchive::ArchivedResult
+{
+public:
+    uint32_t m_version;   //!< Version of the serialized result format.
+    uint256 m_block_hash; //!< Hash of the block that closed the poll window.
+    PollResult m_result;  //!< The tallied poll result.
+
+    explicit ArchivedResult(PollResult result)
+        : m_version(CURRENT_VERSION)
+        , m_result(std::move(result))
+    {
+    }
+
+    template <typename Stream>
+    void Serialize(Stream& stream) const
+    {
+        stream << m_version;
+        stream << m_block_hash;
+        stream << m_result.m_total_weight;
+        stream << static_cast<uint64_t>(m_result.m_invalid_votes);
+
+        WriteCompactSize(stream, m_result.m_responses.size());
+
+        for (const auto& response : m_result.m_responses) {
+            stream << response.m_weight;
+            stream << response.m_votes;
+        }
+
+        WriteCompactSize(stream, m_result.m_votes.size());
+
+        for (const auto& vote : m_result.m_votes) {
+            stream << vote.m_amount;
+            stream << vote.m_mining_id;
+            stream << vote.m_magnitude.Scaled();
+            stream << vote.m_responses;
+        }
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& stream)
+    {
+        stream >> m_version;
+
+        if (m_version != CURRENT_VERSION) {
+            return;
+        }
+
+        uint64_t invalid_votes;
+
+        stream >> m_block_hash;
+        stream >> m_result.m_total_weight;
+        stream >> invalid_votes;
+
+        m_result.m_invalid_votes = invalid_votes;
+        m_result.m_responses.resize(ReadCompactSize(stream));
+
+        for (auto& response : m_result.m_responses) {
+            stream >> response.m_weight;
+            stream >> response.m_votes;
+        }
+
+        m_result.m_votes.resize(ReadCompactSize(stream));
+
+        for (auto& vote : m_result.m_votes) {
+            uint32_t magnitude;
+
+            stream >> vote.m_amount;
+            stream >> vote.m_mining_id;
+            stream >> magnitude;
+            stream >> vote.m_responses;
+
+            vote.m_magnitude = Magnitude::FromScaled(magnitude);
+        }
+    }
+}; // PollResultArchive::ArchivedResult
+
+
+std::shared_ptr<const CachedPollResult> PollResultArchive::Load(
+    CTxDB& txdb,
+    const uint256& txid,
+    const Poll& poll)
+{
+    // The archived result holds only while the block that closed the poll
+    // window remains the first main chain block beyond the expiration:
+    //
+    const CBlockIndex* const pindex_closing = ResolveClosingBlockForPoll(poll);
+
+    if (!pindex_closing) {
+        return nullptr;
+    }
+
+    auto key = MakeKey(txid);
+    ArchivedResult archived(poll);
+
+    try {
+        if (!txdb.ReadGenericSerializable(key, archived)) {
+            return nullptr;
+        }
+    } catch (const std::exception& e) {
+        LogPrint(LogFlags::VOTE, "%s: ignoring unreadable result for %s: %s",
+            __func__,
+            txid.ToString(),
+            e.what());
+
+        return nullptr;
+    }
+
+    if (archived.m_version != CURRENT_VERSION
+        || archived.m_result.m_responses.size() != poll.Choices().size()
+        || archived.m_block_hash != pindex_closing->GetBlockHash())
+    {
+        return nullptr;
+    }
+
+    return std::make_shared<const CachedPollResult>(
+        std::move(archived.m_result),
+        pindex_closing);
+}
+
+bool PollResultArchive::Store(const uint256& txid, const CachedPollResult& cached)
+{
+    assert(cached.m_frozen);
+
+    CTxDB txdb("rw");
+
+    auto key = MakeKey(txid);
+    ArchivedResult archived(cached.m_result);
+
+    archived.m_block_hash = cached.m_pindex->GetBlockHash();
+
+    return txdb.WriteGenericSerializable(key, archived);
+}
+
+std::pair<std::string, uint256> PollResultArchive::MakeKey(const uint256& txid)
+{
+    return std::make_pair("poll_result", txid);
+}
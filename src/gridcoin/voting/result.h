@@ -9,8 +9,13 @@
 #include "gridcoin/voting/fwd.h"
 #include "gridcoin/voting/poll.h"
 
+#include <memory>
+#include <string>
 #include <vector>
 
+class CBlockIndex;
+class CTxDB;
+
 namespace GRC {
 //!
 //! \brief Contains the results of a poll.
@@ -132,4 +137,102 @@ public:
     //!
     void TallyVote(VoteDetail detail);
 }; // PollResult
+
+//!
+//! \brief A poll result tallied by PollResult::BuildFor() and the chain
+//! context that the tally depends on.
+//!
+//! A poll's result depends on the votes linked to it and on the state of
+//! the chain through the last block in the poll window: the superblock, the
+//! money supply, and whether the claimed outputs were spent. Once the median
+//! time past of the chain tip exceeds the poll expiration, the result stays
+//! frozen until a reorg disconnects the first block with a median time past
+//! beyond the expiration. A reorg that forks between the last block in the
+//! window and that block can still add blocks to the window, so the result
+//! cannot depend on the last block in the window alone. Results of active
+//! polls hold only until the tip changes.
+//!
+class CachedPollResult
+{
+public:
+    const PollResult m_result;   //!< The tallied result.
+    const CBlockIndex* m_pindex; //!< Block that the result depends on.
+    bool m_frozen;               //!< Whether the poll window was closed.
+
+    //!
+    //! \brief Capture a tallied poll result.
+    //!
+    //! \param result         The tallied poll result.
+    //! \param depends_on_tip Whether the tally used state from the chain tip
+    //! beyond the poll window, as legacy votes do.
+    //!
+    CachedPollResult(PollResult result, const bool depends_on_tip);
+
+    //!
+    //! \brief Capture the result of a closed poll loaded from the archive.
+    //!
+    //! \param result         The tallied poll result.
+    //! \param pindex_closing The block that closed the poll window.
+    //!
+    CachedPollResult(PollResult result, const CBlockIndex* const pindex_closing);
+
+    //!
+    //! \brief Determine whether the result still reflects the chain.
+    //!
+    bool IsCurrent() const;
+}; // CachedPollResult
+
+//!
+//! \brief Stores the results of closed polls in the transaction database so
+//! that the node does not recount the votes after a restart.
+//!
+//! An archived result records the hash of the first block with a median time
+//! past beyond the poll expiration. The archive ignores a result when that
+//! block no longer closes the poll window in the main chain, and the next
+//! tally overwrites it.
+//!
+class PollResultArchive
+{
+public:
+    //!
+    //! \brief Version number of the current format for an archived result.
+    //!
+    //! Version 1 results recorded the last block in the poll window instead
+    //! of the block that closed it. The archive ignores them.
+    //!
+    static constexpr uint32_t CURRENT_VERSION = 2;
+
+    //!
+    //! \brief Load the archived result for a closed poll.
+    //!
+    //! \param txdb Transaction database to read the result from.
+    //! \param txid Hash of the transaction that contains the poll.
+    //! \param poll The poll to associate with the result.
+    //!
+    //! \return The archived result if it exists and the block that it depends
+    //! on still closes the poll window in the main chain.
+    //!
+    static std::shared_ptr<const CachedPollResult> Load(
+        CTxDB& txdb,
+        const uint256& txid,
+        const Poll& poll);
+
+    //!
+    //! \brief Archive the result of a closed poll.
+    //!
+    //! \param txid   Hash of the transaction that contains the poll.
+    //! \param cached A frozen result for the poll.
+    //!
+    //! \return \c false if the database write failed.
+    //!
+    static bool Store(const uint256& txid, const CachedPollResult& cached);
+
+private:
+    class ArchivedResult;
+
+    //!
+    //! \brief Get the database key of an archived result.
+    //!
+    static std::pair<std::string, uint256> MakeKey(const uint256& txid);
+}; // PollResultArchive
 }
@@ -276,6 +276,7 @@ std::string HelpMessage()
         "  -rescan                " + _("Rescan the block chain for missing wallet transactions") + "\n" +
         "  -salvagewallet         " + _("Attempt to recover private keys from a corrupt wallet.dat") + "\n" +
         "  -zapwallettxes         " + _("Delete all wallet transactions and only recover those parts of the blockchain through -rescan on startup") + "\n" +
+        "  -walletarchivedepth=<n> " + _("Move wallet transactions out of memory into an archive in the wallet file when they and the transactions that spend their outputs have at least <n> confirmations, or when they are coinbase or coinstake transactions orphaned at least <n> blocks ago. Zero disables archiving (default: 0)") + "\n" +
         "  -checkblocks=<n>       " + _("How many blocks to check at startup (default: 2500, 0 = all)") + "\n" +
         "  -checklevel=<n>        " + _("How thorough the block verification is (0-6, default: 1)") + "\n" +
         "  -loadblock=<file>      " + _("Imports blocks from external blk000?.dat file") + "\n" +
@@ -1130,6 +1131,12 @@ bool AppInit2(ThreadHandlerPtr threads)
     int64_t nBalanceInQuestion;
     pwalletMain->FixSpentCoins(nMismatchSpent, nBalanceInQuestion);
 
+    if (GetArg("-walletarchivedepth", 0) > 0)
+    {
+        uiInterface.InitMessage(_("Archiving wallet transactions..."));
+        pwalletMain->ArchiveTransactions(GetArg("-walletarchivedepth", 0));
+    }
+
     // Start the lightweight task scheduler thread
     CScheduler::Function serviceLoop = std::bind(&CScheduler::serviceQueue, &scheduler);
     threadGroup.create_thread(std::bind(&TraceThread<CScheduler::Function>, "scheduler", serviceLoop));
@@ -1141,6 +1148,14 @@ bool AppInit2(ThreadHandlerPtr threads)
         g_banman->DumpBanlist();
     }, DUMP_BANS_INTERVAL * 1000);
 
+    // Long-running staking wallets keep producing spent coinstakes:
+    if (GetArg("-walletarchivedepth", 0) > 0)
+    {
+        scheduler.scheduleEvery([]{
+            pwalletMain->ArchiveTransactions(GetArg("-walletarchivedepth", 0));
+        }, 24 * 60 * 60 * 1000);
+    }
+
     GRC::ScheduleBackgroundJobs(scheduler);
 
     uiInterface.InitMessage(_("Done loading"));
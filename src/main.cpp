@@ -4,6 +4,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "amount.h"
+#include "blockencodings.h"
 #include "consensus/merkle.h"
 #include "util.h"
 #include "net.h"
@@ -153,6 +154,83 @@ arith_uint256 GetChainTrust(const CBlockIndex* pindex)
     return g_chain_trust.GetTrust(pindex);
 }
 
+namespace {
+//!
+//! \brief The latest best chain snapshot published for readers that do not
+//! lock cs_main.
+//!
+//! THREAD SAFETY: Access only with std::atomic_load() and std::atomic_store().
+//!
+ChainTipSnapshotPtr g_chain_tip_snapshot = std::make_shared<const ChainTipSnapshot>();
+} // Anonymous namespace
+
+ChainTipSnapshot::ChainTipSnapshot()
+    : m_tip(nullptr)
+    , m_height(-1)
+    , m_difficulty(1.0)
+    , m_target_difficulty(1.0)
+{
+}
+
+ChainTipSnapshot::ChainTipSnapshot(const CBlockIndex* const tip)
+    : m_tip(tip)
+    , m_height(tip->nHeight)
+    , m_hash(tip->GetBlockHash())
+{
+    const CBlockIndex* pindex_stake = tip;
+
+    while (pindex_stake->pprev && !pindex_stake->IsProofOfStake()) {
+        pindex_stake = pindex_stake->pprev;
+    }
+
+    m_difficulty = GRC::GetDifficulty(pindex_stake);
+    m_target_difficulty = GRC::GetBlockDifficulty(GRC::GetNextTargetRequired(tip));
+}
+
+const CBlockIndex* ChainTipSnapshot::GetAncestor(const int height) const
+{
+    if (height < 0 || height > m_height) {
+        return nullptr;
+    }
+
+    const CBlockIndex* pindex = m_tip;
+
+    while (pindex && pindex->nHeight > height) {
+        pindex = pindex->pprev;
+    }
+
+    return pindex;
+}
+
+void PublishChainTipSnapshot()
+{
+    AssertLockHeld(cs_main);
+
+    if (pindexBest == nullptr) {
+        return;
+    }
+
+    std::atomic_store(&g_chain_tip_snapshot, std::make_shared<const ChainTipSnapshot>(pindexBest));
+}
+
+ChainTipSnapshotPtr GetChainTipSnapshot()
+{
+    return std::atomic_load(&g_chain_tip_snapshot);
+}
+
+CBlockIndex* LookupBlockIndex(const uint256& hash)
+{
+    LOCK(cs_main);
+
+    BlockMap::const_iterator mi = mapBlockIndex.find(hash);
+
+    if (mi == mapBlockIndex.end()) {
+        return nullptr;
+    }
+
+    return mi->second;
+}
+
 void GlobalStatus::SetGlobalStatus(bool force)
 {
     // Only update if the previous update is >= 4 seconds old or force is specified to avoid
@@ -327,6 +405,19 @@ void SyncWithWallets(const CTransaction& tx, const CBlock* pblock, bool fUpdate,
         pwallet->AddToWalletIfInvolvingMe(tx, pblock, fUpdate);
 }
 
+// make sure all wallets know about the transactions in a connected block. Each
+// wallet writes its changes for the block in one database transaction.
+void static SyncBlockWithWallets(const CBlock& block)
+{
+    for (auto const& pwallet : setpwalletRegistered)
+    {
+        CWalletDBBatch batch(pwallet);
+
+        for (auto const& tx : block.vtx)
+            pwallet->AddToWalletIfInvolvingMe(tx, &block, true);
+    }
+}
+
 // notify wallets about a new best chain
 void static SetBestChain(const CBlockLocator& loc)
 {
@@ -660,6 +751,7 @@ bool CTxMemPool::addUnchecked(const uint256& hash, CTransaction &tx)
         mapTx[hash] = tx;
         for (unsigned int i = 0; i < tx.vin.size(); i++)
             mapNextTx[tx.vin[i].prevout] = CInPoint(&mapTx[hash], i);
+        ++nTransactionsUpdated;
     }
     return true;
 }
@@ -683,6 +775,7 @@ bool CTxMemPool::remove(const CTransaction &tx, bool fRecursive)
             for (auto const& txin : tx.vin)
                 mapNextTx.erase(txin.prevout);
             mapTx.erase(hash);
+            ++nTransactionsUpdated;
         }
     }
     return true;
@@ -709,6 +802,7 @@ void CTxMemPool::clear()
     LOCK(cs);
     mapTx.clear();
     mapNextTx.clear();
+    ++nTransactionsUpdated;
 }
 
 void CTxMemPool::queryHashes(std::vector<uint256>& vtxid)
@@ -721,6 +815,12 @@ void CTxMemPool::queryHashes(std::vector<uint256>& vtxid)
         vtxid.push_back((*mi).first);
 }
 
+unsigned int CTxMemPool::GetTransactionsUpdated() const
+{
+    LOCK(cs);
+    return nTransactionsUpdated;
+}
+
 int CMerkleTx::GetDepthInMainChainINTERNAL(CBlockIndex* &pindexRet) const
 {
     if (hashBlock.IsNull() || nIndex == -1)
@@ -792,23 +892,21 @@ bool CWalletTx::AcceptWalletTransaction()
 // Return transaction in tx, and if it was found inside a block, its hash is placed in hashBlock
 bool GetTransaction(const uint256 &hash, CTransaction &tx, uint256 &hashBlock)
 {
+    // The memory pool has its own lock and LevelDB reads are thread-safe, so
+    // this does not need cs_main. That lets the read-only RPC handlers fetch
+    // transactions in parallel.
+    if (mempool.lookup(hash, tx))
     {
-        LOCK(cs_main);
-        {
-            if (mempool.lookup(hash, tx))
-            {
-                return true;
-            }
-        }
-        CTxDB txdb("r");
-        CTxIndex txindex;
-        if (ReadTxFromDisk(tx, txdb, COutPoint(hash, 0), txindex))
-        {
-            CBlock block;
-            if (block.ReadFromDisk(txindex.pos.nFile, txindex.pos.nBlockPos, false))
-                hashBlock = block.GetHash(true);
-            return true;
-        }
+        return true;
+    }
+    CTxDB txdb("r");
+    CTxIndex txindex;
+    if (ReadTxFromDisk(tx, txdb, COutPoint(hash, 0), txindex))
+    {
+        CBlock block;
+        if (block.ReadFromDisk(txindex.pos.nFile, txindex.pos.nBlockPos, false))
+            hashBlock = block.GetHash(true);
+        return true;
     }
     return false;
 }
@@ -1393,7 +1491,7 @@ bool TryLoadSuperblock(
     // accrual taken at each superblock:
     //
     if (block.nVersion >= 11) {
-        if (!GRC::Tally::ApplySuperblock(superblock)) {
+        if (!GRC::Tally::ApplySuperblock(superblock, pindex)) {
             return false;
         }
 
@@ -1404,7 +1502,7 @@ bool TryLoadSuperblock(
                     pindex->nHeight);
     }
 
-    GRC::Quorum::PushSuperblock(std::move(superblock));
+    GRC::Quorum::PushSuperblock(std::move(superblock), pindex);
 
     return true;
 }
@@ -1658,8 +1756,7 @@ bool CBlock::ConnectBlock(CTxDB& txdb, CBlockIndex* pindex, bool fJustCheck)
     }
 
     // Watch for transactions paying to me
-    for (auto const& tx : vtx)
-        SyncWithWallets(tx, this, true);
+    SyncBlockWithWallets(*this);
 
     return true;
 }
@@ -2027,6 +2124,11 @@ bool SetBestChain(CTxDB& txdb, CBlock &blockNew, CBlockIndex* pindexNew)
         ::SetBestChain(locator);
     }
 
+    // Refresh the research accounts and chain tip for readers that do not
+    // lock cs_main:
+    GRC::Tally::PublishSnapshot(pindexBest, fIsInitialDownload);
+    PublishChainTipSnapshot();
+
     if (LogInstance().WillLogCategory(BCLog::LogFlags::VERBOSE))
     {
         LogPrintf("{SBC} {%s %d}  trust=%s  date=%s",
@@ -2770,6 +2872,8 @@ bool LoadBlockIndex(bool fAllowNew)
     if (!txdb.LoadBlockIndex())
         return false;
 
+    PublishChainTipSnapshot();
+
     //
     // Init with genesis block
     //
@@ -3091,6 +3195,47 @@ bool static AlreadyHave(CTxDB& txdb, const CInv& inv)
 }
 
 
+//!
+//! \brief Hand a block received from a peer to the block acceptance pipeline.
+//!
+//! Shared by the full block message and by compact blocks after the node
+//! reconstructs them.
+//!
+void static ProcessReceivedBlock(CNode* pfrom, CBlock& block)
+{
+    AssertLockHeld(cs_main);
+
+    CInv inv(MSG_BLOCK, block.GetHash(true));
+    pfrom->AddInventoryKnown(inv);
+
+    if (ProcessBlock(pfrom, &block, false))
+    {
+        mapAlreadyAskedFor.erase(inv);
+        pfrom->nTrust++;
+    }
+    if (block.nDoS)
+    {
+        pfrom->Misbehaving(block.nDoS);
+        pfrom->nTrust--;
+    }
+}
+
+//!
+//! \brief Abandon a compact block and request the full block from the peer
+//! instead.
+//!
+void static RequestFullBlock(CNode* pfrom, const uint256& hash)
+{
+    AssertLockHeld(cs_main);
+
+    pfrom->m_partial_blocks.Take(hash);
+
+    LogPrint(BCLog::LogFlags::NET, "falling back to full block %s from %s", hash.ToString(), pfrom->addrName);
+
+    vector<CInv> vGetData { CInv(MSG_BLOCK, hash) };
+    pfrom->PushMessage("getdata", vGetData);
+}
+
 bool static ProcessMessage(CNode* pfrom, string strCommand, CDataStream& vRecv, int64_t nTimeReceived)
 {
     RandAddSeedPerfmon();
@@ -3426,7 +3571,7 @@ bool static ProcessMessage(CNode* pfrom, string strCommand, CDataStream& vRecv,
               LogPrint(BCLog::LogFlags::NET, "received getdata for: %s", inv.ToString());
             }
 
-            if (inv.type == MSG_BLOCK)
+            if (inv.type == MSG_BLOCK || inv.type == MSG_CMPCT_BLOCK)
             {
                 // Send block from disk
                 BlockMap::iterator mi = mapBlockIndex.find(inv.hash);
@@ -3435,7 +3580,14 @@ bool static ProcessMessage(CNode* pfrom, string strCommand, CDataStream& vRecv,
                     CBlock block;
                     block.ReadFromDisk((*mi).second);
 
-                    pfrom->PushMessage("encrypt", block);
+                    if (inv.type == MSG_CMPCT_BLOCK && pfrom->nVersion >= COMPACT_BLOCKS_VERSION)
+                    {
+                        pfrom->PushMessage("cmpctblock", CBlockHeaderAndShortTxIDs(block));
+                    }
+                    else
+                    {
+                        pfrom->PushMessage("encrypt", block);
+                    }
 
                     // Trigger them to send a getblocks request for the next batch of inventory
                     if (inv.hash == pfrom->hashContinue)
@@ -3666,22 +3818,148 @@ bool static ProcessMessage(CNode* pfrom, string strCommand, CDataStream& vRecv,
         LogPrintf(" Received block %s; ", hashBlock.ToString());
         if (LogInstance().WillLogCategory(BCLog::LogFlags::NOISY)) block.print();
 
-        CInv inv(MSG_BLOCK, hashBlock);
-        pfrom->AddInventoryKnown(inv);
+        LOCK(cs_main);
+
+        ProcessReceivedBlock(pfrom, block);
+    }
+
+
+    else if (strCommand == "cmpctblock")
+    {
+        // Compact block relay: the peer sent the header and short IDs of a
+        // block that we requested with MSG_CMPCT_BLOCK. Rebuild the block
+        // from our memory pool and ask only for what we lack:
+        //
+        CBlockHeaderAndShortTxIDs cmpctblock;
+        vRecv >> cmpctblock;
+
+        const uint256 hashBlock = cmpctblock.header.GetHash();
+
+        LogPrint(BCLog::LogFlags::NET, "received cmpctblock %s from %s", hashBlock.ToString(), pfrom->addrName);
 
         LOCK(cs_main);
 
-        if (ProcessBlock(pfrom, &block, false))
+        pfrom->AddInventoryKnown(CInv(MSG_BLOCK, hashBlock));
+
+        if (mapBlockIndex.count(hashBlock) || mapOrphanBlocks.count(hashBlock))
         {
-            mapAlreadyAskedFor.erase(inv);
-            pfrom->nTrust++;
+            return true;
         }
-        if (block.nDoS)
+
+        auto partial_block = std::make_shared<PartiallyDownloadedBlock>(&mempool);
+        const ReadStatus status = partial_block->InitData(cmpctblock);
+
+        if (status == READ_STATUS_INVALID)
         {
-                pfrom->Misbehaving(block.nDoS);
-                pfrom->nTrust--;
+            pfrom->Misbehaving(100);
+            return error("%s: invalid compact block %s from %s", __func__, hashBlock.ToString(), pfrom->addrName);
+        }
+
+        if (status == READ_STATUS_FAILED)
+        {
+            RequestFullBlock(pfrom, hashBlock);
+            return true;
         }
 
+        BlockTransactionsRequest req;
+        req.blockhash = hashBlock;
+        req.indexes = partial_block->GetMissingIndexes();
+
+        if (req.indexes.empty())
+        {
+            CBlock block;
+
+            if (partial_block->FillBlock(block, {}) != READ_STATUS_OK)
+            {
+                RequestFullBlock(pfrom, hashBlock);
+                return true;
+            }
+
+            ProcessReceivedBlock(pfrom, block);
+            return true;
+        }
+
+        // A full queue drops the oldest block that still waits for its
+        // transactions. Fetch that one in full so that it does not wait for
+        // the request to time out:
+        //
+        if (const std::optional<uint256> evicted = pfrom->m_partial_blocks.Add(hashBlock, std::move(partial_block)))
+        {
+            RequestFullBlock(pfrom, *evicted);
+        }
+
+        pfrom->PushMessage("getblocktxn", req);
+    }
+
+
+    else if (strCommand == "getblocktxn")
+    {
+        BlockTransactionsRequest req;
+        vRecv >> req;
+
+        LOCK(cs_main);
+
+        BlockMap::iterator mi = mapBlockIndex.find(req.blockhash);
+
+        if (mi == mapBlockIndex.end())
+        {
+            LogPrint(BCLog::LogFlags::NET, "peer %s requested transactions of unknown block %s",
+                     pfrom->addrName, req.blockhash.ToString());
+            return true;
+        }
+
+        CBlock block;
+        block.ReadFromDisk(mi->second);
+
+        BlockTransactions resp(req);
+
+        for (size_t i = 0; i < req.indexes.size(); i++)
+        {
+            if (req.indexes[i] >= block.vtx.size())
+            {
+                pfrom->Misbehaving(100);
+                return error("%s: peer %s sent out-of-bounds tx index", __func__, pfrom->addrName);
+            }
+
+            resp.txn[i] = block.vtx[req.indexes[i]];
+        }
+
+        pfrom->PushMessage("blocktxn", resp);
+    }
+
+
+    else if (strCommand == "blocktxn")
+    {
+        BlockTransactions resp;
+        vRecv >> resp;
+
+        LOCK(cs_main);
+
+        std::shared_ptr<PartiallyDownloadedBlock> partial_block = pfrom->m_partial_blocks.Take(resp.blockhash);
+
+        if (!partial_block)
+        {
+            LogPrint(BCLog::LogFlags::NET, "peer %s sent unexpected blocktxn for %s",
+                     pfrom->addrName, resp.blockhash.ToString());
+            return true;
+        }
+
+        CBlock block;
+        const ReadStatus status = partial_block->FillBlock(block, resp.txn);
+
+        if (status == READ_STATUS_INVALID)
+        {
+            pfrom->Misbehaving(100);
+            return error("%s: peer %s sent invalid blocktxn", __func__, pfrom->addrName);
+        }
+
+        if (status == READ_STATUS_FAILED)
+        {
+            RequestFullBlock(pfrom, resp.blockhash);
+            return true;
+        }
+
+        ProcessReceivedBlock(pfrom, block);
     }
 
 
@@ -4169,8 +4447,21 @@ bool SendMessages(CNode* pto, bool fSendTrickle)
 
         if (!fAlreadyHave)
         {
-            LogPrint(BCLog::LogFlags::NET, "sending getdata: %s", inv.ToString());
-            vGetData.push_back(inv);
+            // Ask for new blocks near the tip as compact blocks from peers
+            // that support them. Most of their transactions already sit in
+            // our memory pool. Blocks fetched during initial block download
+            // still arrive in full:
+            //
+            if (inv.type == MSG_BLOCK && pto->nVersion >= COMPACT_BLOCKS_VERSION && !IsInitialBlockDownload())
+            {
+                LogPrint(BCLog::LogFlags::NET, "sending getdata: %s (compact)", inv.ToString());
+                vGetData.push_back(CInv(MSG_CMPCT_BLOCK, inv.hash));
+            }
+            else
+            {
+                LogPrint(BCLog::LogFlags::NET, "sending getdata: %s", inv.ToString());
+                vGetData.push_back(inv);
+            }
             if (vGetData.size() >= 1000)
             {
                 pto->PushMessage("getdata", vGetData);
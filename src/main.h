@@ -23,6 +23,7 @@
 #include "validation.h"
 
 #include <map>
+#include <memory>
 #include <unordered_map>
 #include <set>
 
@@ -213,6 +214,75 @@ bool AcceptToMemoryPool(CTxMemPool& pool, CTransaction &tx,
                         bool* pfMissingInputs);
 bool SetBestChain(CTxDB& txdb, CBlock &blockNew, CBlockIndex* pindexNew);
 
+//!
+//! \brief An immutable view of the best chain for readers that do not lock
+//! cs_main, such as the read-only RPC handlers.
+//!
+//! Block index entries are never freed, and the height, hash, and ancestry of
+//! an entry do not change once it enters the index, so a reader may follow the
+//! \c pprev links from the snapshot tip without a lock. The \c pnext links are
+//! rewritten during a reorganization and must not be followed from a snapshot.
+//!
+class ChainTipSnapshot
+{
+public:
+    const CBlockIndex* m_tip;   //!< Best block or \c nullptr before loading.
+    int m_height;               //!< Height of the best block.
+    uint256 m_hash;             //!< Hash of the best block.
+    double m_difficulty;        //!< Difficulty of the last proof-of-stake block.
+    double m_target_difficulty; //!< Difficulty required for the next block.
+
+    //!
+    //! \brief Initialize an empty snapshot for use before the chain loads.
+    //!
+    ChainTipSnapshot();
+
+    //!
+    //! \brief Capture the chain that ends at the specified block.
+    //!
+    //! \param tip Best block of the chain to capture.
+    //!
+    explicit ChainTipSnapshot(const CBlockIndex* const tip);
+
+    //!
+    //! \brief Find the block at the specified height in the captured chain.
+    //!
+    //! \param height Height of the block to find.
+    //!
+    //! \return The block at \p height, or \c nullptr if the height is out of
+    //! range.
+    //!
+    const CBlockIndex* GetAncestor(const int height) const;
+};
+
+typedef std::shared_ptr<const ChainTipSnapshot> ChainTipSnapshotPtr;
+
+//!
+//! \brief Publish a snapshot of the current best chain for readers that do
+//! not lock cs_main.
+//!
+//! THREAD SAFETY: Lock cs_main before calling this function.
+//!
+void PublishChainTipSnapshot();
+
+//!
+//! \brief Get the most recently published snapshot of the best chain.
+//!
+//! This does not lock cs_main. The snapshot lags the chain state only while
+//! a block connects or the chain reorganizes.
+//!
+ChainTipSnapshotPtr GetChainTipSnapshot();
+
+//!
+//! \brief Find a block index entry by hash.
+//!
+//! Holds cs_main only for the map lookup. The returned entry stays valid after
+//! the lock releases, but its \c pnext link may change at any time.
+//!
+//! \return The block index entry, or \c nullptr if the block is unknown.
+//!
+CBlockIndex* LookupBlockIndex(const uint256& hash);
+
 
 /** A transaction with a merkle branch linking it to the block chain. */
 class CMerkleTx : public CTransaction
@@ -1155,11 +1225,20 @@ public:
     std::map<uint256, CTransaction> mapTx;
     std::map<COutPoint, CInPoint> mapNextTx;
 
+    //!
+    //! \brief Incremented whenever a transaction enters or leaves the pool.
+    //!
+    //! Consumers that derive state from the pool contents, like the block
+    //! template cache in the miner, compare this value to detect changes.
+    //!
+    unsigned int nTransactionsUpdated = 0;
+
     bool addUnchecked(const uint256& hash, CTransaction &tx);
     bool remove(const CTransaction &tx, bool fRecursive = false);
     bool removeConflicts(const CTransaction &tx);
     void clear();
     void queryHashes(std::vector<uint256>& vtxid);
+    unsigned int GetTransactionsUpdated() const;
 
     unsigned long size() const
     {
@@ -27,6 +27,7 @@
 
 #include <memory>
 #include <algorithm>
+#include <limits>
 #include <tuple>
 #include <random>
 
@@ -249,22 +250,86 @@ std::optional<CWalletTx> GetLastStake(CWallet& wallet)
     return stake_tx;
 }
 
-// CreateRestOfTheBlock: collect transactions into block and fill in header
-bool CreateRestOfTheBlock(CBlock &block, CBlockIndex* pindexPrev)
+namespace {
+//!
+//! \brief Memory pool transactions selected for a block that builds on a
+//! particular chain tip.
+//!
+//! Transaction selection only depends on the chain tip, the contents of the
+//! memory pool, and the block time through the transaction timestamp limit.
+//! The miner keeps the last selection so that, when it finds a kernel, it only
+//! needs to create the coinstake and the claim before it can sign the block.
+//!
+struct BlockTemplate
+{
+    uint256 m_hash_prev_block;           //!< Chain tip that the template builds on.
+    unsigned int m_mempool_sequence = 0; //!< Memory pool update counter at selection.
+    std::vector<CTransaction> m_vtx;     //!< Selected transactions in block order.
+    CAmount m_fees = 0;                  //!< Sum of the fees of the selected transactions.
+    int64_t m_max_included_time = 0;     //!< Latest timestamp of a selected transaction.
+
+    //!
+    //! \brief Earliest timestamp of a transaction skipped by the time limit.
+    //!
+    int64_t m_min_excluded_time = std::numeric_limits<int64_t>::max();
+
+    bool m_time_sensitive = false; //!< A transaction was skipped as non-final.
+
+    //!
+    //! \brief Determine whether the selection still matches the chain tip and
+    //! the memory pool.
+    //!
+    bool IsCurrent(const CBlockIndex* const pindexPrev, const unsigned int mempool_sequence) const
+    {
+        return !m_hash_prev_block.IsNull()
+            && m_hash_prev_block == pindexPrev->GetBlockHash()
+            && m_mempool_sequence == mempool_sequence;
+    }
+
+    //!
+    //! \brief Determine whether selecting transactions for a block with the
+    //! specified time produces the same result as this template.
+    //!
+    //! \param block_time Timestamp of the block to fill.
+    //!
+    bool IsValidFor(
+        const CBlockIndex* const pindexPrev,
+        const unsigned int mempool_sequence,
+        const int64_t block_time) const
+    {
+        return IsCurrent(pindexPrev, mempool_sequence)
+            && !m_time_sensitive
+            && m_max_included_time <= block_time
+            && m_min_excluded_time > block_time;
+    }
+};
+
+//!
+//! \brief The last set of transactions selected by the miner. Protected by
+//! \c cs_main .
+//!
+BlockTemplate g_block_template;
+
+//!
+//! \brief Collect memory pool transactions into a new block template.
+//!
+//! \param block_template Receives the selected transactions.
+//! \param coinbase       Coinbase of the block. Determines the base fee.
+//! \param pindexPrev     Chain tip that the block builds on.
+//! \param block_time     Timestamp of the block to fill.
+//!
+void SelectBlockTransactions(
+    BlockTemplate& block_template,
+    const CTransaction& coinbase,
+    CBlockIndex* pindexPrev,
+    const int64_t block_time)
 {
+    AssertLockHeld(cs_main);
 
     int nHeight = pindexPrev->nHeight + 1;
 
-    // Create coinbase tx
-    CTransaction &CoinBase = block.vtx[0];
-    CoinBase.nTime = block.nTime;
-    CoinBase.vin.resize(1);
-    CoinBase.vin[0].prevout.SetNull();
-    CoinBase.vout.resize(1);
-    // Height first in coinbase required for block.version=2
-    CoinBase.vin[0].scriptSig = (CScript() << nHeight) + COINBASE_FLAGS;
-    assert(CoinBase.vin[0].scriptSig.size() <= 100);
-    CoinBase.vout[0].SetEmpty();
+    block_template = BlockTemplate();
+    block_template.m_hash_prev_block = pindexPrev->GetBlockHash();
 
     // Largest block you're willing to create:
     unsigned int nBlockMaxSize = GetArg("-blockmaxsize", MAX_BLOCK_SIZE_GEN/2);
@@ -286,16 +351,18 @@ bool CreateRestOfTheBlock(CBlock &block, CBlockIndex* pindexPrev)
     // a transaction spammer can cheaply fill blocks using
     // 1-satoshi-fee transactions. It should be set above the real
     // cost to you of processing a transaction.
-    int64_t nMinTxFee = GetBaseFee(CoinBase);
+    int64_t nMinTxFee = GetBaseFee(coinbase);
     if (mapArgs.count("-mintxfee"))
         ParseMoney(mapArgs["-mintxfee"], nMinTxFee);
 
     // Collect memory pool transactions into the block
     int64_t nFees = 0;
     {
-        LOCK2(cs_main, mempool.cs);
+        LOCK(mempool.cs);
         CTxDB txdb("r");
 
+        block_template.m_mempool_sequence = mempool.nTransactionsUpdated;
+
         // Priority order to process transactions
         list<COrphan> vOrphan; // list memory doesn't move
         map<uint256, vector<COrphan*> > mapDependers;
@@ -307,8 +374,16 @@ bool CreateRestOfTheBlock(CBlock &block, CBlockIndex* pindexPrev)
         for (map<uint256, CTransaction>::iterator mi = mempool.mapTx.begin(); mi != mempool.mapTx.end(); ++mi)
         {
             CTransaction& tx = (*mi).second;
-            if (tx.IsCoinBase() || tx.IsCoinStake() || !IsFinalTx(tx, nHeight))
+            if (tx.IsCoinBase() || tx.IsCoinStake())
+                continue;
+
+            if (!IsFinalTx(tx, nHeight))
+            {
+                // Time-locked transactions may become final as the clock
+                // advances. Do not reuse a selection that skipped one:
+                block_template.m_time_sensitive = true;
                 continue;
+            }
 
             // Double-check that contracts pass contextual validation again so
             // that we don't include a transaction that disrupts validation of
@@ -443,10 +518,11 @@ bool CreateRestOfTheBlock(CBlock &block, CBlockIndex* pindexPrev)
             }
 
             // Timestamp limit
-            if (tx.nTime >  block.nTime)
+            if (tx.nTime > block_time)
             {
+                block_template.m_min_excluded_time = std::min<int64_t>(block_template.m_min_excluded_time, tx.nTime);
                 msMiningErrorsExcluded += tx.GetHash().GetHex() + ":TimestampLimit(" + ToString(tx.nTime) + ","
-                    + ToString(block.vtx[0].nTime) + ");";
+                    + ToString(block_time) + ");";
                 continue;
             }
 
@@ -513,7 +589,8 @@ bool CreateRestOfTheBlock(CBlock &block, CBlockIndex* pindexPrev)
 
             // Added
             msMiningErrorsIncluded += tx.GetHash().GetHex() + ";";
-            block.vtx.push_back(tx);
+            block_template.m_vtx.push_back(tx);
+            block_template.m_max_included_time = std::max<int64_t>(block_template.m_max_included_time, tx.nTime);
             nBlockSize += nTxSize;
             ++nBlockTx;
             nBlockSigOps += nTxSigOps;
@@ -548,8 +625,70 @@ bool CreateRestOfTheBlock(CBlock &block, CBlockIndex* pindexPrev)
             LogPrintf("CreateNewBlock(): total size %" PRIu64, nBlockSize);
     }
 
+    block_template.m_fees = nFees;
+}
+
+//!
+//! \brief Select transactions for a new block template ahead of time when the
+//! chain tip or the memory pool changed since the last selection.
+//!
+//! The miner calls this on each pass so that finding a kernel only requires
+//! the coinstake and the claim. The selection uses the current time. If the
+//! coinstake time that the miner settles on changes the outcome of the
+//! timestamp limit, \c CreateRestOfTheBlock() selects the transactions again.
+//!
+//! \param pindexPrev Chain tip that the next block builds on.
+//!
+void UpdateBlockTemplate(CBlockIndex* pindexPrev)
+{
+    AssertLockHeld(cs_main);
+
+    if (g_block_template.IsCurrent(pindexPrev, mempool.GetTransactionsUpdated())) {
+        return;
+    }
+
+    SelectBlockTransactions(g_block_template, CTransaction(), pindexPrev, GetAdjustedTime());
+
+    LogPrint(BCLog::LogFlags::MINER,
+             "%s: selected %" PRIszu " transactions for block template",
+             __func__,
+             g_block_template.m_vtx.size());
+}
+} // anonymous namespace
+
+// CreateRestOfTheBlock: collect transactions into block and fill in header
+bool CreateRestOfTheBlock(CBlock &block, CBlockIndex* pindexPrev)
+{
+    AssertLockHeld(cs_main);
+
+    int nHeight = pindexPrev->nHeight + 1;
+
+    // Create coinbase tx
+    CTransaction &CoinBase = block.vtx[0];
+    CoinBase.nTime = block.nTime;
+    CoinBase.vin.resize(1);
+    CoinBase.vin[0].prevout.SetNull();
+    CoinBase.vout.resize(1);
+    // Height first in coinbase required for block.version=2
+    CoinBase.vin[0].scriptSig = (CScript() << nHeight) + COINBASE_FLAGS;
+    assert(CoinBase.vin[0].scriptSig.size() <= 100);
+    CoinBase.vout[0].SetEmpty();
+
+    // Reuse the transactions selected on a previous pass of the miner when
+    // neither the chain tip nor the memory pool changed since then:
+    if (g_block_template.IsValidFor(pindexPrev, mempool.GetTransactionsUpdated(), block.nTime)) {
+        LogPrint(BCLog::LogFlags::MINER,
+                 "%s: reusing block template with %" PRIszu " transactions",
+                 __func__,
+                 g_block_template.m_vtx.size());
+    } else {
+        SelectBlockTransactions(g_block_template, CoinBase, pindexPrev, block.nTime);
+    }
+
+    block.vtx.insert(block.vtx.end(), g_block_template.m_vtx.begin(), g_block_template.m_vtx.end());
+
     //Add fees to coinbase
-    block.vtx[0].vout[0].nValue= nFees;
+    block.vtx[0].vout[0].nValue = g_block_template.m_fees;
 
     // Fill in header
     block.hashPrevBlock  = pindexPrev->GetBlockHash();
@@ -559,6 +698,169 @@ bool CreateRestOfTheBlock(CBlock &block, CBlockIndex* pindexPrev)
 }
 
 
+namespace {
+//!
+//! \brief An output that the miner can stake with, along with the kernel
+//! inputs that stay the same between passes of the miner.
+//!
+struct StakeCandidate
+{
+    const CWalletTx* m_tx;           //!< Transaction that contains the output.
+    unsigned int m_n;                //!< Index of the output in the transaction.
+    int64_t m_weight;                //!< Stake weight of the output.
+    GRC::StakeKernelPrefix m_kernel; //!< Serialized kernel hash inputs.
+};
+
+//!
+//! \brief Caches the outputs that the wallet can stake with.
+//!
+//! Selecting coins for staking walks the entire wallet. The set of candidates
+//! only changes when the chain tip, the wallet, the stake modifier, or the
+//! reserve balance changes, so the miner refreshes the table on those events.
+//! Otherwise, each pass only filters the candidates by age and hashes their
+//! kernels for the new coinstake time.
+//!
+class StakeCandidateTable
+{
+public:
+    //!
+    //! \brief Select the staking candidates from the wallet again if anything
+    //! that they depend on changed since the last refresh.
+    //!
+    //! \param wallet            Supplies the outputs to stake with.
+    //! \param pindexPrev        Chain tip that the next block builds on.
+    //! \param StakeModifier     Stake modifier of the chain tip.
+    //! \param not_staking_error Set to the reason when no candidates exist.
+    //!
+    //! \return \c true if the wallet contains any candidates.
+    //!
+    bool Refresh(
+        CWallet& wallet,
+        const CBlockIndex* const pindexPrev,
+        const uint64_t StakeModifier,
+        GRC::MinerStatus::ReasonNotStakingCategory& not_staking_error)
+    {
+        AssertLockHeld(cs_main);
+
+        if (m_hash_prev_block == pindexPrev->GetBlockHash()
+            && m_wallet_sequence == nWalletDBUpdated
+            && m_reserve_balance == nReserveBalance
+            && m_stake_modifier == StakeModifier)
+        {
+            not_staking_error = m_not_staking_error;
+            return !m_candidates.empty();
+        }
+
+        m_hash_prev_block = pindexPrev->GetBlockHash();
+        m_wallet_sequence = nWalletDBUpdated;
+        m_reserve_balance = nReserveBalance;
+        m_stake_modifier = StakeModifier;
+        m_not_staking_error = GRC::MinerStatus::NONE;
+        m_balance = 0;
+        m_candidates.clear();
+
+        std::vector<std::pair<const CWalletTx*, unsigned int>> coins;
+
+        // Select coins regardless of their age. The miner filters candidates
+        // by the coinstake time on each pass:
+        //
+        if (!wallet.SelectCoinsForStaking(
+                std::numeric_limits<unsigned int>::max(),
+                coins,
+                m_not_staking_error,
+                m_balance,
+                true))
+        {
+            not_staking_error = m_not_staking_error;
+            return false;
+        }
+
+        m_candidates.reserve(coins.size());
+
+        for (const auto& coin : coins) {
+            const CWalletTx& CoinTx = *coin.first;
+            const auto block_iter = mapBlockIndex.find(CoinTx.hashBlock);
+
+            if (block_iter == mapBlockIndex.end() || !block_iter->second) {
+                continue;
+            }
+
+            m_candidates.push_back({
+                coin.first,
+                coin.second,
+                GRC::CalculateStakeWeightV8(CoinTx, coin.second),
+                GRC::StakeKernelPrefix(
+                    StakeModifier,
+                    block_iter->second->nTime,
+                    CoinTx.GetHash(),
+                    coin.second),
+            });
+        }
+
+        LogPrint(BCLog::LogFlags::MINER,
+                 "%s: refreshed %" PRIszu " stake candidates",
+                 __func__,
+                 m_candidates.size());
+
+        return !m_candidates.empty();
+    }
+
+    //!
+    //! \brief Get the candidates old enough to stake at the specified time in
+    //! random order.
+    //!
+    //! \param nSpendTime Time of the coinstake transaction.
+    //!
+    std::vector<const StakeCandidate*> Eligible(const unsigned int nSpendTime) const
+    {
+        std::vector<const StakeCandidate*> eligible;
+        eligible.reserve(m_candidates.size());
+
+        for (const auto& candidate : m_candidates) {
+            // Filtering by tx timestamp instead of block timestamp may give
+            // false positives but never false negatives:
+            if (candidate.m_tx->nTime + nStakeMinAge <= nSpendTime) {
+                eligible.push_back(&candidate);
+            }
+        }
+
+        // Randomize the order to keep PoS truly a roll of dice in which UTXO
+        // has a chance to stake first:
+        unsigned int seed = static_cast<unsigned int>(GetAdjustedTime());
+
+        std::shuffle(eligible.begin(), eligible.end(), std::default_random_engine(seed));
+
+        return eligible;
+    }
+
+    //!
+    //! \brief Get the wallet balance considered for staking efficiency.
+    //!
+    int64_t Balance() const
+    {
+        return m_balance;
+    }
+
+private:
+    uint256 m_hash_prev_block;                //!< Chain tip at the last refresh.
+    unsigned int m_wallet_sequence = 0;       //!< Wallet database update counter.
+    int64_t m_reserve_balance = 0;            //!< Reserve balance setting.
+    uint64_t m_stake_modifier = 0;            //!< Stake modifier of the chain tip.
+    int64_t m_balance = 0;                    //!< Balance considered for staking.
+    std::vector<StakeCandidate> m_candidates; //!< Outputs to stake with.
+
+    //!
+    //! \brief Reason that the wallet cannot stake after the last refresh.
+    //!
+    GRC::MinerStatus::ReasonNotStakingCategory m_not_staking_error = GRC::MinerStatus::NONE;
+}; // StakeCandidateTable
+
+//!
+//! \brief The outputs that the miner can stake with. Protected by \c cs_main .
+//!
+StakeCandidateTable g_stake_candidates;
+} // anonymous namespace
+
 bool CreateCoinStake(CBlock &blocknew, CKey &key,
     vector<const CWalletTx*> &StakeInputs,
     CWallet &wallet, CBlockIndex* pindexPrev)
@@ -567,7 +869,6 @@ bool CreateCoinStake(CBlock &blocknew, CKey &key,
     function += ": ";
 
     int64_t CoinWeight;
-    CBigNum StakeKernelHash;
     CTxDB txdb("r");
     int64_t StakeWeightSum = 0;
     double StakeValueSum = 0;
@@ -582,15 +883,34 @@ bool CreateCoinStake(CBlock &blocknew, CKey &key,
     txnew.vin.clear();
     txnew.vout.clear();
 
-    // Choose coins to use
-    vector<pair<const CWalletTx*,unsigned int>> CoinsToStake;
     GRC::MinerStatus::ReasonNotStakingCategory not_staking_error;
 
+    uint64_t StakeModifier = 0;
+    int nHeight_mod = 0;
+
+    if (!GRC::FindStakeModifierRev(StakeModifier, pindexPrev, nHeight_mod)) return false;
+
+    LogPrint(BCLog::LogFlags::MISC, "FindStakeModifierRev(): pindex->nHeight = %i, "
+                                    "pindex->nStakeModifier = %" PRId64,
+                                    nHeight_mod, StakeModifier);
+
+    // Choose coins to use. This only selects coins from the wallet again when
+    // the chain tip or the wallet changed:
+    if (!g_stake_candidates.Refresh(wallet, pindexPrev, StakeModifier, not_staking_error))
+    {
+        ReturnMinerError(g_miner_status, not_staking_error);
+
+        return false;
+    }
+
     // This will be used to calculate the staking efficiency.
-    int64_t balance = 0;
+    int64_t balance = g_stake_candidates.Balance();
 
-    if (!wallet.SelectCoinsForStaking(txnew.nTime, CoinsToStake, not_staking_error, balance, true))
+    const std::vector<const StakeCandidate*> CoinsToStake = g_stake_candidates.Eligible(txnew.nTime);
+
+    if (CoinsToStake.empty())
     {
+        not_staking_error = GRC::MinerStatus::NO_MATURE_COINS;
         ReturnMinerError(g_miner_status, not_staking_error);
 
         return false;
@@ -601,53 +921,60 @@ bool CreateCoinStake(CBlock &blocknew, CKey &key,
     LogPrint(BCLog::LogFlags::MINER, "CreateCoinStake: Staking nTime/16 = %d Bits = %u",
              txnew.nTime/16, blocknew.nBits);
 
-    uint64_t StakeModifier = 0;
-    int nHeight_mod = 0;
+    // Hash the kernels of all candidates at once to take advantage of the
+    // multi-way SHA256 implementations:
+    std::vector<const GRC::StakeKernelPrefix*> kernels;
+    kernels.reserve(CoinsToStake.size());
 
-    if (!GRC::FindStakeModifierRev(StakeModifier, pindexPrev, nHeight_mod)) return false;
+    for (const auto& pcoin : CoinsToStake) {
+        kernels.push_back(&pcoin->m_kernel);
+    }
 
-    LogPrint(BCLog::LogFlags::MISC, "FindStakeModifierRev(): pindex->nHeight = %i, "
-                                    "pindex->nStakeModifier = %" PRId64,
-                                    nHeight_mod, StakeModifier);
+    const std::vector<uint256> kernel_hashes = GRC::CalculateStakeHashesV8(kernels, txnew.nTime);
 
-    for (const auto& pcoin : CoinsToStake)
-    {
-        const CWalletTx &CoinTx = *pcoin.first; //transaction that produced this coin
-        unsigned int CoinTxN = pcoin.second; //index of this coin inside it
+    g_timer.GetTimes(function + "kernel hashes", "miner");
 
-        unsigned int block_time;
+    for (size_t coin_index = 0; coin_index < CoinsToStake.size(); ++coin_index)
+    {
+        const StakeCandidate* const pcoin = CoinsToStake[coin_index];
 
-        block_time = mapBlockIndex[CoinTx.hashBlock]->nTime;
+        const CWalletTx &CoinTx = *pcoin->m_tx; //transaction that produced this coin
+        unsigned int CoinTxN = pcoin->m_n; //index of this coin inside it
 
         StakeValueSum += CoinTx.vout[CoinTxN].nValue / (double) COIN;
 
-        CoinWeight = GRC::CalculateStakeWeightV8(CoinTx, CoinTxN);
+        CoinWeight = pcoin->m_weight;
 
-        StakeKernelHash.setuint256(GRC::CalculateStakeHashV8(block_time, CoinTx, CoinTxN, txnew.nTime, StakeModifier));
+        const uint256& StakeKernelHash = kernel_hashes[coin_index];
 
-        CBigNum StakeTarget;
-        StakeTarget.SetCompact(blocknew.nBits);
-        StakeTarget *= CoinWeight;
         StakeWeightSum += CoinWeight;
         StakeWeightMin = std::min(StakeWeightMin, CoinWeight);
         StakeWeightMax = std::max(StakeWeightMax, CoinWeight);
-        double StakeKernelDiff = GRC::GetBlockDifficulty(StakeKernelHash.GetCompact())*CoinWeight;
 
-        LogPrint(BCLog::LogFlags::MINER,
-                 "CreateCoinStake: V%d Time %d, Bits %u, Weight %" PRId64 "\n"
-                 " Stk %72s\n"
-                 " Trg %72s\n"
-                 " Diff %0.7f of %0.7f",
-                 blocknew.nVersion,
-                 txnew.nTime,
-                 blocknew.nBits,
-                 CoinWeight,
-                 StakeKernelHash.GetHex(),
-                 StakeTarget.GetHex(),
-                 StakeKernelDiff,
-                 GRC::GetBlockDifficulty(blocknew.nBits));
-
-        if (StakeKernelHash <= StakeTarget)
+        // The big number target and kernel difficulty only serve the log line
+        // below. Skip building them in the hot loop unless it will be printed:
+        //
+        if (LogInstance().WillLogCategory(BCLog::LogFlags::MINER)) {
+            CBigNum StakeTarget;
+            StakeTarget.SetCompact(blocknew.nBits);
+            StakeTarget *= CoinWeight;
+            double StakeKernelDiff = GRC::GetBlockDifficulty(CBigNum(StakeKernelHash).GetCompact())*CoinWeight;
+
+            LogPrintf("CreateCoinStake: V%d Time %d, Bits %u, Weight %" PRId64 "\n"
+                      " Stk %72s\n"
+                      " Trg %72s\n"
+                      " Diff %0.7f of %0.7f",
+                      blocknew.nVersion,
+                      txnew.nTime,
+                      blocknew.nBits,
+                      CoinWeight,
+                      CBigNum(StakeKernelHash).GetHex(),
+                      StakeTarget.GetHex(),
+                      StakeKernelDiff,
+                      GRC::GetBlockDifficulty(blocknew.nBits));
+        }
+
+        if (GRC::CheckStakeKernelHashV8(StakeKernelHash, blocknew.nBits, CoinWeight))
         {
             // Found a kernel
             LogPrintf("CreateCoinStake: Found Kernel");
@@ -692,7 +1019,7 @@ bool CreateCoinStake(CBlock &blocknew, CKey &key,
             }
 
             txnew.vin.push_back(CTxIn(CoinTx.GetHash(), CoinTxN));
-            StakeInputs.push_back(pcoin.first);
+            StakeInputs.push_back(&CoinTx);
 
             int64_t nCredit = CoinTx.vout[CoinTxN].nValue;
 
@@ -704,8 +1031,8 @@ bool CreateCoinStake(CBlock &blocknew, CKey &key,
             kernel_found = true;
 
             break;
-        } // if (StakeKernelHash <= StakeTarget)
-    } // for (const auto& pcoin : CoinsToStake)
+        } // if (GRC::CheckStakeKernelHashV8(...))
+    } // for (size_t coin_index = 0; coin_index < CoinsToStake.size(); ++coin_index)
 
     LOCK(g_miner_status.lock);
 
@@ -1365,6 +1692,12 @@ void StakeMiner(CWallet *pwallet)
 
         CBlockIndex* pindexPrev = pindexBest;
 
+        // * Select transactions for the next block if the chain tip or the
+        // memory pool changed since the last pass:
+        UpdateBlockTemplate(pindexPrev);
+
+        g_timer.GetTimes(function + "UpdateBlockTemplate", "miner");
+
         // * Create a bare block
         StakeBlock.nTime = GetAdjustedTime();
         StakeBlock.nNonce = 0;
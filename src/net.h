@@ -9,6 +9,8 @@
 #include <array>
 #include <boost/thread.hpp>
 #include <atomic>
+#include <memory>
+#include <optional>
 #include <openssl/rand.h>
 
 #include "netbase.h"
@@ -24,6 +26,7 @@
 class CRequestTracker;
 class CNode;
 class CBlockIndex;
+class PartiallyDownloadedBlock;
 extern int nBestHeight;
 
 
@@ -93,10 +96,86 @@ enum
     MSG_BLOCK,
     MSG_PART,
     MSG_SCRAPERINDEX,
+    MSG_CMPCT_BLOCK, // getdata only: request a block as a compact block
 };
 
 
 
+//!
+//! \brief The compact blocks that a peer sent while we wait for the missing
+//! transactions of each one in a blocktxn message.
+//!
+//! One getdata can request several compact blocks from the same peer, so the
+//! queue keys them by block hash. It holds a few blocks at most so that a
+//! peer cannot make us keep reconstruction state for every block it sends.
+//!
+class PartialBlockQueue
+{
+public:
+    //!
+    //! \brief Maximum number of blocks that the queue holds for one peer.
+    //!
+    static constexpr size_t MAX_BLOCKS = 3;
+
+    //!
+    //! \brief Add a block that waits for its missing transactions. Replaces
+    //! a block with the same hash.
+    //!
+    //! \param hash          Hash of the block.
+    //! \param partial_block Reconstruction state of the block.
+    //!
+    //! \return The hash of the oldest block, removed to make room when the
+    //! queue is full. The caller requests that block in full instead.
+    //!
+    std::optional<uint256> Add(const uint256& hash, std::shared_ptr<PartiallyDownloadedBlock> partial_block)
+    {
+        std::optional<uint256> evicted;
+
+        if (!Take(hash) && m_blocks.size() >= MAX_BLOCKS) {
+            evicted = m_blocks.front().first;
+            m_blocks.pop_front();
+        }
+
+        m_blocks.emplace_back(hash, std::move(partial_block));
+
+        return evicted;
+    }
+
+    //!
+    //! \brief Remove the block with the specified hash from the queue.
+    //!
+    //! \return The reconstruction state of the block, or \c nullptr if the
+    //! queue does not contain it.
+    //!
+    std::shared_ptr<PartiallyDownloadedBlock> Take(const uint256& hash)
+    {
+        for (auto iter = m_blocks.begin(); iter != m_blocks.end(); ++iter) {
+            if (iter->first == hash) {
+                std::shared_ptr<PartiallyDownloadedBlock> partial_block = std::move(iter->second);
+                m_blocks.erase(iter);
+
+                return partial_block;
+            }
+        }
+
+        return nullptr;
+    }
+
+    //!
+    //! \brief Get the number of blocks in the queue.
+    //!
+    size_t size() const
+    {
+        return m_blocks.size();
+    }
+
+private:
+    //!
+    //! \brief Blocks in the order that they arrived.
+    //!
+    std::deque<std::pair<uint256, std::shared_ptr<PartiallyDownloadedBlock>>> m_blocks;
+};
+
 class CRequestTracker
 {
 public:
@@ -293,6 +372,11 @@ public:
     // Whether a ping is requested.
     bool fPingQueued;
 
+    // Compact block relay: the blocks that we are reconstructing from the
+    // cmpctblock messages sent by this peer while we wait for the missing
+    // transactions in blocktxn messages. Protected by cs_main.
+    PartialBlockQueue m_partial_blocks;
+
     CNode(SOCKET hSocketIn, CAddress addrIn, std::string addrNameIn = "", bool fInboundIn=false) : ssSend(SER_NETWORK, INIT_PROTO_VERSION), setAddrKnown(5000)
     {
 
@@ -19,6 +19,7 @@ static const char* ppszTypeName[] =
     "block",
     "part",
     "scraperindex",
+    "cmpctblock",
 };
 
 CMessageHeader::CMessageHeader()
@@ -107,32 +107,49 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool fP
 
     const GRC::MintSummary mint = block.GetMint();
 
-    CMerkleTx txGen(block.vtx[0]);
-    txGen.SetMerkleBranch(&block);
+    // Capture the fields that depend on the chain state under a short lock so
+    // that the block itself can be described without holding cs_main:
+    int confirmations;
+    arith_uint256 chain_trust;
+    const CBlockIndex* pnext;
+    int64_t money_supply;
+    bool is_superblock;
+    bool is_contract;
+    UniValue claim;
 
-    result.pushKV("confirmations", txGen.GetDepthInMainChain());
+    {
+        LOCK(cs_main);
+
+        confirmations = blockindex->IsInMainChain() ? nBestHeight - blockindex->nHeight + 1 : -1;
+        chain_trust = GetChainTrust(blockindex);
+        pnext = blockindex->pnext;
+        money_supply = blockindex->nMoneySupply;
+        is_superblock = blockindex->IsSuperblock();
+        is_contract = blockindex->IsContract();
+        claim = ClaimToJson(block.GetClaim(), blockindex);
+    }
+
+    result.pushKV("confirmations", confirmations);
     result.pushKV("size", (int)::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION));
     result.pushKV("height", blockindex->nHeight);
     result.pushKV("version", block.nVersion);
     result.pushKV("merkleroot", block.hashMerkleRoot.GetHex());
     result.pushKV("mint", ValueFromAmount(mint.m_total));
-    result.pushKV("MoneySupply", ValueFromAmount(blockindex->nMoneySupply));
+    result.pushKV("MoneySupply", ValueFromAmount(money_supply));
     result.pushKV("time", block.GetBlockTime());
     result.pushKV("nonce", (uint64_t)block.nNonce);
     result.pushKV("bits", strprintf("%08x", block.nBits));
     result.pushKV("difficulty", GRC::GetDifficulty(blockindex));
     result.pushKV("blocktrust", leftTrim(blockindex->GetBlockTrust().GetHex(), '0'));
-    result.pushKV("chaintrust", leftTrim(GetChainTrust(blockindex).GetHex(), '0'));
+    result.pushKV("chaintrust", leftTrim(chain_trust.GetHex(), '0'));
 
     if (blockindex->pprev)
         result.pushKV("previousblockhash", blockindex->pprev->GetBlockHash().GetHex());
-    if (blockindex->pnext)
-        result.pushKV("nextblockhash", blockindex->pnext->GetBlockHash().GetHex());
-
-    const GRC::Claim& claim = block.GetClaim();
+    if (pnext)
+        result.pushKV("nextblockhash", pnext->GetBlockHash().GetHex());
 
     std::string PoRNarr = "";
-    if (blockindex->IsProofOfStake() && claim.HasResearchReward()) {
+    if (blockindex->IsProofOfStake() && block.GetClaim().HasResearchReward()) {
         PoRNarr = "proof-of-research";
     }
 
@@ -166,17 +183,17 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool fP
     if (block.IsProofOfStake())
         result.pushKV("signature", HexStr(block.vchBlockSig.begin(), block.vchBlockSig.end()));
 
-    result.pushKV("claim", ClaimToJson(block.GetClaim(), blockindex));
+    result.pushKV("claim", std::move(claim));
 
     if (LogInstance().WillLogCategory(BCLog::LogFlags::NET)) result.pushKV("BoincHash",block.vtx[0].hashBoinc);
 
-    if (fPrintTransactionDetail && blockindex->IsSuperblock()) {
+    if (fPrintTransactionDetail && is_superblock) {
         result.pushKV("superblock", SuperblockToJson(block.GetSuperblock()));
     }
 
     result.pushKV("fees_collected", ValueFromAmount(mint.m_fees));
-    result.pushKV("IsSuperBlock", blockindex->IsSuperblock());
-    result.pushKV("IsContract", blockindex->IsContract());
+    result.pushKV("IsSuperBlock", is_superblock);
+    result.pushKV("IsContract", is_contract);
 
     return result;
 }
@@ -338,12 +355,16 @@ UniValue showblock(const UniValue& params, bool fHelp)
                 "Returns all information about the block at <index>\n");
 
     int nHeight = params[0].get_int();
-    if (nHeight < 0 || nHeight > nBestHeight)
+    if (nHeight < 0 || nHeight > GetChainTipSnapshot()->m_height)
         throw runtime_error("Block number out of range\n");
 
-    LOCK(cs_main);
+    CBlockIndex* pblockindex;
+
+    {
+        LOCK(cs_main);
 
-    CBlockIndex* pblockindex = RPCBlockFinder.FindByHeight(nHeight);
+        pblockindex = RPCBlockFinder.FindByHeight(nHeight);
+    }
 
     if (pblockindex==NULL)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
@@ -360,9 +381,7 @@ UniValue getbestblockhash(const UniValue& params, bool fHelp)
                 "\n"
                 "Returns the hash of the best block in the longest block chain\n");
 
-    LOCK(cs_main);
-
-    return hashBestChain.GetHex();
+    return GetChainTipSnapshot()->m_hash.GetHex();
 }
 
 UniValue getblockcount(const UniValue& params, bool fHelp)
@@ -373,9 +392,7 @@ UniValue getblockcount(const UniValue& params, bool fHelp)
                 "\n"
                 "Returns the number of blocks in the longest block chain\n");
 
-    LOCK(cs_main);
-
-    return nBestHeight;
+    return GetChainTipSnapshot()->m_height;
 }
 
 UniValue getdifficulty(const UniValue& params, bool fHelp)
@@ -386,11 +403,11 @@ UniValue getdifficulty(const UniValue& params, bool fHelp)
                 "\n"
                 "Returns the difficulty as a multiple of the minimum difficulty\n");
 
-    LOCK(cs_main);
+    const ChainTipSnapshotPtr chain_tip = GetChainTipSnapshot();
 
     UniValue obj(UniValue::VOBJ);
-    obj.pushKV("current", GRC::GetCurrentDifficulty());
-    obj.pushKV("target", GRC::GetTargetDifficulty());
+    obj.pushKV("current", chain_tip->m_difficulty);
+    obj.pushKV("target", chain_tip->m_target_difficulty);
 
     return obj;
 }
@@ -452,7 +469,7 @@ UniValue getblockhash(const UniValue& params, bool fHelp)
                 "Returns hash of block in best-block-chain at <index>\n");
 
     int nHeight = params[0].get_int();
-    if (nHeight < 0 || nHeight > nBestHeight)
+    if (nHeight < 0 || nHeight > GetChainTipSnapshot()->m_height)
         throw runtime_error("Block number out of range.");
 
     LogPrint(BCLog::LogFlags::NOISY, "Getblockhash %d", nHeight);
@@ -477,13 +494,12 @@ UniValue getblock(const UniValue& params, bool fHelp)
     std::string strHash = params[0].get_str();
     uint256 hash = uint256S(strHash);
 
-    if (mapBlockIndex.count(hash) == 0)
-        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
+    const CBlockIndex* pblockindex = LookupBlockIndex(hash);
 
-    LOCK(cs_main);
+    if (!pblockindex)
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
 
     CBlock block;
-    CBlockIndex* pblockindex = mapBlockIndex[hash];
     block.ReadFromDisk(pblockindex, true);
 
     return blockToJSON(block, pblockindex, params.size() > 1 ? params[1].get_bool() : false);
@@ -500,19 +516,13 @@ UniValue getblockbynumber(const UniValue& params, bool fHelp)
                 "Returns details of a block with given block-number\n");
 
     int nHeight = params[0].get_int();
-    if (nHeight < 0 || nHeight > nBestHeight)
-        throw runtime_error("Block number out of range");
 
-    LOCK(cs_main);
+    const CBlockIndex* pblockindex = GetChainTipSnapshot()->GetAncestor(nHeight);
 
-    CBlock block;
-    CBlockIndex* pblockindex = mapBlockIndex[hashBestChain];
-    while (pblockindex->nHeight > nHeight)
-        pblockindex = pblockindex->pprev;
-
-    uint256 hash = *pblockindex->phashBlock;
+    if (!pblockindex)
+        throw runtime_error("Block number out of range");
 
-    pblockindex = mapBlockIndex[hash];
+    CBlock block;
     block.ReadFromDisk(pblockindex, true);
 
     return blockToJSON(block, pblockindex, params.size() > 1 ? params[1].get_bool() : false);
@@ -1218,8 +1228,6 @@ UniValue magnitude(const UniValue& params, bool fHelp)
     }
 
     if (const GRC::CpidOption cpid = mining_id.TryCpid()) {
-        LOCK(cs_main);
-
         return MagnitudeReport(*cpid);
     }
 
@@ -1950,12 +1958,21 @@ UniValue MagnitudeReport(const GRC::Cpid cpid)
 {
     UniValue json(UniValue::VOBJ);
 
-    const int64_t now = OutOfSyncByAge() ? pindexBest->nTime : GetAdjustedTime();
-    const GRC::ResearchAccount& account = GRC::Tally::GetAccount(cpid);
-    const GRC::AccrualComputer calc = GRC::Tally::GetComputer(cpid, now, pindexBest);
+    // Read the published tally snapshot to avoid contention with the block
+    // processing that holds cs_main:
+    //
+    const GRC::TallySnapshotPtr tally = GRC::Tally::CurrentSnapshot();
+
+    if (!tally->m_pindex) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Research reward tally not initialized.");
+    }
+
+    const int64_t now = OutOfSyncByAge() ? tally->m_pindex->nTime : GetAdjustedTime();
+    const GRC::ResearchAccount& account = tally->GetAccount(cpid);
+    const GRC::AccrualComputer calc = tally->GetComputer(cpid, now);
 
     json.pushKV("CPID", cpid.ToString());
-    json.pushKV("Magnitude (Last Superblock)", GRC::Quorum::GetMagnitude(cpid).Floating());
+    json.pushKV("Magnitude (Last Superblock)", tally->m_superblock->m_cpids.MagnitudeOf(cpid).Floating());
     json.pushKV("Current Magnitude Unit", calc->MagnitudeUnit());
 
     json.pushKV("First Payment Time", TimestampToHRDate(account.FirstRewardTime()));
@@ -1966,7 +1983,14 @@ UniValue MagnitudeReport(const GRC::Cpid cpid)
     json.pushKV("Last Block Paid", account.LastRewardBlockHash().ToString());
     json.pushKV("Last Height Paid", (int)account.LastRewardHeight());
 
-    json.pushKV("Accrual Days", calc->AccrualDays());
+    if (account.IsNew()) {
+        // The accrual age of a CPID that never staked depends on its beacon:
+        LOCK(cs_main);
+        json.pushKV("Accrual Days", calc->AccrualDays());
+    } else {
+        json.pushKV("Accrual Days", calc->AccrualDays());
+    }
+
     json.pushKV("Owed", ValueFromAmount(calc->Accrual()));
 
     if (LogInstance().WillLogCategory(BCLog::LogFlags::VERBOSE)) {
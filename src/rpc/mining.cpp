@@ -17,6 +17,9 @@
 #include "gridcoin/voting/fwd.h"
 #include "protocol.h"
 #include "server.h"
+#include "util/parallel.h"
+
+#include <map>
 
 using namespace std;
 
@@ -237,159 +240,341 @@ UniValue getlaststake(const UniValue& params, bool fHelp)
 
 extern double CoinToDouble(double surrogate);
 
-UniValue auditsnapshotaccrual(const UniValue& params, bool fHelp)
+namespace {
+//!
+//! \brief Audits the snapshot accruals of a set of CPIDs against one view of
+//! the chain.
+//!
+//! The audit reads each superblock and accrual snapshot that it needs and
+//! finds the research reward stakes only once, and shares this data between
+//! the CPIDs. Only Prepare() needs cs_main. The audits themselves read just
+//! the prepared data, so they run on several threads after the caller releases
+//! the lock and do not stall block processing.
+//!
+class AccrualAudit
 {
-    if (fHelp || params.size() > 2)
-        throw runtime_error(
-                "auditsnapshotaccrual [CPID] [report details]\n"
-                "\n"
-                "Report accrual snapshot deltas for the specified CPID.\n");
+public:
+    //!
+    //! \brief Capture the chain data needed to audit the specified CPIDs.
+    //!
+    //! The caller must hold cs_main.
+    //!
+    //! \param cpids The CPIDs to audit, in the order of the results.
+    //!
+    void Prepare(const std::vector<GRC::Cpid>& cpids)
+    {
+        AssertLockHeld(cs_main);
 
-    const GRC::MiningId mining_id = params.size() > 0
-        ? GRC::MiningId::Parse(params[0].get_str())
-        : GRC::Researcher::Get()->Id();
+        m_now = GetAdjustedTime();
+        m_targets.reserve(cpids.size());
 
-    if (!mining_id.Valid()) {
-        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid CPID.");
-    }
+        for (const auto& cpid : cpids) {
+            AddTarget(cpid);
+        }
 
-    bool report_details = false;
+        LoadChainData();
 
-    if (params.size() > 1) {
-        report_details = params[1].get_bool();
-    }
+        const GRC::SuperblockPtr current_superblock = GRC::Quorum::CurrentSuperblock();
 
-    const GRC::CpidOption cpid = mining_id.TryCpid();
+        const auto load_superblock = [&](const CBlockIndex* const pindex) {
+            return FindSuperblock(pindex);
+        };
 
-    if (!cpid) {
-        throw JSONRPCError(RPC_INVALID_PARAMETER, "No data for investor.");
+        for (auto& target : m_targets) {
+            if (target.m_has_beacon) {
+                target.m_newbie_correction = GRC::Tally::GetNewbieSuperblockAccrualCorrection(
+                    target.m_cpid,
+                    current_superblock,
+                    load_superblock);
+            }
+        }
     }
 
-    if (!pindexBest) {
-        throw JSONRPCError(RPC_CLIENT_IN_INITIAL_DOWNLOAD, "Invalid chain.");
+    //!
+    //! \brief Get the CPID of the audit at the specified offset.
+    //!
+    const GRC::Cpid& CpidAt(const size_t index) const
+    {
+        return m_targets[index].m_cpid;
     }
 
-    UniValue result(UniValue::VOBJ);
-    UniValue audit(UniValue::VARR);
+    //!
+    //! \brief Audit the snapshot accrual of the CPID at the specified offset.
+    //!
+    //! \param index          Offset of the CPID passed to Prepare().
+    //! \param report_details Whether to include each accrual period.
+    //!
+    //! \return The audit report for the CPID, or an empty object when the CPID
+    //! has no beacon in scope of a superblock.
+    //!
+    UniValue Run(const size_t index, const bool report_details) const;
+
+    //!
+    //! \brief Audit the snapshot accruals of every CPID on several threads.
+    //!
+    //! \param report_details Whether to include each accrual period.
+    //!
+    //! \return The audit report for each CPID in the order passed to Prepare().
+    //!
+    std::vector<UniValue> RunAll(const bool report_details) const
+    {
+        std::vector<UniValue> results(m_targets.size());
 
-    LOCK(cs_main);
+        ParallelFor(m_targets.size(), [&](const size_t i) {
+            results[i] = Run(i, report_details);
+        });
 
-    if (!IsV11Enabled(nBestHeight + 1)) {
-        throw JSONRPCError(RPC_INVALID_REQUEST, "Wait for block v11 protocol");
+        return results;
     }
 
-    const int64_t now = GetAdjustedTime();
-    const GRC::ResearchAccount& account = GRC::Tally::GetAccount(*cpid);
-    const int64_t computed = GRC::Tally::GetAccrual(*cpid, now, pindexBest);
-    const int64_t newbie_correction = Tally::GetNewbieSuperblockAccrualCorrection(*cpid, GRC::Quorum::CurrentSuperblock());
-
-    bool accrual_account_exists = true;
-
-    //This indicates the account actually points to m_new_account.
-    if (account.m_accrual == 0
-            && account.m_total_research_subsidy == 0
-            && account.m_total_magnitude== 0
-            && account.m_accuracy == 0
-            && account.m_first_block_ptr == nullptr
-            && account.m_last_block_ptr == nullptr
-            )
+private:
+    //!
+    //! \brief The data captured from the chain to audit one CPID.
+    //!
+    struct Target
     {
-        // The account effectively does not really exist.
-        accrual_account_exists = false;
-    }
+        GRC::Cpid m_cpid;
+        bool m_account_exists = true;
+        int64_t m_computed = 0;
+        int64_t m_newbie_correction = 0;
+        bool m_has_beacon = false;
+        int64_t m_beacon_timestamp = 0;   //!< Of the original advertisement.
+        uint64_t m_renewals = 0;
+        UniValue m_beacon_chain { UniValue::VARR };
+        size_t m_first_superblock = 0;    //!< Offset in m_superblocks.
+    };
+
+    //!
+    //! \brief A block that paid a research reward.
+    //!
+    struct Stake
+    {
+        int64_t m_height;
+        int64_t m_time;
+        int64_t m_research_subsidy;
+    };
+
+    int64_t m_now = 0;
+    std::vector<Target> m_targets;
 
-    GRC::BeaconRegistry& beacons = GRC::GetBeaconRegistry();
+    //!
+    //! \brief Superblocks in scope of the audit in order of height.
+    //!
+    std::vector<GRC::SuperblockPtr> m_superblocks;
 
-    LogPrint(BCLog::LogFlags::ACCRUAL, "INFO %s: Number of beacons in registry = %u", __func__, beacons.Beacons().size());
+    //!
+    //! \brief Research reward stakes in scope of the audit by CPID in order of
+    //! height.
+    //!
+    std::map<GRC::Cpid, std::vector<Stake>> m_stakes;
 
-    GRC::BeaconOption beacon_try = beacons.Try(*cpid);
+    //!
+    //! \brief Accrual snapshots that begin an audit by superblock height.
+    //!
+    std::map<int64_t, AccrualSnapshot> m_snapshots;
 
-    if (!beacon_try)
+    void AddTarget(const GRC::Cpid& cpid)
     {
-        LogPrint(BCLog::LogFlags::ACCRUAL, "ERROR: %s: No beacon present for cpid = %s.", __func__, cpid->ToString());
-        return result;
-    }
+        Target& target = m_targets.emplace_back();
 
-    GRC::Beacon_ptr beacon_ptr = beacon_try;
+        target.m_cpid = cpid;
 
-    LogPrint(BCLog::LogFlags::ACCRUAL, "INFO %s: active beacon: timestamp = %" PRId64 ", ctx_hash = %s,"
-                                       " prev_beacon_ctx_hash = %s",
-             __func__,
-             beacon_ptr->m_timestamp,
-             beacon_ptr->m_hash.GetHex(),
-             beacon_ptr->m_prev_beacon_hash.GetHex());
+        const GRC::ResearchAccount& account = GRC::Tally::GetAccount(cpid);
+        target.m_computed = GRC::Tally::GetAccrual(cpid, m_now, pindexBest);
 
-    UniValue beacon_chain(UniValue::VARR);
-    UniValue beacon_chain_entry(UniValue::VOBJ);
+        //This indicates the account actually points to m_new_account.
+        if (account.m_accrual == 0
+                && account.m_total_research_subsidy == 0
+                && account.m_total_magnitude== 0
+                && account.m_accuracy == 0
+                && account.m_first_block_ptr == nullptr
+                && account.m_last_block_ptr == nullptr
+                )
+        {
+            // The account effectively does not really exist.
+            target.m_account_exists = false;
+        }
 
-    beacon_chain_entry.pushKV("ctx_hash", beacon_ptr->m_hash.GetHex());
-    beacon_chain_entry.pushKV("timestamp",  beacon_ptr->m_timestamp);
-    beacon_chain.push_back(beacon_chain_entry);
+        GRC::BeaconRegistry& beacons = GRC::GetBeaconRegistry();
 
-    // This walks back the entries in the historical beacon map linked by renewal prev tx hash until the first
-    // beacon in the renewal chain is found (the original advertisement). The accrual starts no earlier than here.
-    uint64_t renewals = 0;
-    while (beacon_ptr->Renewed() && renewals <= 100)
-    {
-        auto iter = beacons.GetBeaconDB().find(beacon_ptr->m_prev_beacon_hash);
+        LogPrint(BCLog::LogFlags::ACCRUAL, "INFO %s: Number of beacons in registry = %u", __func__, beacons.Beacons().size());
 
-        beacon_ptr = iter->second;
+        GRC::BeaconOption beacon_try = beacons.Try(cpid);
 
-        LogPrint(BCLog::LogFlags::ACCRUAL, "INFO %s: renewal %u beacon: timestamp = %" PRId64 ", ctx_hash = %s,"
-                                           " prev_beacon_ctx_hash = %s.",
+        if (!beacon_try)
+        {
+            LogPrint(BCLog::LogFlags::ACCRUAL, "ERROR: %s: No beacon present for cpid = %s.", __func__, cpid.ToString());
+            return;
+        }
+
+        GRC::Beacon_ptr beacon_ptr = beacon_try;
+
+        LogPrint(BCLog::LogFlags::ACCRUAL, "INFO %s: active beacon: timestamp = %" PRId64 ", ctx_hash = %s,"
+                                           " prev_beacon_ctx_hash = %s",
                  __func__,
-                 renewals,
                  beacon_ptr->m_timestamp,
                  beacon_ptr->m_hash.GetHex(),
                  beacon_ptr->m_prev_beacon_hash.GetHex());
 
+        UniValue beacon_chain_entry(UniValue::VOBJ);
+
         beacon_chain_entry.pushKV("ctx_hash", beacon_ptr->m_hash.GetHex());
-        beacon_chain_entry.pushKV("timestamp", beacon_ptr->m_timestamp);
-        beacon_chain.push_back(beacon_chain_entry);
+        beacon_chain_entry.pushKV("timestamp",  beacon_ptr->m_timestamp);
+        target.m_beacon_chain.push_back(beacon_chain_entry);
+
+        // This walks back the entries in the historical beacon map linked by renewal prev tx hash until the first
+        // beacon in the renewal chain is found (the original advertisement). The accrual starts no earlier than here.
+        uint64_t renewals = 0;
+        while (beacon_ptr->Renewed() && renewals <= 100)
+        {
+            auto iter = beacons.GetBeaconDB().find(beacon_ptr->m_prev_beacon_hash);
+
+            beacon_ptr = iter->second;
+
+            LogPrint(BCLog::LogFlags::ACCRUAL, "INFO %s: renewal %u beacon: timestamp = %" PRId64 ", ctx_hash = %s,"
+                                               " prev_beacon_ctx_hash = %s.",
+                     __func__,
+                     renewals,
+                     beacon_ptr->m_timestamp,
+                     beacon_ptr->m_hash.GetHex(),
+                     beacon_ptr->m_prev_beacon_hash.GetHex());
+
+            beacon_chain_entry.pushKV("ctx_hash", beacon_ptr->m_hash.GetHex());
+            beacon_chain_entry.pushKV("timestamp", beacon_ptr->m_timestamp);
+            target.m_beacon_chain.push_back(beacon_chain_entry);
+
+            ++renewals;
+        }
 
-        ++renewals;
+        target.m_has_beacon = true;
+        target.m_beacon_timestamp = beacon_ptr->m_timestamp;
+        target.m_renewals = renewals;
     }
 
-    GRC::SuperblockPtr superblock;
+    //!
+    //! \brief Read the superblocks, stakes, and snapshots that the audits need
+    //! in one pass over the chain.
+    //!
+    void LoadChainData()
+    {
+        int64_t earliest_beacon_timestamp = std::numeric_limits<int64_t>::max();
+
+        for (const auto& target : m_targets) {
+            if (target.m_has_beacon) {
+                earliest_beacon_timestamp = std::min(earliest_beacon_timestamp, target.m_beacon_timestamp);
+            }
+        }
 
-    const CBlockIndex* pindex_baseline = GRC::Tally::GetBaseline();
+        const CBlockIndex* pindex_baseline = GRC::Tally::GetBaseline();
 
-    LogPrint(BCLog::LogFlags::ACCRUAL, "INFO %s: pindex_baseline->nHeight = %i", __func__, pindex_baseline->nHeight);
+        LogPrint(BCLog::LogFlags::ACCRUAL, "INFO %s: pindex_baseline->nHeight = %i", __func__, pindex_baseline->nHeight);
 
-    const CBlockIndex* pindex_superblock;
+        // An audit starts at the first superblock after the baseline within
+        // scope of the beacon chain for its CPID. No audit can start before
+        // the first superblock in scope of the earliest beacon chain:
+        //
+        std::vector<const CBlockIndex*> superblock_indexes;
 
-    // Find the first superblock after the baseline within scope of the beacon chain for the given CPID as the starting
-    // point for the audit.
-    for (pindex_superblock = pindex_baseline;
-        pindex_superblock;
-        pindex_superblock = pindex_superblock->pnext)
+        for (const CBlockIndex* pindex = pindex_baseline; pindex; pindex = pindex->pnext) {
+            if (pindex->IsSuperblock()
+                && (!superblock_indexes.empty() || pindex->nTime >= earliest_beacon_timestamp))
+            {
+                superblock_indexes.push_back(pindex);
+            }
+
+            if (!superblock_indexes.empty() && pindex->ResearchSubsidy() > 0) {
+                if (const GRC::CpidOption cpid = pindex->GetMiningId().TryCpid()) {
+                    m_stakes[*cpid].push_back({ pindex->nHeight, pindex->nTime, pindex->ResearchSubsidy() });
+                }
+            }
+        }
+
+        m_superblocks.resize(superblock_indexes.size());
+
+        ParallelFor(superblock_indexes.size(), [&](const size_t i) {
+            m_superblocks[i] = GRC::SuperblockPtr::ReadFromDisk(superblock_indexes[i]);
+        });
+
+        for (auto& target : m_targets) {
+            if (!target.m_has_beacon) {
+                continue;
+            }
+
+            target.m_first_superblock = std::find_if(
+                m_superblocks.begin(),
+                m_superblocks.end(),
+                [&](const GRC::SuperblockPtr& superblock) {
+                    return superblock.m_timestamp >= target.m_beacon_timestamp;
+                }) - m_superblocks.begin();
+
+            if (target.m_first_superblock < m_superblocks.size()) {
+                m_snapshots.emplace(m_superblocks[target.m_first_superblock].m_height, AccrualSnapshot());
+            }
+        }
+
+        std::vector<std::pair<const int64_t, AccrualSnapshot>*> snapshots;
+
+        for (auto& entry : m_snapshots) {
+            snapshots.push_back(&entry);
+        }
+
+        ParallelFor(snapshots.size(), [&](const size_t i) {
+            snapshots[i]->second = AccrualSnapshotReader(SnapshotPath(snapshots[i]->first)).Read();
+        });
+    }
+
+    //!
+    //! \brief Get a superblock loaded for the audit, or read it from disk if
+    //! it is out of scope.
+    //!
+    GRC::SuperblockPtr FindSuperblock(const CBlockIndex* const pindex) const
     {
-        if (pindex_superblock->IsSuperblock() && pindex_superblock->nTime >= beacon_ptr->m_timestamp) {
-            superblock = SuperblockPtr::ReadFromDisk(pindex_superblock);
-            break;
+        const auto iter = std::lower_bound(
+            m_superblocks.begin(),
+            m_superblocks.end(),
+            pindex->nHeight,
+            [](const GRC::SuperblockPtr& superblock, const int64_t height) {
+                return superblock.m_height < height;
+            });
+
+        if (iter != m_superblocks.end() && iter->m_height == pindex->nHeight) {
+            return *iter;
         }
+
+        return GRC::SuperblockPtr::ReadFromDisk(pindex);
     }
+}; // AccrualAudit
+
+UniValue AccrualAudit::Run(const size_t index, const bool report_details) const
+{
+    const Target& target = m_targets[index];
+    const GRC::Cpid& cpid = target.m_cpid;
+
+    UniValue result(UniValue::VOBJ);
+    UniValue audit(UniValue::VARR);
+
+    if (!target.m_has_beacon) {
+        return result;
+    }
+
+    if (target.m_first_superblock >= m_superblocks.size()) {
+        LogPrint(BCLog::LogFlags::ACCRUAL, "ERROR: %s: No superblock in scope for cpid = %s.", __func__, cpid.ToString());
+        return result;
+    }
+
+    size_t next_superblock = target.m_first_superblock;
+    GRC::SuperblockPtr superblock = m_superblocks[next_superblock];
 
     LogPrint(BCLog::LogFlags::ACCRUAL, "INFO %s: First in scope superblock nHeight = %i", __func__,
-             pindex_superblock->nHeight);
+             superblock.m_height);
 
-    // Set the pindex_low to the pindex_superblock. For right now, we are going to take the accrual at the first snapshot
+    // Start the first period at the first superblock. For right now, we are going to take the accrual at the first snapshot
     // after the flip to v11 (the second snapshot in the accrual directory recorded at the first SB after the transition
     // height) as gospel. This doesn't allow us to verify the accrual between the transition height and the first snapshot
     // afterwards, but it drastically reduces the complexity of the audit.
-    const CBlockIndex* pindex = pindex_superblock;
-    const CBlockIndex* pindex_low = pindex_superblock;
+    int64_t last_event_time = superblock.m_timestamp;
 
-    const fs::path snapshot_path = SnapshotPath(pindex_superblock->nHeight);
-    const AccrualSnapshot snapshot = AccrualSnapshotReader(snapshot_path).Read();
-
-    int64_t accrual = 0;
-    auto entry = snapshot.m_records.find(cpid.value());
-
-    if (entry != snapshot.m_records.end())
-    {
-        accrual = entry->second;
-    }
+    int64_t accrual = m_snapshots.at(superblock.m_height).GetAccrual(cpid);
 
     const auto tally_accrual_period = [&](
         const std::string& boundary,
@@ -398,7 +583,7 @@ UniValue auditsnapshotaccrual(const UniValue& params, bool fHelp)
         const int64_t high_time,
         const int64_t claimed)
     {
-        const GRC::Magnitude magnitude = superblock->m_cpids.MagnitudeOf(*cpid);
+        const GRC::Magnitude magnitude = superblock->m_cpids.MagnitudeOf(cpid);
 
         int64_t time_interval = high_time - low_time;
         int64_t abs_time_interval = time_interval;
@@ -470,52 +655,124 @@ UniValue auditsnapshotaccrual(const UniValue& params, bool fHelp)
         return period;
     };
 
-    for (; pindex; pindex = pindex->pnext) {
-        if (pindex->ResearchSubsidy() > 0 && pindex->GetMiningId() == *cpid) {
+    // Visit the research reward stakes for the CPID and the superblocks from
+    // the first superblock in height order. A superblock takes effect for the
+    // periods that end after it.
+    //
+    static const std::vector<Stake> no_stakes;
+    const auto stakes_iter = m_stakes.find(cpid);
+    const std::vector<Stake>& stakes = stakes_iter == m_stakes.end() ? no_stakes : stakes_iter->second;
+
+    auto stake = std::lower_bound(
+        stakes.begin(),
+        stakes.end(),
+        superblock.m_height,
+        [](const Stake& entry, const int64_t height) { return entry.m_height < height; });
+
+    while (stake != stakes.end() || next_superblock < m_superblocks.size()) {
+        if (stake != stakes.end()
+            && (next_superblock == m_superblocks.size()
+                || stake->m_height <= m_superblocks[next_superblock].m_height))
+        {
             tally_accrual_period(
                 "stake",
-                pindex->nHeight,
-                pindex_low->nTime,
-                pindex->nTime,
-                pindex->ResearchSubsidy());
+                stake->m_height,
+                last_event_time,
+                stake->m_time,
+                stake->m_research_subsidy);
 
             accrual = 0;
-            pindex_low = pindex;
-        } else if (pindex->IsSuperblock()) {
+            last_event_time = stake->m_time;
+
+            if (next_superblock < m_superblocks.size()
+                && m_superblocks[next_superblock].m_height == stake->m_height)
+            {
+                superblock = m_superblocks[next_superblock++];
+            }
+
+            ++stake;
+        } else {
+            const GRC::SuperblockPtr& next = m_superblocks[next_superblock++];
+
             tally_accrual_period(
                 "superblock",
-                pindex->nHeight,
-                pindex_low->nTime,
-                pindex->nTime,
+                next.m_height,
+                last_event_time,
+                next.m_timestamp,
                 0);
 
-            pindex_low = pindex;
-        }
-
-        if (pindex->IsSuperblock()) {
-            superblock = SuperblockPtr::ReadFromDisk(pindex);
+            last_event_time = next.m_timestamp;
+            superblock = next;
         }
     }
 
     // The final period is from the last event till "now".
-    int64_t period = tally_accrual_period("tip", 0, pindex_low->nTime, now, 0);
+    int64_t period = tally_accrual_period("tip", 0, last_event_time, m_now, 0);
 
-    result.pushKV("cpid", cpid->ToString());
-    result.pushKV("accrual_account_exists", accrual_account_exists);
-    result.pushKV("latest_beacon_timestamp", beacon_chain[0]);
-    result.pushKV("original_beacon_timestamp", beacon_chain[beacon_chain.size() - 1]);
-    result.pushKV("renewals", renewals);
+    result.pushKV("cpid", cpid.ToString());
+    result.pushKV("accrual_account_exists", target.m_account_exists);
+    result.pushKV("latest_beacon_timestamp", target.m_beacon_chain[0]);
+    result.pushKV("original_beacon_timestamp", target.m_beacon_chain[target.m_beacon_chain.size() - 1]);
+    result.pushKV("renewals", target.m_renewals);
     result.pushKV("accrual_by_audit", accrual);
-    result.pushKV("accrual_by_GetAccrual", computed);
-    result.pushKV("newbie_correction", newbie_correction);
+    result.pushKV("accrual_by_GetAccrual", target.m_computed);
+    result.pushKV("newbie_correction", target.m_newbie_correction);
     result.pushKV("accrual_last_period", period);
 
     if (report_details) {
-        result.pushKV("beacon_chain", beacon_chain);
+        result.pushKV("beacon_chain", target.m_beacon_chain);
         result.pushKV("audit", audit);
     }
 
-        return result;
+    return result;
+}
+} // anonymous namespace
+
+UniValue auditsnapshotaccrual(const UniValue& params, bool fHelp)
+{
+    if (fHelp || params.size() > 2)
+        throw runtime_error(
+                "auditsnapshotaccrual [CPID] [report details]\n"
+                "\n"
+                "Report accrual snapshot deltas for the specified CPID.\n");
+
+    const GRC::MiningId mining_id = params.size() > 0
+        ? GRC::MiningId::Parse(params[0].get_str())
+        : GRC::Researcher::Get()->Id();
+
+    if (!mining_id.Valid()) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid CPID.");
+    }
+
+    bool report_details = false;
+
+    if (params.size() > 1) {
+        report_details = params[1].get_bool();
+    }
+
+    const GRC::CpidOption cpid = mining_id.TryCpid();
+
+    if (!cpid) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "No data for investor.");
+    }
+
+    if (!pindexBest) {
+        throw JSONRPCError(RPC_CLIENT_IN_INITIAL_DOWNLOAD, "Invalid chain.");
+    }
+
+    AccrualAudit audit;
+
+    {
+        LOCK(cs_main);
+
+        if (!IsV11Enabled(nBestHeight + 1)) {
+            throw JSONRPCError(RPC_INVALID_REQUEST, "Wait for block v11 protocol");
+        }
+
+        audit.Prepare({ *cpid });
+    }
+
+    return audit.Run(0, report_details);
 }
 
 UniValue auditsnapshotaccruals(const UniValue& params, bool fHelp)
@@ -533,9 +790,31 @@ UniValue auditsnapshotaccruals(const UniValue& params, bool fHelp)
         report_only_mismatches = params[0].get_bool();
     }
 
+    if (!pindexBest) {
+        throw JSONRPCError(RPC_CLIENT_IN_INITIAL_DOWNLOAD, "Invalid chain.");
+    }
+
     UniValue result(UniValue::VOBJ);
 
-    SuperblockPtr superblock = GRC::Quorum::CurrentSuperblock();
+    AccrualAudit accrual_audit;
+
+    {
+        LOCK(cs_main);
+
+        if (!IsV11Enabled(nBestHeight + 1)) {
+            throw JSONRPCError(RPC_INVALID_REQUEST, "Wait for block v11 protocol");
+        }
+
+        std::vector<GRC::Cpid> cpids;
+
+        for (const auto& iter : GRC::Quorum::CurrentSuperblock()->m_cpids) {
+            cpids.push_back(iter.Cpid());
+        }
+
+        accrual_audit.Prepare(cpids);
+    }
+
+    const std::vector<UniValue> audits = accrual_audit.RunAll(false);
 
     UniValue entries(UniValue::VARR);
     int number_of_cpids = 0;
@@ -545,18 +824,13 @@ UniValue auditsnapshotaccruals(const UniValue& params, bool fHelp)
     int number_accrual_accounts_not_present = 0;
     int number_not_present = 0;
 
-    for (const auto& iter : superblock->m_cpids)
+    for (size_t i = 0; i < audits.size(); ++i)
     {
-        std::vector<UniValue> v_params {iter.Cpid().ToString(), false};
-
-        UniValue internal_params(UniValue::VARR);
-
-        internal_params.push_backV(v_params);
+        const GRC::Cpid& cpid = accrual_audit.CpidAt(i);
+        const UniValue& audit = audits[i];
 
         UniValue match_status(UniValue::VOBJ);
 
-        UniValue audit(auditsnapshotaccrual(internal_params, false));
-
         if (!audit.empty())
         {
             const CAmount& accrual_by_audit = find_value(audit, "accrual_by_audit").get_int64();
@@ -568,7 +842,7 @@ UniValue auditsnapshotaccruals(const UniValue& params, bool fHelp)
             {
                 if (!report_only_mismatches)
                 {
-                    match_status.pushKV("CPID", iter.Cpid().ToString());
+                    match_status.pushKV("CPID", cpid.ToString());
                     match_status.pushKV("match", audit);
                     entries.push_back(match_status);
                 }
@@ -576,7 +850,7 @@ UniValue auditsnapshotaccruals(const UniValue& params, bool fHelp)
             }
             else
             {
-                match_status.pushKV("CPID", iter.Cpid().ToString());
+                match_status.pushKV("CPID", cpid.ToString());
 
                 if (accrual_last_period == accrual_by_GetAccrual)
                 {
@@ -626,13 +900,18 @@ UniValue listresearcheraccounts(const UniValue& params, bool fHelp)
 
     const int64_t now = GetAdjustedTime();
 
-    for (const auto& iter : GRC::Tally::Accounts())
+    // Read the published tally snapshot to avoid contention with the block
+    // processing that holds cs_main:
+    //
+    const GRC::TallySnapshotPtr tally = GRC::Tally::CurrentSnapshot();
+
+    for (const auto& iter : tally->m_accounts)
     {
         UniValue entry(UniValue::VOBJ);
 
         const GRC::Cpid& cpid = iter.first;
         const GRC::ResearchAccount& account = iter.second;
-        const int64_t accrual = GRC::Tally::GetAccrual(cpid, now, pindexBest);
+        const int64_t accrual = tally->GetAccrual(cpid, now);
 
         entry.pushKV("cpid", cpid.ToString());
         entry.pushKV("accrual_as_of_last_superblock", account.m_accrual);
@@ -641,7 +920,7 @@ UniValue listresearcheraccounts(const UniValue& params, bool fHelp)
         entries.push_back(entry);
     }
 
-    result.pushKV("number_of_accounts", (int) GRC::Tally::Accounts().size());
+    result.pushKV("number_of_accounts", (int) tally->m_accounts.size());
     result.pushKV("details", entries);
 
     return result;
@@ -666,16 +945,12 @@ UniValue inspectaccrualsnapshot(const UniValue& params, bool fHelp)
     result.pushKV("version", (uint64_t)snapshot.m_version);
     result.pushKV("height", snapshot.m_height);
 
-    const AccrualSnapshot::AccrualMap& records = snapshot.m_records;
-    const std::map<Cpid, int64_t> sorted_records(records.begin(), records.end());
-
     UniValue records_out(UniValue::VOBJ);
 
-    for (const auto& record_pair : sorted_records) {
-        const Cpid& cpid = record_pair.first;
-        const int64_t accrual = record_pair.second;
+    for (size_t i = 0; i < snapshot.size(); ++i) {
+        const AccrualSnapshot::Record record = snapshot[i];
 
-        records_out.pushKV(cpid.ToString(), ValueFromAmount(accrual));
+        records_out.pushKV(record.m_cpid.ToString(), ValueFromAmount(record.m_accrual));
     }
 
     result.pushKV("records", records_out);
@@ -703,16 +978,14 @@ UniValue parseaccrualsnapshotfile(const UniValue& params, bool fHelp)
     }
 
     const AccrualSnapshot snapshot = AccrualSnapshotReader(snapshot_path).Read();
-    const AccrualSnapshot::AccrualMap& records = snapshot.m_records;
-    const std::map<Cpid, int64_t> sorted_records(records.begin(), records.end());
 
     UniValue accruals(UniValue::VOBJ);
 
-    for (const auto& iter : sorted_records)
+    for (size_t i = 0; i < snapshot.size(); ++i)
     {
-        UniValue entry(UniValue::VOBJ);
+        const AccrualSnapshot::Record record = snapshot[i];
 
-        accruals.pushKV(iter.first.ToString(), ValueFromAmount(iter.second));
+        accruals.pushKV(record.m_cpid.ToString(), ValueFromAmount(record.m_accrual));
     }
 
     res.pushKV("version", (uint64_t) snapshot.m_version);
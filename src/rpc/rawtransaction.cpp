@@ -345,6 +345,9 @@ void TxToJSON(const CTransaction& tx, const uint256 hashBlock, UniValue& entry)
     if (!hashBlock.IsNull())
     {
         entry.pushKV("blockhash", hashBlock.GetHex());
+
+        LOCK(cs_main);
+
         BlockMap::iterator mi = mapBlockIndex.find(hashBlock);
         if (mi != mapBlockIndex.end() && (*mi).second)
         {
@@ -382,8 +385,6 @@ UniValue getrawtransaction(const UniValue& params, bool fHelp)
         fVerbose = params[1].isNum() ? (params[1].get_int() != 0) : params[1].get_bool();
     }
 
-    LOCK(cs_main);
-
     CTransaction tx;
     uint256 hashBlock;
     if (!GetTransaction(hash, tx, hashBlock))
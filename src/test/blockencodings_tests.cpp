@@ -0,0 +1,260 @@
+// Copyright (c) 2016-2018 The Bitcoin Core developers
+// Copyright (c) 2021 The Gridcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <blockencodings.h>
+#include <consensus/merkle.h>
+#include <streams.h>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+CTransaction MakeTransaction(const uint32_t n)
+{
+    CTransaction tx;
+
+    tx.nTime = 1600000000 + n;
+    tx.vin.emplace_back(COutPoint(GetRandHash(), n));
+    tx.vout.emplace_back(n * COIN, CScript() << OP_TRUE);
+
+    return tx;
+}
+
+//!
+//! \brief Build a proof-of-stake block with a coinbase, a coinstake, and a
+//! few transactions.
+//!
+CBlock BuildBlock()
+{
+    CBlock block;
+
+    block.nTime = 1600000100;
+    block.nBits = 0x1e0fffff;
+
+    CTransaction coinbase;
+    coinbase.nTime = block.nTime;
+    coinbase.vin.resize(1);
+    coinbase.vin[0].prevout.SetNull();
+    coinbase.vout.emplace_back(0, CScript());
+    block.vtx.push_back(coinbase);
+
+    CTransaction coinstake;
+    coinstake.nTime = block.nTime;
+    coinstake.vin.emplace_back(COutPoint(GetRandHash(), 1));
+    coinstake.vout.resize(1);
+    coinstake.vout[0].SetEmpty();
+    coinstake.vout.emplace_back(1000 * COIN, CScript() << OP_TRUE);
+    block.vtx.push_back(coinstake);
+
+    for (uint32_t i = 1; i <= 3; ++i) {
+        block.vtx.push_back(MakeTransaction(i));
+    }
+
+    block.hashMerkleRoot = BlockMerkleRoot(block);
+    block.vchBlockSig = { 0x01, 0x02, 0x03 };
+
+    return block;
+}
+
+//!
+//! \brief Send a compact block through the network serialization.
+//!
+CBlockHeaderAndShortTxIDs RoundTrip(const CBlockHeaderAndShortTxIDs& cmpctblock)
+{
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << cmpctblock;
+
+    CBlockHeaderAndShortTxIDs result;
+    stream >> result;
+
+    return result;
+}
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(blockencodings_tests)
+
+BOOST_AUTO_TEST_CASE(it_prefills_the_coinbase_and_coinstake)
+{
+    const CBlock block = BuildBlock();
+    const CBlockHeaderAndShortTxIDs cmpctblock = RoundTrip(CBlockHeaderAndShortTxIDs(block));
+
+    BOOST_CHECK_EQUAL(cmpctblock.header.GetHash().ToString(), block.GetHash().ToString());
+    BOOST_CHECK(cmpctblock.vchBlockSig == block.vchBlockSig);
+    BOOST_CHECK_EQUAL(cmpctblock.BlockTxCount(), block.vtx.size());
+    BOOST_REQUIRE_EQUAL(cmpctblock.prefilledtxn.size(), 2);
+    BOOST_CHECK_EQUAL(cmpctblock.prefilledtxn[0].index, 0);
+    BOOST_CHECK_EQUAL(cmpctblock.prefilledtxn[1].index, 1);
+    BOOST_CHECK(cmpctblock.prefilledtxn[1].tx.IsCoinStake());
+    BOOST_REQUIRE_EQUAL(cmpctblock.shorttxids.size(), 3);
+
+    for (size_t i = 0; i < cmpctblock.shorttxids.size(); ++i) {
+        BOOST_CHECK_EQUAL(
+            cmpctblock.shorttxids[i],
+            cmpctblock.GetShortID(block.vtx[i + 2].GetHash()));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(it_reconstructs_a_block_from_the_mempool)
+{
+    CBlock block = BuildBlock();
+    CTxMemPool pool;
+
+    for (size_t i = 2; i < block.vtx.size(); ++i) {
+        pool.addUnchecked(block.vtx[i].GetHash(), block.vtx[i]);
+    }
+
+    PartiallyDownloadedBlock partial_block(&pool);
+    const CBlockHeaderAndShortTxIDs cmpctblock = RoundTrip(CBlockHeaderAndShortTxIDs(block));
+
+    BOOST_REQUIRE(partial_block.InitData(cmpctblock) == READ_STATUS_OK);
+    BOOST_CHECK(partial_block.GetMissingIndexes().empty());
+
+    CBlock reconstructed;
+
+    BOOST_REQUIRE(partial_block.FillBlock(reconstructed, {}) == READ_STATUS_OK);
+    BOOST_CHECK_EQUAL(reconstructed.GetHash().ToString(), block.GetHash().ToString());
+    BOOST_CHECK_EQUAL(BlockMerkleRoot(reconstructed).ToString(), block.hashMerkleRoot.ToString());
+    BOOST_CHECK(reconstructed.vchBlockSig == block.vchBlockSig);
+}
+
+BOOST_AUTO_TEST_CASE(it_requests_transactions_missing_from_the_mempool)
+{
+    CBlock block = BuildBlock();
+    CTxMemPool pool;
+
+    pool.addUnchecked(block.vtx[3].GetHash(), block.vtx[3]);
+
+    PartiallyDownloadedBlock partial_block(&pool);
+    const CBlockHeaderAndShortTxIDs cmpctblock = RoundTrip(CBlockHeaderAndShortTxIDs(block));
+
+    BOOST_REQUIRE(partial_block.InitData(cmpctblock) == READ_STATUS_OK);
+    BOOST_CHECK(partial_block.IsTxAvailable(0));
+    BOOST_CHECK(partial_block.IsTxAvailable(1));
+    BOOST_CHECK(!partial_block.IsTxAvailable(2));
+    BOOST_CHECK(partial_block.IsTxAvailable(3));
+    BOOST_CHECK(!partial_block.IsTxAvailable(4));
+
+    BlockTransactionsRequest req;
+    req.blockhash = block.GetHash();
+    req.indexes = partial_block.GetMissingIndexes();
+
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << req;
+
+    BlockTransactionsRequest req_received;
+    stream >> req_received;
+
+    BOOST_REQUIRE_EQUAL(req_received.indexes.size(), 2);
+    BOOST_CHECK_EQUAL(req_received.indexes[0], 2);
+    BOOST_CHECK_EQUAL(req_received.indexes[1], 4);
+
+    BlockTransactions resp(req_received);
+
+    for (size_t i = 0; i < req_received.indexes.size(); ++i) {
+        resp.txn[i] = block.vtx[req_received.indexes[i]];
+    }
+
+    CBlock reconstructed;
+
+    BOOST_REQUIRE(partial_block.FillBlock(reconstructed, resp.txn) == READ_STATUS_OK);
+    BOOST_CHECK_EQUAL(reconstructed.GetHash().ToString(), block.GetHash().ToString());
+    BOOST_CHECK_EQUAL(BlockMerkleRoot(reconstructed).ToString(), block.hashMerkleRoot.ToString());
+}
+
+BOOST_AUTO_TEST_CASE(it_fails_when_fetched_transactions_do_not_match_the_merkle_root)
+{
+    CBlock block = BuildBlock();
+    CTxMemPool pool;
+
+    PartiallyDownloadedBlock partial_block(&pool);
+    const CBlockHeaderAndShortTxIDs cmpctblock = RoundTrip(CBlockHeaderAndShortTxIDs(block));
+
+    BOOST_REQUIRE(partial_block.InitData(cmpctblock) == READ_STATUS_OK);
+
+    const std::vector<CTransaction> wrong_txn {
+        MakeTransaction(7),
+        MakeTransaction(8),
+        MakeTransaction(9),
+    };
+
+    CBlock reconstructed;
+
+    BOOST_CHECK(partial_block.FillBlock(reconstructed, wrong_txn) == READ_STATUS_FAILED);
+}
+
+BOOST_AUTO_TEST_CASE(it_reconstructs_two_compact_blocks_in_flight_from_one_peer)
+{
+    const CBlock block_1 = BuildBlock();
+    const CBlock block_2 = BuildBlock();
+    CTxMemPool pool;
+    PartialBlockQueue queue;
+
+    // Both compact blocks arrive before either blocktxn response:
+    for (const CBlock* block : { &block_1, &block_2 }) {
+        auto partial_block = std::make_shared<PartiallyDownloadedBlock>(&pool);
+
+        BOOST_REQUIRE(partial_block->InitData(RoundTrip(CBlockHeaderAndShortTxIDs(*block))) == READ_STATUS_OK);
+        BOOST_CHECK(!queue.Add(block->GetHash(), std::move(partial_block)));
+    }
+
+    BOOST_CHECK_EQUAL(queue.size(), 2);
+
+    // The response for the first block still finds its reconstruction state:
+    for (const CBlock* block : { &block_1, &block_2 }) {
+        const std::shared_ptr<PartiallyDownloadedBlock> partial_block = queue.Take(block->GetHash());
+        BOOST_REQUIRE(partial_block != nullptr);
+
+        std::vector<CTransaction> missing;
+
+        for (const uint16_t index : partial_block->GetMissingIndexes()) {
+            missing.push_back(block->vtx[index]);
+        }
+
+        CBlock reconstructed;
+
+        BOOST_REQUIRE(partial_block->FillBlock(reconstructed, missing) == READ_STATUS_OK);
+        BOOST_CHECK_EQUAL(reconstructed.GetHash().ToString(), block->GetHash().ToString());
+    }
+
+    BOOST_CHECK_EQUAL(queue.size(), 0);
+    BOOST_CHECK(queue.Take(block_1.GetHash()) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(it_drops_the_oldest_compact_block_from_a_full_queue)
+{
+    CTxMemPool pool;
+    PartialBlockQueue queue;
+    std::vector<uint256> hashes;
+
+    for (size_t i = 0; i < PartialBlockQueue::MAX_BLOCKS; ++i) {
+        hashes.push_back(GetRandHash());
+        BOOST_CHECK(!queue.Add(hashes.back(), std::make_shared<PartiallyDownloadedBlock>(&pool)));
+    }
+
+    // A block that the queue already holds replaces itself:
+    BOOST_CHECK(!queue.Add(hashes.front(), std::make_shared<PartiallyDownloadedBlock>(&pool)));
+    BOOST_CHECK_EQUAL(queue.size(), PartialBlockQueue::MAX_BLOCKS);
+
+    // The re-added block moved to the back, so the second one is now oldest:
+    const std::optional<uint256> evicted = queue.Add(GetRandHash(), std::make_shared<PartiallyDownloadedBlock>(&pool));
+
+    BOOST_REQUIRE(evicted.has_value());
+    BOOST_CHECK_EQUAL(evicted->ToString(), hashes[1].ToString());
+    BOOST_CHECK(queue.Take(hashes[1]) == nullptr);
+    BOOST_CHECK(queue.Take(hashes.front()) != nullptr);
+    BOOST_CHECK_EQUAL(queue.size(), PartialBlockQueue::MAX_BLOCKS - 1);
+}
+
+BOOST_AUTO_TEST_CASE(it_rejects_a_compact_block_without_transactions)
+{
+    CTxMemPool pool;
+    PartiallyDownloadedBlock partial_block(&pool);
+    CBlockHeaderAndShortTxIDs cmpctblock;
+
+    cmpctblock.header.nBits = 0x1e0fffff;
+
+    BOOST_CHECK(partial_block.InitData(cmpctblock) == READ_STATUS_INVALID);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,161 @@
+// Copyright (c) 2014-2021 The Gridcoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "main.h"
+#include "gridcoin/accrual/snapshot.h"
+#include "util.h"
+
+#include <boost/test/unit_test.hpp>
+#include <vector>
+
+namespace {
+//!
+//! \brief Write a snapshot file in the unsorted version 1 format.
+//!
+uint256 WriteVersion1Snapshot(
+    const fs::path& path,
+    const uint64_t height,
+    const std::vector<AccrualSnapshot::Record>& records)
+{
+    CAutoHasherFile file(fsbridge::fopen(path, "wb"), SER_DISK, 1);
+
+    file << uint32_t { 1 } << height;
+
+    for (const auto& record : records) {
+        file << record.m_cpid << record.m_accrual;
+    }
+
+    return file.GetHash();
+}
+
+//!
+//! \brief Write a snapshot file in the current format.
+//!
+uint256 WriteCurrentSnapshot(
+    const fs::path& path,
+    const uint64_t height,
+    const std::vector<AccrualSnapshot::Record>& records)
+{
+    AccrualSnapshotWriter writer(path);
+
+    writer.WriteHeader(height, records.size());
+
+    for (const auto& record : records) {
+        writer.WriteRecord(record.m_cpid, record.m_accrual);
+    }
+
+    writer.WriteTrailer();
+
+    return writer.GetHash();
+}
+
+const Cpid CPID_1 = Cpid::Parse("00010203040506070809101112131415");
+const Cpid CPID_2 = Cpid::Parse("10010203040506070809101112131415");
+const Cpid CPID_3 = Cpid::Parse("f0010203040506070809101112131415");
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(AccrualSnapshot_tests)
+
+BOOST_AUTO_TEST_CASE(it_reads_records_from_a_current_snapshot_file)
+{
+    const fs::path path = GetDataDir() / "snapshot_current.dat";
+    const uint256 hash = WriteCurrentSnapshot(path, 123, { { CPID_1, 100 }, { CPID_2, 200 } });
+
+    AccrualSnapshotReader reader(path);
+    const AccrualSnapshot snapshot = reader.Read();
+
+    BOOST_CHECK_EQUAL(snapshot.m_version, AccrualSnapshot::CURRENT_VERSION);
+    BOOST_CHECK_EQUAL(snapshot.m_height, 123);
+    BOOST_REQUIRE_EQUAL(snapshot.size(), 2);
+    BOOST_CHECK(snapshot[0].m_cpid == CPID_1);
+    BOOST_CHECK_EQUAL(snapshot[0].m_accrual, 100);
+    BOOST_CHECK(snapshot[1].m_cpid == CPID_2);
+    BOOST_CHECK_EQUAL(snapshot[1].m_accrual, 200);
+
+    BOOST_CHECK_EQUAL(snapshot.GetAccrual(CPID_1), 100);
+    BOOST_CHECK_EQUAL(snapshot.GetAccrual(CPID_2), 200);
+    BOOST_CHECK_EQUAL(snapshot.GetAccrual(CPID_3), 0);
+
+    BOOST_CHECK_EQUAL(reader.GetHash().ToString(), hash.ToString());
+    BOOST_CHECK_EQUAL(AccrualSnapshotReader::Hash(path).ToString(), hash.ToString());
+
+    fs::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(it_reads_records_from_a_version_1_snapshot_file)
+{
+    const fs::path path = GetDataDir() / "snapshot_v1.dat";
+    const uint256 hash = WriteVersion1Snapshot(path, 456, {
+        { CPID_3, 300 },
+        { CPID_1, 100 },
+        { CPID_2, 200 },
+    });
+
+    AccrualSnapshotReader reader(path);
+    const AccrualSnapshot snapshot = reader.Read();
+
+    BOOST_CHECK_EQUAL(snapshot.m_version, 1);
+    BOOST_CHECK_EQUAL(snapshot.m_height, 456);
+    BOOST_REQUIRE_EQUAL(snapshot.size(), 3);
+    BOOST_CHECK(snapshot[0].m_cpid == CPID_1);
+    BOOST_CHECK(snapshot[1].m_cpid == CPID_2);
+    BOOST_CHECK(snapshot[2].m_cpid == CPID_3);
+
+    BOOST_CHECK_EQUAL(snapshot.GetAccrual(CPID_1), 100);
+    BOOST_CHECK_EQUAL(snapshot.GetAccrual(CPID_2), 200);
+    BOOST_CHECK_EQUAL(snapshot.GetAccrual(CPID_3), 300);
+
+    BOOST_CHECK_EQUAL(reader.GetHash().ToString(), hash.ToString());
+    BOOST_CHECK_EQUAL(AccrualSnapshotReader::Hash(path).ToString(), hash.ToString());
+
+    fs::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(it_rejects_a_current_snapshot_file_that_does_not_match_its_hash)
+{
+    const fs::path path = GetDataDir() / "snapshot_corrupt.dat";
+    WriteCurrentSnapshot(path, 789, { { CPID_1, 100 } });
+
+    {
+        FILE* file = fsbridge::fopen(path, "r+b");
+        BOOST_REQUIRE(file);
+        fseek(file, AccrualSnapshot::HEADER_SIZE + 16, SEEK_SET);
+        fputc(0xff, file);
+        fclose(file);
+    }
+
+    BOOST_CHECK_THROW(AccrualSnapshotReader(path).Read(), std::ios_base::failure);
+    BOOST_CHECK(AccrualSnapshotReader::Hash(path).IsNull());
+
+    fs::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(it_rejects_a_missing_snapshot_file)
+{
+    const fs::path path = GetDataDir() / "snapshot_missing.dat";
+    fs::remove(path);
+
+    AccrualSnapshotReader reader(path);
+
+    BOOST_CHECK(reader.IsNull());
+    BOOST_CHECK_THROW(reader.Read(), std::ios_base::failure);
+    BOOST_CHECK(AccrualSnapshotReader::Hash(path).IsNull());
+}
+
+BOOST_AUTO_TEST_CASE(it_rejects_a_snapshot_file_with_an_unknown_version)
+{
+    const fs::path path = GetDataDir() / "snapshot_v3.dat";
+
+    {
+        CAutoFile file(fsbridge::fopen(path, "wb"), SER_DISK, 1);
+        file << uint32_t { 3 } << uint64_t { 123 } << uint64_t { 0 } << uint256();
+    }
+
+    BOOST_CHECK_THROW(AccrualSnapshotReader(path).Read(), std::ios_base::failure);
+    BOOST_CHECK(AccrualSnapshotReader::Hash(path).IsNull());
+
+    fs::remove(path);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -88,4 +88,26 @@ BOOST_AUTO_TEST_CASE(FindBlockByTimeShouldReturnLastBlockIfOlderThanTime)
     BOOST_CHECK_EQUAL(&chain.blocks.back(), finder.FindByMinTime(999999));
 }
 
+BOOST_AUTO_TEST_CASE(ChainTipSnapshotShouldFindBlocksWithoutNextLinks)
+{
+    BlockChain<10> chain;
+    const uint256 tip_hash = uint256S("0123456789abcdef");
+    chain.blocks.back().phashBlock = &tip_hash;
+
+    const ChainTipSnapshot snapshot(&chain.blocks.back());
+
+    // A reorganization rewrites the next links. The snapshot must not use them:
+    for (auto& block : chain.blocks)
+        block.pnext = nullptr;
+
+    BOOST_CHECK_EQUAL(snapshot.m_height, 9);
+    BOOST_CHECK(snapshot.m_hash == tip_hash);
+
+    for (auto& block : chain.blocks)
+        BOOST_CHECK_EQUAL(&block, snapshot.GetAncestor(block.nHeight));
+
+    BOOST_CHECK(snapshot.GetAncestor(-1) == nullptr);
+    BOOST_CHECK(snapshot.GetAncestor(10) == nullptr);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
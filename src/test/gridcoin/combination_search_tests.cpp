@@ -0,0 +1,310 @@
+// Copyright (c) 2014-2021 The Gridcoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gridcoin/project_combiner.h"
+#include "gridcoin/support/combination_search.h"
+#include "streams.h"
+
+#include <algorithm>
+#include <atomic>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/test/unit_test.hpp>
+#include <limits>
+#include <optional>
+#include <random>
+#include <vector>
+
+using namespace GRC;
+
+namespace {
+//!
+//! \brief Compress the supplied CSV statistics as a scraper does for the
+//! data of a manifest project part.
+//!
+CDataStream CompressPart(const std::string& csv)
+{
+    std::string compressed;
+
+    {
+        boost::iostreams::filtering_ostream out;
+        out.push(boost::iostreams::gzip_compressor());
+        out.push(boost::iostreams::back_inserter(compressed));
+        out << csv;
+    }
+
+    CDataStream part(SER_NETWORK, PROTOCOL_VERSION);
+    part.write(compressed.data(), compressed.size());
+
+    return part;
+}
+
+//!
+//! \brief A manifest in the global manifest map with a beacon list part and
+//! the project part variants that the combiner tests resolve.
+//!
+//! Variants 0 and 1 produce the same project statistics from different part
+//! data. The other variants produce different project statistics.
+//!
+class TestManifest
+{
+public:
+    static constexpr size_t VARIANTS = 4;
+
+    TestManifest()
+        : m_hash(uint256S("c0b1000000000000000000000000000000000000000000000000000000000000"))
+    {
+        LOCK2(CScraperManifest::cs_mapManifest, CSplitBlob::cs_mapParts);
+
+        auto manifest = std::make_shared<CScraperManifest>();
+
+        manifest->addPartData(CompressPart("# beacon list\n"));
+
+        for (const char* const csv : {
+            "100,0,10,00010203040506070809101112131415\n100,0,30,10010203040506070809101112131415\n",
+            "100,0,30,00010203040506070809101112131415\n100,0,10,10010203040506070809101112131415\n",
+            "100,0,10,00010203040506070809101112131415\n100,0,50,10010203040506070809101112131415\n",
+            "200,0,10,00010203040506070809101112131415\n100,0,30,10010203040506070809101112131415\n",
+        }) {
+            manifest->addPartData(CompressPart(csv));
+        }
+
+        const auto it = CScraperManifest::mapManifest.emplace(m_hash, std::move(manifest));
+        it.first->second->phash = &it.first->first;
+    }
+
+    ~TestManifest()
+    {
+        LOCK(CScraperManifest::cs_mapManifest);
+
+        CScraperManifest::mapManifest.erase(m_hash);
+    }
+
+    const uint256& Hash() const
+    {
+        return m_hash;
+    }
+
+    CSplitBlob::CPart* BeaconList() const
+    {
+        return Manifest().vParts[0];
+    }
+
+    CSplitBlob::CPart* Variant(const size_t variant) const
+    {
+        return Manifest().vParts[1 + variant];
+    }
+
+private:
+    const uint256 m_hash;
+
+    const CScraperManifest& Manifest() const
+    {
+        LOCK(CScraperManifest::cs_mapManifest);
+
+        return *CScraperManifest::mapManifest.at(m_hash);
+    }
+};
+
+//!
+//! \brief Project part variants resolved for each project of a trial.
+//!
+using Groups = std::vector<std::vector<size_t>>;
+
+std::string ProjectName(const size_t index)
+{
+    return "project_" + std::to_string(index);
+}
+
+//!
+//! \brief Generate the stats of the full convergence of one variant for each
+//! project as a scraper does.
+//!
+ScraperStatsAndVerifiedBeacons StatsOf(const TestManifest& manifest, const std::vector<size_t>& variants)
+{
+    ConvergedManifest convergence;
+
+    for (size_t i = 0; i < variants.size(); ++i) {
+        convergence.ConvergedManifestPartPtrsMap.emplace(ProjectName(i), manifest.Variant(variants[i]));
+    }
+
+    convergence.ConvergedManifestPartPtrsMap.emplace("BeaconList", manifest.BeaconList());
+
+    return GetScraperStatsByConvergedManifest(convergence);
+}
+
+//!
+//! \brief Hash the full convergence of every combination in order, as the
+//! combiner did before it pruned parts, until one matches.
+//!
+bool UnprunedSearch(const TestManifest& manifest, const Groups& groups, const QuorumHash& target)
+{
+    std::vector<size_t> sizes;
+
+    for (const auto& group : groups) {
+        sizes.push_back(group.size());
+    }
+
+    const GRC::CombinationSearch search(sizes);
+
+    for (size_t i = 0; i < search.TotalCombinations(); ++i) {
+        const std::vector<size_t> selection = search.Decode(i);
+        std::vector<size_t> variants;
+
+        for (size_t j = 0; j < groups.size(); ++j) {
+            variants.push_back(groups[j][selection[j]]);
+        }
+
+        if (QuorumHash::Hash(StatsOf(manifest, variants)) == target) {
+            return true;
+        }
+    }
+
+    return false;
+}
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(CombinationSearch)
+
+BOOST_AUTO_TEST_CASE(it_numbers_combinations_in_mixed_radix_order)
+{
+    const GRC::CombinationSearch search({ 2, 3, 2 });
+
+    BOOST_CHECK_EQUAL(search.TotalCombinations(), 12);
+
+    const std::vector<size_t> first = search.Decode(0);
+    const std::vector<size_t> ninth = search.Decode(9);
+    const std::vector<size_t> last = search.Decode(11);
+
+    BOOST_CHECK((first == std::vector<size_t> { 0, 0, 0 }));
+    BOOST_CHECK((ninth == std::vector<size_t> { 1, 1, 1 }));
+    BOOST_CHECK((last == std::vector<size_t> { 1, 2, 1 }));
+}
+
+BOOST_AUTO_TEST_CASE(it_produces_no_combinations_for_an_empty_group)
+{
+    const GRC::CombinationSearch empty_group({ 2, 0, 2 });
+    const GRC::CombinationSearch no_groups({ });
+
+    BOOST_CHECK_EQUAL(empty_group.TotalCombinations(), 0);
+    BOOST_CHECK_EQUAL(no_groups.TotalCombinations(), 0);
+    BOOST_CHECK(!empty_group.FindFirst([](const std::vector<size_t>&) { return true; }));
+}
+
+BOOST_AUTO_TEST_CASE(it_finds_the_lowest_numbered_match_on_many_threads)
+{
+    const GRC::CombinationSearch search({ 4, 5, 6, 7 });
+
+    const std::optional<size_t> found = search.FindFirst([](const std::vector<size_t>& selection) {
+        return selection[1] >= 2 && selection[3] % 3 == 1;
+    }, 8);
+
+    BOOST_REQUIRE(found.has_value());
+    BOOST_CHECK_EQUAL(*found, 2 * 42 + 1);
+}
+
+BOOST_AUTO_TEST_CASE(it_stops_checking_combinations_after_an_early_match)
+{
+    const GRC::CombinationSearch search({ 1000, 1000 });
+    std::atomic<size_t> calls { 0 };
+
+    const std::optional<size_t> found = search.FindFirst([&](const std::vector<size_t>& selection) {
+        ++calls;
+        return selection[0] == 0 && selection[1] == 5;
+    }, 8);
+
+    BOOST_REQUIRE(found.has_value());
+    BOOST_CHECK_EQUAL(*found, 5);
+
+    // The other threads only finish the combinations that they claimed while
+    // the match was checked instead of all million:
+    BOOST_CHECK(calls.load() < 1000);
+}
+
+BOOST_AUTO_TEST_CASE(it_rejects_a_search_with_more_combinations_than_it_can_number)
+{
+    const size_t max = std::numeric_limits<size_t>::max();
+    const GRC::CombinationSearch search({ max, 2 });
+    bool called = false;
+
+    BOOST_CHECK(search.Saturated());
+    BOOST_CHECK_EQUAL(search.TotalCombinations(), max);
+    BOOST_CHECK(!search.FindFirst([&](const std::vector<size_t>&) { return called = true; }));
+    BOOST_CHECK(!called);
+
+    // An empty group leaves nothing to number no matter the other groups:
+    const GRC::CombinationSearch empty_group({ max, 2, 0 });
+
+    BOOST_CHECK(!empty_group.Saturated());
+    BOOST_CHECK_EQUAL(empty_group.TotalCombinations(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(ProjectCombiner)
+
+BOOST_AUTO_TEST_CASE(it_accepts_the_same_convergences_as_an_unpruned_search)
+{
+    const TestManifest manifest;
+    std::mt19937 rng(20210601);
+    size_t accepted = 0;
+
+    for (size_t trial = 0; trial < 100; ++trial) {
+        Groups groups(1 + rng() % 3);
+        std::map<std::string, ResolvedProject> projects;
+
+        // Resolve a few distinct variants for each project so that parts
+        // with the same stats but different data compete for a match:
+        //
+        for (size_t i = 0; i < groups.size(); ++i) {
+            std::vector<size_t> variants(TestManifest::VARIANTS);
+
+            for (size_t v = 0; v < variants.size(); ++v) {
+                variants[v] = v;
+            }
+
+            std::shuffle(variants.begin(), variants.end(), rng);
+            groups[i].assign(variants.begin(), variants.begin() + 1 + rng() % 3);
+
+            ResolvedProject& project = projects[ProjectName(i)];
+
+            for (const size_t variant : groups[i]) {
+                project.LinkPart(ResolvedPart(manifest.Variant(variant)->hash, manifest.Hash(), 1));
+            }
+        }
+
+        std::vector<size_t> target;
+
+        for (const auto& group : groups) {
+            if (trial % 2 == 0) {
+                target.push_back(group[rng() % group.size()]);
+            } else {
+                target.push_back(rng() % TestManifest::VARIANTS);
+            }
+        }
+
+        const ScraperStatsAndVerifiedBeacons stats = StatsOf(manifest, target);
+        const Superblock superblock = Superblock::FromStats(stats);
+        const QuorumHash quorum_hash = QuorumHash::Hash(stats);
+
+        const bool expected = UnprunedSearch(manifest, groups, quorum_hash);
+
+        GRC::ProjectCombiner combiner(std::move(projects));
+        const size_t total_before_pruning = combiner.TotalCombinations();
+
+        combiner.Prune(superblock);
+
+        BOOST_CHECK(combiner.TotalCombinations() <= total_before_pruning);
+        BOOST_CHECK_EQUAL(combiner.FindMatch(quorum_hash), expected);
+
+        accepted += expected;
+    }
+
+    // Both outcomes occur:
+    BOOST_CHECK(accepted > 0);
+    BOOST_CHECK(accepted < 100);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,157 @@
+// Copyright (c) 2014-2021 The Gridcoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "arith_uint256.h"
+#include "bignum.h"
+#include "gridcoin/staking/kernel.h"
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+//!
+//! \brief Create a transaction with a few outputs to stake.
+//!
+CTransaction GetStakeTx()
+{
+    CTransaction tx;
+
+    tx.nTime = 1600000000;
+    tx.vout.emplace_back(1000 * COIN, CScript());
+    tx.vout.emplace_back(2500 * COIN, CScript());
+    tx.vout.emplace_back(12345678, CScript());
+
+    return tx;
+}
+
+//!
+//! \brief Check a stake kernel hash against a weighted target with the big
+//! number arithmetic that the fixed-width comparison replaces.
+//!
+bool CheckStakeKernelHashBigNum(const uint256& hash, unsigned int nBits, int64_t Weight)
+{
+    CBigNum target;
+    target.SetCompact(nBits);
+    target *= Weight;
+
+    return CBigNum(hash) <= target;
+}
+} // anonymous namespace
+
+// -----------------------------------------------------------------------------
+// StakeKernelPrefix
+// -----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE(StakeKernelPrefix)
+
+BOOST_AUTO_TEST_CASE(it_hashes_the_same_kernel_as_the_v8_stake_hash)
+{
+    const CTransaction tx = GetStakeTx();
+    const uint64_t stake_modifier = 0x0123456789abcdef;
+    const unsigned int block_time = 1600000123;
+
+    for (unsigned int n = 0; n < tx.vout.size(); ++n) {
+        const GRC::StakeKernelPrefix prefix(stake_modifier, block_time, tx.GetHash(), n);
+
+        for (unsigned int time_tx = 1600100000; time_tx < 1600100100; time_tx += 7) {
+            BOOST_CHECK_EQUAL(
+                prefix.Hash(time_tx).ToString(),
+                GRC::CalculateStakeHashV8(block_time, tx, n, time_tx, stake_modifier).ToString());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(it_applies_the_stake_time_mask)
+{
+    const CTransaction tx = GetStakeTx();
+    const GRC::StakeKernelPrefix prefix(1, 1600000000, tx.GetHash(), 0);
+    const GRC::StakeKernelPrefix prefix_masked(1, 1600000000 + GRC::STAKE_TIMESTAMP_MASK, tx.GetHash(), 0);
+
+    BOOST_CHECK(prefix.Hash(1600100000) == prefix_masked.Hash(1600100000));
+    BOOST_CHECK(prefix.Hash(1600100000) == prefix.Hash(1600100000 + GRC::STAKE_TIMESTAMP_MASK));
+    BOOST_CHECK(prefix.Hash(1600100000) != prefix.Hash(1600100000 + GRC::STAKE_TIMESTAMP_MASK + 1));
+}
+
+BOOST_AUTO_TEST_CASE(it_hashes_batches_of_kernels_like_single_kernels)
+{
+    const CTransaction tx = GetStakeTx();
+    std::vector<GRC::StakeKernelPrefix> prefixes;
+
+    // Cover the 8-way, 4-way, and single hash paths with a remainder:
+    for (unsigned int i = 0; i < 13; ++i) {
+        prefixes.emplace_back(0x0123456789abcdef + i, 1600000000 + i * 16, tx.GetHash(), i % tx.vout.size());
+    }
+
+    for (size_t count = 0; count <= prefixes.size(); ++count) {
+        std::vector<const GRC::StakeKernelPrefix*> kernels;
+
+        for (size_t i = 0; i < count; ++i) {
+            kernels.push_back(&prefixes[i]);
+        }
+
+        const std::vector<uint256> hashes = GRC::CalculateStakeHashesV8(kernels, 1600100000);
+
+        BOOST_REQUIRE_EQUAL(hashes.size(), count);
+
+        for (size_t i = 0; i < count; ++i) {
+            BOOST_CHECK_EQUAL(hashes[i].ToString(), prefixes[i].Hash(1600100000).ToString());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+// -----------------------------------------------------------------------------
+// CheckStakeKernelHashV8
+// -----------------------------------------------------------------------------
+
+BOOST_AUTO_TEST_SUITE(CheckStakeKernelHashV8)
+
+BOOST_AUTO_TEST_CASE(it_matches_the_big_number_target_comparison)
+{
+    const uint32_t mantissas[] = {
+        0x000000, 0x000001, 0x0000ff, 0x00ffff, 0x007fff, 0x123456,
+        0x7fffff, 0x800000, 0x800001, 0x8000ff, 0xffffff,
+    };
+
+    const int64_t weights[] = {
+        0, 1, -1, 7, -12345, 1000 * COIN, 0x7fffffff, 0x100000000,
+        std::numeric_limits<int64_t>::max(),
+        std::numeric_limits<int64_t>::min() + 1,
+    };
+
+    const uint256 max_hash_bytes = ArithToUint256(~arith_uint256());
+    const CBigNum max_hash(max_hash_bytes);
+
+    for (unsigned int size = 0; size <= 40; ++size) {
+        for (const auto& mantissa : mantissas) {
+            const unsigned int bits = (size << 24) | mantissa;
+
+            for (const auto& weight : weights) {
+                CBigNum target;
+                target.SetCompact(bits);
+                target *= weight;
+
+                std::vector<uint256> hashes { uint256(), ArithToUint256(1), max_hash_bytes };
+
+                if (target > 0 && target <= max_hash) {
+                    hashes.push_back(target.getuint256());
+                    hashes.push_back((target - 1).getuint256());
+
+                    if (target < max_hash) {
+                        hashes.push_back((target + 1).getuint256());
+                    }
+                }
+
+                for (const auto& hash : hashes) {
+                    BOOST_CHECK_MESSAGE(
+                        GRC::CheckStakeKernelHashV8(hash, bits, weight)
+                            == CheckStakeKernelHashBigNum(hash, bits, weight),
+                        "bits " << bits << " weight " << weight << " hash " << hash.ToString());
+                }
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
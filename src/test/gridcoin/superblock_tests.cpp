@@ -4,6 +4,7 @@
 
 #include "base58.h"
 #include "compat/endian.h"
+#include "crypto/common.h"
 #include "gridcoin/scraper/scraper_net.h"
 #include "gridcoin/superblock.h"
 #include "gridcoin/support/xml.h"
@@ -13,6 +14,7 @@
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/test/unit_test.hpp>
 #include <iostream>
+#include <map>
 #include <openssl/md5.h>
 #include <vector>
 
@@ -1302,6 +1304,101 @@ BOOST_AUTO_TEST_CASE(it_assumes_zero_magnitude_for_a_nonexistent_cpid)
     BOOST_CHECK(cpids.MagnitudeOf(cpid) == 0);
 }
 
+BOOST_AUTO_TEST_CASE(it_looks_up_magnitudes_in_every_segment_of_a_large_index)
+{
+    GRC::Superblock::CpidIndex cpids;
+    std::map<GRC::Cpid, GRC::Magnitude> expected;
+    std::vector<GRC::Cpid> absent;
+
+    // Odd CPIDs receive magnitudes from each size category. Even CPIDs stay
+    // absent to check the misses between and around the indexed CPIDs:
+    //
+    for (uint32_t i = 0; i < 60000; ++i) {
+        std::vector<unsigned char> bytes(16, 0);
+        WriteBE32(bytes.data(), i * 2654435761U);
+        WriteBE32(bytes.data() + 12, i);
+
+        const GRC::Cpid cpid(bytes);
+
+        if (i % 2 == 0) {
+            absent.push_back(cpid);
+            continue;
+        }
+
+        const GRC::Magnitude magnitude = GRC::Magnitude::RoundFrom((i % 5000) / 7.0);
+
+        expected.emplace(cpid, magnitude);
+    }
+
+    // Scraper statistics add CPIDs in sorted order:
+    for (const auto& entry : expected) {
+        cpids.Add(entry.first, entry.second);
+    }
+
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << cpids;
+
+    GRC::Superblock::CpidIndex deserialized;
+    stream >> deserialized;
+
+    BOOST_REQUIRE_EQUAL(cpids.size(), expected.size());
+    BOOST_REQUIRE_EQUAL(deserialized.size(), expected.size());
+
+    for (const auto& entry : expected) {
+        BOOST_REQUIRE(cpids.MagnitudeOf(entry.first) == entry.second);
+        BOOST_REQUIRE(deserialized.MagnitudeOf(entry.first) == entry.second);
+    }
+
+    for (const auto& cpid : absent) {
+        BOOST_REQUIRE(cpids.MagnitudeOf(cpid) == 0);
+        BOOST_REQUIRE(deserialized.MagnitudeOf(cpid) == 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(it_looks_up_magnitudes_of_cpids_added_out_of_order)
+{
+    GRC::Superblock::CpidIndex cpids;
+
+    const GRC::Cpid cpid1 = GRC::Cpid::Parse("00010203040506070809101112131415");
+    const GRC::Cpid cpid2 = GRC::Cpid::Parse("15141312111009080706050403020100");
+    const GRC::Cpid cpid3 = GRC::Cpid::Parse("f5141312111009080706050403020100");
+
+    cpids.Add(cpid3, GRC::Magnitude::RoundFrom(0.5));
+    cpids.Add(cpid1, GRC::Magnitude::RoundFrom(123));
+    cpids.Add(cpid2, GRC::Magnitude::RoundFrom(4.5));
+
+    BOOST_CHECK(cpids.MagnitudeOf(cpid1) == 123);
+    BOOST_CHECK(cpids.MagnitudeOf(cpid2) == 4.5);
+    BOOST_CHECK(cpids.MagnitudeOf(cpid3) == 0.5);
+    BOOST_CHECK(cpids.MagnitudeOf(GRC::Cpid()) == 0);
+
+    // Adding a CPID after a lookup sorts the table again on the next one:
+    const GRC::Cpid cpid4 = GRC::Cpid::Parse("05141312111009080706050403020100");
+
+    cpids.Add(cpid4, GRC::Magnitude::RoundFrom(7));
+
+    BOOST_CHECK(cpids.MagnitudeOf(cpid4) == 7);
+    BOOST_CHECK(cpids.MagnitudeOf(cpid1) == 123);
+}
+
+BOOST_AUTO_TEST_CASE(it_looks_up_magnitudes_in_a_copy_of_an_unsorted_index)
+{
+    GRC::Superblock::CpidIndex cpids;
+
+    const GRC::Cpid cpid1 = GRC::Cpid::Parse("00010203040506070809101112131415");
+    const GRC::Cpid cpid2 = GRC::Cpid::Parse("15141312111009080706050403020100");
+
+    cpids.Add(cpid2, GRC::Magnitude::RoundFrom(0.5));
+    cpids.Add(cpid1, GRC::Magnitude::RoundFrom(123));
+
+    const GRC::Superblock::CpidIndex copy = cpids;
+
+    BOOST_CHECK(copy.MagnitudeOf(cpid1) == 123);
+    BOOST_CHECK(copy.MagnitudeOf(cpid2) == 0.5);
+    BOOST_CHECK(cpids.MagnitudeOf(cpid1) == 123);
+    BOOST_CHECK(cpids.MagnitudeOf(cpid2) == 0.5);
+}
+
 BOOST_AUTO_TEST_CASE(it_counts_the_number_of_active_cpids)
 {
     GRC::Superblock::CpidIndex cpids;
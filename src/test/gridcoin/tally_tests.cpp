@@ -0,0 +1,297 @@
+// Copyright (c) 2014-2021 The Gridcoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "main.h"
+#include "gridcoin/accrual/snapshot.h"
+#include "gridcoin/tally.h"
+#include "util.h"
+
+#include <boost/test/unit_test.hpp>
+#include <deque>
+
+using namespace GRC;
+
+namespace {
+//!
+//! \brief Height of the first block in the test chains. Research age applies,
+//! but snapshot accrual (block version 11) does not.
+//!
+constexpr int BASE_HEIGHT = 400000;
+
+const Cpid CPID_1 = Cpid::Parse("00010203040506070809101112131415");
+const Cpid CPID_2 = Cpid::Parse("10010203040506070809101112131415");
+
+//!
+//! \brief A main chain of block index entries for the tally to scan.
+//!
+class TallyChain
+{
+public:
+    explicit TallyChain(const size_t length)
+        : m_saved_best(pindexBest)
+        , m_saved_height(nBestHeight)
+    {
+        for (size_t i = 0; i < length; ++i) {
+            Extend("a");
+        }
+    }
+
+    ~TallyChain()
+    {
+        for (auto& block : m_blocks) {
+            mapBlockIndex.erase(block.GetBlockHash());
+        }
+
+        pindexBest = m_saved_best;
+        nBestHeight = m_saved_height;
+    }
+
+    //!
+    //! \brief Replace the blocks above the specified offset with a fork of
+    //! the same length.
+    //!
+    void Reorganize(const int fork_offset)
+    {
+        const int tip_height = pindexBest->nHeight;
+
+        pindexBest = At(fork_offset);
+
+        for (CBlockIndex* pindex = pindexBest; pindex; ) {
+            CBlockIndex* const pnext = pindex->pnext;
+            pindex->pnext = nullptr;
+            pindex = pnext;
+        }
+
+        while (pindexBest->nHeight < tip_height) {
+            Extend("b");
+        }
+    }
+
+    //!
+    //! \brief Get the main chain block at the specified offset from the first
+    //! block.
+    //!
+    CBlockIndex* At(const int offset)
+    {
+        CBlockIndex* pindex = pindexBest;
+
+        while (pindex && pindex->nHeight > BASE_HEIGHT + offset) {
+            pindex = pindex->pprev;
+        }
+
+        return pindex;
+    }
+
+    //!
+    //! \brief Set a research reward on the main chain block at the specified
+    //! offset.
+    //!
+    CBlockIndex* Reward(const int offset, const Cpid cpid, const CAmount subsidy)
+    {
+        CBlockIndex* const pindex = At(offset);
+        pindex->SetResearcherContext(MiningId(cpid), subsidy, 10);
+
+        return pindex;
+    }
+
+private:
+    std::deque<CBlockIndex> m_blocks;
+    CBlockIndex* m_saved_best;
+    int m_saved_height;
+
+    void Extend(const char* const branch)
+    {
+        const int offset = m_blocks.empty() ? 0 : pindexBest->nHeight - BASE_HEIGHT + 1;
+
+        m_blocks.emplace_back();
+        CBlockIndex& block = m_blocks.back();
+
+        block.nHeight = BASE_HEIGHT + offset;
+        block.nTime = 1600000000 + offset * 90;
+        block.pprev = offset > 0 ? pindexBest : nullptr;
+        block.phashBlock = &mapBlockIndex.emplace(
+            uint256S(strprintf("%s7a11%04d", branch, offset)),
+            &block).first->first;
+
+        if (block.pprev) {
+            block.pprev->pnext = &block;
+        }
+
+        pindexBest = &block;
+        nBestHeight = block.nHeight;
+    }
+};
+
+//!
+//! \brief Create research accounts for reward blocks in the test chain.
+//!
+ResearchAccountMap MakeAccounts(TallyChain& chain)
+{
+    ResearchAccountMap accounts;
+
+    ResearchAccount& account_1 = accounts[CPID_1];
+    account_1.m_total_research_subsidy = 999 * COIN;
+    account_1.m_total_magnitude = 20;
+    account_1.m_accuracy = 2;
+    account_1.m_first_block_ptr = chain.At(2);
+    account_1.m_last_block_ptr = chain.At(5);
+
+    ResearchAccount& account_2 = accounts[CPID_2];
+    account_2.m_total_research_subsidy = 3 * COIN;
+    account_2.m_total_magnitude = 10;
+    account_2.m_accuracy = 1;
+    account_2.m_first_block_ptr = chain.At(3);
+    account_2.m_last_block_ptr = chain.At(3);
+
+    // Accounts without reward blocks do not belong in a checkpoint:
+    accounts[Cpid::Parse("f0010203040506070809101112131415")] = ResearchAccount(123);
+
+    return accounts;
+}
+
+//!
+//! \brief Invert one byte of the checkpoint file.
+//!
+//! \param offset Position of the byte from the start of the file, or from
+//! the end of the file if negative.
+//!
+void CorruptCheckpoint(const long offset)
+{
+    FILE* file = fsbridge::fopen(TallyCheckpointPath(), "rb+");
+    BOOST_REQUIRE(file != nullptr);
+
+    BOOST_REQUIRE(fseek(file, offset, offset < 0 ? SEEK_END : SEEK_SET) == 0);
+    const int byte = fgetc(file);
+    BOOST_REQUIRE(byte != EOF);
+
+    BOOST_REQUIRE(fseek(file, -1, SEEK_CUR) == 0);
+    BOOST_REQUIRE(fputc(~byte & 0xff, file) != EOF);
+
+    fclose(file);
+}
+
+//!
+//! \brief Check that loading the checkpoint fails and leaves the supplied
+//! accounts unchanged.
+//!
+void CheckRejected()
+{
+    ResearchAccountMap accounts;
+    accounts[CPID_2].m_total_research_subsidy = 1;
+
+    BOOST_CHECK(TallyCheckpoint::Load(accounts) == nullptr);
+    BOOST_CHECK_EQUAL(accounts.size(), 1);
+    BOOST_CHECK_EQUAL(accounts[CPID_2].m_total_research_subsidy, 1);
+}
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(tally_tests)
+
+BOOST_AUTO_TEST_CASE(it_loads_the_research_accounts_in_a_checkpoint_that_it_stored)
+{
+    TallyChain chain(10);
+    LOCK(cs_main);
+
+    fs::create_directories(TallyCheckpointPath().parent_path());
+    BOOST_REQUIRE(TallyCheckpoint::Store(chain.At(6), MakeAccounts(chain)));
+
+    ResearchAccountMap accounts;
+    BOOST_CHECK_EQUAL(TallyCheckpoint::Load(accounts), chain.At(6));
+    BOOST_REQUIRE_EQUAL(accounts.size(), 2);
+
+    const ResearchAccount& account_1 = accounts[CPID_1];
+    BOOST_CHECK_EQUAL(account_1.m_total_research_subsidy, 999 * COIN);
+    BOOST_CHECK_EQUAL(account_1.m_total_magnitude, 20);
+    BOOST_CHECK_EQUAL(account_1.m_accuracy, 2);
+    BOOST_CHECK_EQUAL(account_1.m_first_block_ptr, chain.At(2));
+    BOOST_CHECK_EQUAL(account_1.m_last_block_ptr, chain.At(5));
+
+    const ResearchAccount& account_2 = accounts[CPID_2];
+    BOOST_CHECK_EQUAL(account_2.m_total_research_subsidy, 3 * COIN);
+    BOOST_CHECK_EQUAL(account_2.m_total_magnitude, 10);
+    BOOST_CHECK_EQUAL(account_2.m_accuracy, 1);
+    BOOST_CHECK_EQUAL(account_2.m_first_block_ptr, chain.At(3));
+    BOOST_CHECK_EQUAL(account_2.m_last_block_ptr, chain.At(3));
+
+    fs::remove(TallyCheckpointPath());
+}
+
+BOOST_AUTO_TEST_CASE(it_rejects_a_checkpoint_that_does_not_match_its_hash)
+{
+    TallyChain chain(10);
+    LOCK(cs_main);
+
+    fs::create_directories(TallyCheckpointPath().parent_path());
+    BOOST_REQUIRE(TallyCheckpoint::Store(chain.At(6), MakeAccounts(chain)));
+
+    // The research subsidy of the first account follows the version (4), the
+    // block hash (32), the height (4), the account count (1), and the CPID:
+    CorruptCheckpoint(4 + 32 + 4 + 1 + 16);
+    CheckRejected();
+
+    fs::remove(TallyCheckpointPath());
+}
+
+BOOST_AUTO_TEST_CASE(it_rejects_a_checkpoint_that_does_not_match_its_trailer)
+{
+    TallyChain chain(10);
+    LOCK(cs_main);
+
+    fs::create_directories(TallyCheckpointPath().parent_path());
+    BOOST_REQUIRE(TallyCheckpoint::Store(chain.At(6), MakeAccounts(chain)));
+
+    CorruptCheckpoint(-1);
+    CheckRejected();
+
+    fs::remove(TallyCheckpointPath());
+}
+
+BOOST_AUTO_TEST_CASE(it_rejects_a_checkpoint_for_a_block_that_left_the_main_chain)
+{
+    TallyChain chain(10);
+    LOCK(cs_main);
+
+    fs::create_directories(TallyCheckpointPath().parent_path());
+    BOOST_REQUIRE(TallyCheckpoint::Store(chain.At(6), MakeAccounts(chain)));
+
+    chain.Reorganize(5);
+    CheckRejected();
+
+    fs::remove(TallyCheckpointPath());
+}
+
+BOOST_AUTO_TEST_CASE(it_scans_every_reward_block_when_the_checkpoint_left_the_main_chain)
+{
+    TallyChain chain(10);
+    LOCK(cs_main);
+
+    chain.Reward(2, CPID_1, 100 * COIN);
+    chain.Reward(5, CPID_1, 200 * COIN);
+
+    fs::create_directories(TallyCheckpointPath().parent_path());
+    BOOST_REQUIRE(TallyCheckpoint::Store(chain.At(6), MakeAccounts(chain)));
+
+    // The fork drops the reward block at 5 and the checkpoint block:
+    chain.Reorganize(4);
+    chain.Reward(7, CPID_1, 400 * COIN);
+
+    BOOST_REQUIRE(Tally::Initialize(chain.At(0)));
+
+    const ResearchAccount& account = Tally::GetAccount(CPID_1);
+
+    BOOST_CHECK_EQUAL(account.m_total_research_subsidy, 500 * COIN);
+    BOOST_CHECK_EQUAL(account.m_total_magnitude, 20);
+    BOOST_CHECK_EQUAL(account.m_accuracy, 2);
+    BOOST_CHECK_EQUAL(account.m_first_block_ptr, chain.At(2));
+    BOOST_CHECK_EQUAL(account.m_last_block_ptr, chain.At(7));
+
+    // Reset the global tally before the test chain goes away:
+    Tally::ForgetRewardBlock(chain.At(7));
+    Tally::ForgetRewardBlock(chain.At(2));
+    Tally::PublishSnapshot(nullptr);
+
+    BOOST_CHECK(Tally::GetAccount(CPID_1).m_first_block_ptr == nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
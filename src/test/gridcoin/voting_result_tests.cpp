@@ -0,0 +1,223 @@
+// Copyright (c) 2014-2021 The Gridcoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "main.h"
+#include "gridcoin/voting/poll.h"
+#include "gridcoin/voting/result.h"
+#include "txdb.h"
+
+#include <boost/test/unit_test.hpp>
+#include <deque>
+
+using namespace GRC;
+
+namespace {
+constexpr int64_t POLL_TIME = 1600000000;
+constexpr int64_t POLL_EXPIRATION = POLL_TIME + 86400;
+constexpr int64_t BLOCK_SPACING = 64;
+
+//!
+//! \brief A main chain of block index entries with timestamps around the
+//! expiration of the test poll.
+//!
+//! Block 20 is the last block in the poll window. The median time past of a
+//! block is the timestamp of the block five below it, so block 26 closes the
+//! window.
+//!
+class PollChain
+{
+public:
+    explicit PollChain(const size_t length)
+        : m_saved_best(pindexBest)
+        , m_saved_height(nBestHeight)
+    {
+        for (size_t i = 0; i < length; ++i) {
+            Extend("a");
+        }
+    }
+
+    ~PollChain()
+    {
+        for (auto& block : m_blocks) {
+            mapBlockIndex.erase(block.GetBlockHash());
+        }
+
+        pindexBest = m_saved_best;
+        nBestHeight = m_saved_height;
+    }
+
+    //!
+    //! \brief Replace the blocks above the specified height with a fork of
+    //! the same length.
+    //!
+    void Reorganize(const int fork_height)
+    {
+        const int tip_height = pindexBest->nHeight;
+
+        pindexBest = At(fork_height);
+
+        for (CBlockIndex* pindex = pindexBest; pindex; ) {
+            CBlockIndex* const pnext = pindex->pnext;
+            pindex->pnext = nullptr;
+            pindex = pnext;
+        }
+
+        while (pindexBest->nHeight < tip_height) {
+            Extend("b");
+        }
+    }
+
+    CBlockIndex* At(const int height)
+    {
+        CBlockIndex* pindex = pindexBest;
+
+        while (pindex && pindex->nHeight > height) {
+            pindex = pindex->pprev;
+        }
+
+        return pindex;
+    }
+
+private:
+    std::deque<CBlockIndex> m_blocks;
+    CBlockIndex* m_saved_best;
+    int m_saved_height;
+
+    void Extend(const char* const branch)
+    {
+        const int height = m_blocks.empty() ? 0 : pindexBest->nHeight + 1;
+
+        m_blocks.emplace_back();
+        CBlockIndex& block = m_blocks.back();
+
+        block.nHeight = height;
+        block.nTime = POLL_EXPIRATION + (height - 20) * BLOCK_SPACING;
+        block.pprev = height > 0 ? pindexBest : nullptr;
+        block.phashBlock = &mapBlockIndex.emplace(
+            uint256S(strprintf("%s0ca1%04d", branch, height)),
+            &block).first->first;
+
+        if (block.pprev) {
+            block.pprev->pnext = &block;
+        }
+
+        pindexBest = &block;
+        nBestHeight = height;
+    }
+};
+
+Poll MakePoll()
+{
+    return Poll(
+        PollType::SURVEY,
+        PollWeightType::BALANCE,
+        PollResponseType::YES_NO_ABSTAIN,
+        1,
+        "title",
+        "url",
+        "question",
+        Poll::ChoiceList(),
+        POLL_TIME);
+}
+
+PollResult MakeResult()
+{
+    PollResult result(MakePoll());
+    PollResult::VoteDetail detail;
+
+    detail.m_amount = 123 * COIN;
+    detail.m_responses.emplace_back(1, 123 * COIN);
+
+    result.TallyVote(std::move(detail));
+
+    return result;
+}
+} // anonymous namespace
+
+BOOST_AUTO_TEST_SUITE(voting_result_tests)
+
+BOOST_AUTO_TEST_CASE(it_keeps_results_of_open_polls_current_only_until_the_tip_changes)
+{
+    PollChain chain(25);
+    LOCK(cs_main);
+
+    const CachedPollResult cached(MakeResult(), false);
+
+    BOOST_CHECK(!cached.m_frozen);
+    BOOST_CHECK(cached.IsCurrent());
+
+    CTxDB txdb("r");
+    BOOST_CHECK(PollResultArchive::Load(txdb, uint256S("0fe1"), MakePoll()) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(it_freezes_results_on_the_block_that_closes_the_poll_window)
+{
+    PollChain chain(40);
+    LOCK(cs_main);
+
+    const CachedPollResult cached(MakeResult(), false);
+
+    BOOST_CHECK(cached.m_frozen);
+    BOOST_CHECK_EQUAL(cached.m_pindex, chain.At(26));
+    BOOST_CHECK(cached.IsCurrent());
+
+    // A fork after the last block in the window can add blocks to it:
+    chain.Reorganize(22);
+
+    BOOST_CHECK(!cached.IsCurrent());
+}
+
+BOOST_AUTO_TEST_CASE(it_loads_an_archived_result_that_it_stored)
+{
+    PollChain chain(40);
+    LOCK(cs_main);
+
+    const uint256 txid = uint256S("0fe2");
+    const CachedPollResult cached(MakeResult(), false);
+
+    BOOST_REQUIRE(cached.m_frozen);
+    BOOST_REQUIRE(PollResultArchive::Store(txid, cached));
+
+    CTxDB txdb("r");
+    const auto loaded = PollResultArchive::Load(txdb, txid, MakePoll());
+
+    BOOST_REQUIRE(loaded != nullptr);
+    BOOST_CHECK(loaded->m_frozen);
+    BOOST_CHECK_EQUAL(loaded->m_pindex, chain.At(26));
+    BOOST_CHECK_EQUAL(loaded->m_result.m_total_weight, 123 * COIN);
+    BOOST_CHECK_EQUAL(loaded->m_result.m_invalid_votes, 0);
+    BOOST_REQUIRE_EQUAL(loaded->m_result.m_responses.size(), 3);
+    BOOST_CHECK_EQUAL(loaded->m_result.m_responses[0].m_weight, 0);
+    BOOST_CHECK_EQUAL(loaded->m_result.m_responses[1].m_weight, 123 * COIN);
+    BOOST_CHECK_EQUAL(loaded->m_result.m_responses[1].m_votes, 1.0);
+    BOOST_REQUIRE_EQUAL(loaded->m_result.m_votes.size(), 1);
+    BOOST_CHECK_EQUAL(loaded->m_result.m_votes[0].m_amount, 123 * COIN);
+}
+
+BOOST_AUTO_TEST_CASE(it_ignores_an_archived_result_when_its_closing_block_leaves_the_main_chain)
+{
+    PollChain chain(40);
+    LOCK(cs_main);
+
+    const uint256 txid = uint256S("0fe3");
+
+    BOOST_REQUIRE(PollResultArchive::Store(txid, CachedPollResult(MakeResult(), false)));
+
+    // The fork keeps the last block in the window but replaces the block
+    // that closed it:
+    chain.Reorganize(22);
+
+    CTxDB txdb("r");
+    BOOST_CHECK(PollResultArchive::Load(txdb, txid, MakePoll()) == nullptr);
+
+    // A tally on the new chain replaces the stale result:
+    BOOST_REQUIRE(PollResultArchive::Store(txid, CachedPollResult(MakeResult(), false)));
+
+    const auto loaded = PollResultArchive::Load(txdb, txid, MakePoll());
+
+    BOOST_REQUIRE(loaded != nullptr);
+    BOOST_CHECK_EQUAL(loaded->m_pindex, chain.At(26));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -20,8 +20,13 @@ extern void noui_connect();
 extern leveldb::Options GetOptions();
 
 struct TestingSetup {
+    fs::path pathTemp;
     TestingSetup() {
         fPrintToDebugger = true; // don't want to write to debug.log file
+        // Keep the files that the tests write out of the production data directory:
+        pathTemp = fs::temp_directory_path() / fs::unique_path("test_gridcoin_%%%%%%%%");
+        fs::create_directories(pathTemp);
+        ForceSetArg("-datadir", pathTemp.string());
         fUseFastIndex = true; // Don't verify block hashes when loading
         SelectParams(CBaseChainParams::MAIN);
         // TODO: Refactor CTxDB to something like bitcoin's current CDBWrapper and remove this workaround.
@@ -49,6 +54,7 @@ struct TestingSetup {
         g_banman.reset();
         delete txdb;
         txdb = nullptr;
+        fs::remove_all(pathTemp);
     }
 };
 
@@ -5,7 +5,9 @@
 #include "main.h"
 #include "wallet/wallet.h"
 #include "util.h"
+#include "util/parallel.h"
 
+#include <atomic>
 #include <cstdint>
 
 using namespace std;
@@ -695,4 +697,57 @@ BOOST_AUTO_TEST_CASE(util_mapArgsComparator)
 }
 
 
+BOOST_AUTO_TEST_CASE(util_ParallelFor)
+{
+    std::vector<int> out(1000, 0);
+
+    ParallelFor(out.size(), [&](const size_t i) { out[i] = i * 2; }, 4);
+
+    for (size_t i = 0; i < out.size(); ++i) {
+        BOOST_CHECK_EQUAL(out[i], i * 2);
+    }
+
+    std::atomic<size_t> calls { 0 };
+
+    ParallelFor(0, [&](const size_t) { ++calls; });
+    BOOST_CHECK_EQUAL(calls.load(), 0);
+
+    ParallelFor(1, [&](const size_t) { ++calls; });
+    BOOST_CHECK_EQUAL(calls.load(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(util_ParallelFor_rethrows)
+{
+    BOOST_CHECK_THROW(
+        ParallelFor(100, [](const size_t i) {
+            if (i == 42) throw std::runtime_error("test");
+        }, 4),
+        std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(util_ParallelForUntil_stops_claiming_indexes)
+{
+    std::vector<std::atomic<bool>> seen(100000);
+    std::atomic<size_t> calls { 0 };
+
+    ParallelForUntil(seen.size(), [&](const size_t i) {
+        seen[i] = true;
+        ++calls;
+
+        return i == 10;
+    }, 4);
+
+    // Each index below the one that stopped ran. The other workers finish the
+    // indexes they claimed before the stop, but nowhere near the whole range:
+    for (size_t i = 0; i <= 10; ++i) {
+        BOOST_CHECK(seen[i]);
+    }
+
+    BOOST_CHECK(calls.load() < 1000);
+
+    calls = 0;
+    ParallelForUntil(100, [&](const size_t i) { ++calls; return i == 10; }, 1);
+    BOOST_CHECK_EQUAL(calls.load(), 11);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
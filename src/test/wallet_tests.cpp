@@ -1,7 +1,10 @@
 #include <boost/test/unit_test.hpp>
 
+#include "consensus/merkle.h"
 #include "main.h"
+#include "txdb.h"
 #include "wallet/wallet.h"
+#include "wallet/walletdb.h"
 
 // how many times to run all the tests to have a chance to catch errors that only show up with particular random shuffles
 #define RUN_TESTS 100
@@ -54,6 +57,106 @@ static bool equal_sets(CoinSet a, CoinSet b)
     return ret.first == a.end() && ret.second == b.end();
 }
 
+// A main chain of block index entries for the tests that need transaction
+// depths. The chain globals are restored when it goes out of scope.
+struct TestChain
+{
+    vector<CBlockIndex> vIndex;
+    CBlockIndex* pindexBestSaved;
+    int nBestHeightSaved;
+
+    TestChain(int nBlocks) : vIndex(nBlocks)
+    {
+        pindexBestSaved = pindexBest;
+        nBestHeightSaved = nBestHeight;
+
+        for (int i = 0; i < nBlocks; i++)
+        {
+            CBlockIndex& index = vIndex[i];
+            index.nHeight = i;
+            index.nFile = 1;
+            index.nBlockPos = 1000 * (i + 1);
+            index.pprev = i > 0 ? &vIndex[i - 1] : nullptr;
+            index.pnext = i + 1 < nBlocks ? &vIndex[i + 1] : nullptr;
+            index.phashBlock = &mapBlockIndex.emplace(uint256S(strprintf("7e57c4a1%04d", i)), &index).first->first;
+        }
+
+        pindexBest = &vIndex.back();
+        nBestHeight = pindexBest->nHeight;
+    }
+
+    ~TestChain()
+    {
+        for (auto& index : vIndex)
+            mapBlockIndex.erase(index.GetBlockHash());
+
+        pindexBest = pindexBestSaved;
+        nBestHeight = nBestHeightSaved;
+    }
+
+    // Disk position of the second transaction in the block at nHeight
+    CDiskTxPos Pos(int nHeight)
+    {
+        return CDiskTxPos(vIndex[nHeight].nFile, vIndex[nHeight].nBlockPos, 1);
+    }
+
+    void Confirm(CMerkleTx& tx, int nHeight)
+    {
+        tx.hashBlock = vIndex[nHeight].GetBlockHash();
+        tx.nIndex = 1;
+    }
+
+    // Write a block to disk and index it at nHeight in place of the placeholder
+    void Store(CBlock& block, int nHeight)
+    {
+        CBlockIndex& index = vIndex[nHeight];
+        mapBlockIndex.erase(index.GetBlockHash());
+
+        BOOST_REQUIRE(block.WriteToDisk(index.nFile, index.nBlockPos));
+        index.nTime = block.nTime;
+        index.phashBlock = &mapBlockIndex.emplace(block.GetHash(), &index).first->first;
+    }
+};
+
+static CTransaction make_payment(const COutPoint& prevout, const CTxDestination& dest, int64_t nValue, bool fCoinStake)
+{
+    CTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout = prevout;
+    tx.vout.resize(fCoinStake ? 2 : 1);
+    tx.vout[0].SetEmpty();
+    tx.vout.back().nValue = nValue;
+    tx.vout.back().scriptPubKey.SetDestination(dest);
+    return tx;
+}
+
+// Proof-of-stake block that contains tx after the coinbase and a coinstake
+static CBlock make_block(const CTransaction& tx, const CTxDestination& dest)
+{
+    CBlock block;
+    block.nTime = GetAdjustedTime();
+    block.vtx.resize(1);
+    block.vtx[0].vin.resize(1);
+    block.vtx[0].vout.resize(1);
+    block.vtx[0].vout[0].SetEmpty();
+    block.vtx.push_back(make_payment(COutPoint(GetRandHash(), 0), dest, COIN, true));
+    block.vtx.push_back(tx);
+    block.hashMerkleRoot = BlockMerkleRoot(block);
+    return block;
+}
+
+// Hashes of up to nMax wallet transactions, newest first
+static vector<uint256> list_newest_first(CWallet& listwallet, size_t nMax)
+{
+    vector<uint256> vHashes;
+    listwallet.VisitTxItemsNewestFirst("", [&](const CWallet::TxPair& item) {
+        if (item.first)
+            vHashes.push_back(item.first->GetHash());
+        return vHashes.size() < nMax;
+    });
+    return vHashes;
+}
+
 BOOST_AUTO_TEST_CASE(it_embeds_the_contract_master_public_key)
 {
     BOOST_CHECK(CWallet::MasterPublicKey().Raw().size() == 65);
@@ -72,6 +175,43 @@ BOOST_AUTO_TEST_CASE(it_provides_the_master_private_key)
     BOOST_CHECK(wallet.MasterPrivateKey().IsValid() == false);
 }
 
+BOOST_AUTO_TEST_CASE(it_recognizes_outputs_that_pay_to_its_keys_and_scripts)
+{
+    CWallet keywallet;
+    CKey key;
+    CKey other;
+    key.MakeNewKey(true);
+    other.MakeNewKey(true);
+
+    CScript redeemScript;
+    redeemScript.SetMultisig(1, { key });
+
+    {
+        LOCK(keywallet.cs_wallet);
+        BOOST_REQUIRE(keywallet.AddKey(key));
+        BOOST_REQUIRE(keywallet.AddCScript(redeemScript));
+    }
+
+    CTxOut txout;
+
+    txout.scriptPubKey.SetDestination(key.GetPubKey().GetID());
+    BOOST_CHECK(keywallet.IsMine(txout) == ISMINE_SPENDABLE);
+    txout.scriptPubKey.SetDestination(other.GetPubKey().GetID());
+    BOOST_CHECK(keywallet.IsMine(txout) == ISMINE_NO);
+
+    txout.scriptPubKey = CScript() << key.GetPubKey().Raw() << OP_CHECKSIG;
+    BOOST_CHECK(keywallet.IsMine(txout) == ISMINE_SPENDABLE);
+    txout.scriptPubKey = CScript() << other.GetPubKey().Raw() << OP_CHECKSIG;
+    BOOST_CHECK(keywallet.IsMine(txout) == ISMINE_NO);
+
+    txout.scriptPubKey.SetDestination(redeemScript.GetID());
+    BOOST_CHECK(keywallet.IsMine(txout) == ISMINE_SPENDABLE);
+
+    // bare multisig bypasses the filter
+    txout.scriptPubKey = redeemScript;
+    BOOST_CHECK(keywallet.IsMine(txout) == ISMINE_SPENDABLE);
+}
+
 BOOST_AUTO_TEST_CASE(coin_selection_tests)
 {
     static CoinSet setCoinsRet, setCoinsRet2;
@@ -312,4 +452,412 @@ BOOST_AUTO_TEST_CASE(coin_selection_tests)
     }
 }
 
+BOOST_AUTO_TEST_CASE(coin_selection_in_a_fragmented_wallet)
+{
+    static CoinSet setCoinsRet;
+    static int64_t nValueRet;
+    int64_t spendTime = GetTime();
+
+    empty_wallet();
+
+    // 20000 small coins of 1 to 1000 cents each
+    for (int i = 0; i < 20000; i++)
+        add_coin((1 + i % 1000) * CENT);
+
+    // an exact subset exists, and the search should find it
+    BOOST_CHECK( wallet.SelectCoinsMinConf(123456 * CENT, spendTime, 1, 6, vCoins, setCoinsRet, nValueRet));
+    BOOST_CHECK_EQUAL(nValueRet, 123456 * CENT);
+
+    // no subset of whole cents can make a fraction of a cent, so we get a bit more
+    BOOST_CHECK( wallet.SelectCoinsMinConf(123456 * CENT + 1, spendTime, 1, 6, vCoins, setCoinsRet, nValueRet));
+    BOOST_CHECK_GT(nValueRet, 123456 * CENT + 1);
+
+    empty_wallet();
+}
+
+BOOST_AUTO_TEST_CASE(it_archives_dead_transactions_and_restores_lost_coins)
+{
+    TestChain chain(10);
+    CWallet archivewallet("wallet_archive_tests.dat");
+    bool fFirstRun;
+    BOOST_REQUIRE(archivewallet.LoadWallet(fFirstRun) == DB_LOAD_OK);
+
+    CKey key;
+    CKey other;
+    key.MakeNewKey(true);
+    other.MakeNewKey(true);
+
+    LOCK2(cs_main, archivewallet.cs_wallet);
+    BOOST_REQUIRE(archivewallet.AddKey(key));
+
+    // Two payments to us, one spent by a coinstake and one by a payment to
+    // someone else, both spends in the newest blocks:
+    CWalletTx wtxFund1(&archivewallet, make_payment(COutPoint(uint256S("f1"), 0), key.GetPubKey().GetID(), 100 * COIN, false));
+    CWalletTx wtxFund2(&archivewallet, make_payment(COutPoint(uint256S("f2"), 0), key.GetPubKey().GetID(), 200 * COIN, false));
+    CWalletTx wtxStake(&archivewallet, make_payment(COutPoint(wtxFund1.GetHash(), 0), other.GetPubKey().GetID(), 100 * COIN, true));
+    CWalletTx wtxSpend(&archivewallet, make_payment(COutPoint(wtxFund2.GetHash(), 0), other.GetPubKey().GetID(), 200 * COIN, false));
+    BOOST_REQUIRE(wtxStake.IsCoinStake());
+
+    chain.Confirm(wtxFund1, 1);
+    chain.Confirm(wtxFund2, 1);
+    chain.Confirm(wtxStake, 8);
+    chain.Confirm(wtxSpend, 8);
+
+    {
+        CWalletDB walletdb(archivewallet.strWalletFile);
+        for (CWalletTx* pwtx : { &wtxFund1, &wtxFund2, &wtxStake, &wtxSpend })
+            BOOST_REQUIRE(archivewallet.AddToWallet(*pwtx, &walletdb));
+    }
+
+    BOOST_CHECK(archivewallet.mapWallet[wtxFund1.GetHash()].IsSpent(0));
+    BOOST_CHECK(archivewallet.mapWallet[wtxFund2.GetHash()].IsSpent(0));
+
+    CTxDB txdb("r+");
+    CTxIndex txindexFund1(chain.Pos(1), 1);
+    CTxIndex txindexFund2(chain.Pos(1), 1);
+    txindexFund1.vSpent[0] = chain.Pos(8);
+    txindexFund2.vSpent[0] = chain.Pos(8);
+    BOOST_REQUIRE(txdb.UpdateTxIndex(wtxFund1.GetHash(), txindexFund1));
+    BOOST_REQUIRE(txdb.UpdateTxIndex(wtxFund2.GetHash(), txindexFund2));
+    BOOST_REQUIRE(txdb.UpdateTxIndex(wtxStake.GetHash(), CTxIndex(chain.Pos(8), 2)));
+    BOOST_REQUIRE(txdb.UpdateTxIndex(wtxSpend.GetHash(), CTxIndex(chain.Pos(8), 1)));
+
+    // The payments are deep, but their spenders are not:
+    BOOST_CHECK_EQUAL(archivewallet.ArchiveTransactions(5), 0);
+
+    archivewallet.mapWallet[wtxStake.GetHash()].hashBlock = chain.vIndex[3].GetBlockHash();
+    archivewallet.mapWallet[wtxSpend.GetHash()].hashBlock = chain.vIndex[3].GetBlockHash();
+    txindexFund1.vSpent[0] = chain.Pos(3);
+    txindexFund2.vSpent[0] = chain.Pos(3);
+    BOOST_REQUIRE(txdb.UpdateTxIndex(wtxFund1.GetHash(), txindexFund1));
+    BOOST_REQUIRE(txdb.UpdateTxIndex(wtxFund2.GetHash(), txindexFund2));
+    BOOST_REQUIRE(txdb.UpdateTxIndex(wtxStake.GetHash(), CTxIndex(chain.Pos(3), 2)));
+    BOOST_REQUIRE(txdb.UpdateTxIndex(wtxSpend.GetHash(), CTxIndex(chain.Pos(3), 1)));
+
+    BOOST_CHECK_EQUAL(archivewallet.ArchiveTransactions(5), 4);
+    BOOST_CHECK(archivewallet.mapWallet.empty());
+    BOOST_CHECK_EQUAL(archivewallet.mapArchived.size(), 4);
+
+    // Archived transactions are read on demand and still count as ours:
+    CWalletTx wtxArchived;
+    BOOST_REQUIRE(archivewallet.ReadArchivedTx(wtxFund1.GetHash(), wtxArchived));
+    BOOST_CHECK(wtxArchived.GetHash() == wtxFund1.GetHash());
+    BOOST_CHECK(wtxArchived.IsSpent(0));
+    BOOST_CHECK(archivewallet.IsFromMe(wtxStake));
+
+    size_t nVisited = 0;
+    archivewallet.VisitTxItemsNewestFirst("", [&](const CWallet::TxPair& item) {
+        nVisited += item.first != nullptr;
+        return true;
+    });
+    BOOST_CHECK_EQUAL(nVisited, 4);
+
+    {
+        CWallet reloaded("wallet_archive_tests.dat");
+        BOOST_REQUIRE(reloaded.LoadWallet(fFirstRun) == DB_LOAD_OK);
+        LOCK(reloaded.cs_wallet);
+        BOOST_CHECK(reloaded.mapWallet.empty());
+        BOOST_CHECK_EQUAL(reloaded.mapArchived.size(), 4);
+        BOOST_CHECK(reloaded.mapArchived[wtxFund2.GetHash()].vout == wtxFund2.vout);
+    }
+
+    // An orphaned coinstake returns the coin it spent:
+    archivewallet.DisableTransaction(wtxStake);
+    BOOST_REQUIRE(archivewallet.mapWallet.count(wtxFund1.GetHash()));
+    BOOST_CHECK(!archivewallet.mapWallet[wtxFund1.GetHash()].IsSpent(0));
+    BOOST_CHECK(!archivewallet.mapArchived.count(wtxFund1.GetHash()));
+
+    // So does a spend that the transaction index no longer records:
+    txindexFund2.vSpent[0].SetNull();
+    BOOST_REQUIRE(txdb.UpdateTxIndex(wtxFund2.GetHash(), txindexFund2));
+
+    int64_t nValueRestored;
+    BOOST_CHECK_EQUAL(archivewallet.RestoreUnspentArchivedTx(false, nValueRestored), 1);
+    BOOST_CHECK_EQUAL(nValueRestored, 200 * COIN);
+    BOOST_REQUIRE(archivewallet.mapWallet.count(wtxFund2.GetHash()));
+    BOOST_CHECK(!archivewallet.mapWallet[wtxFund2.GetHash()].IsSpent(0));
+    BOOST_CHECK_EQUAL(archivewallet.GetBalance(), 300 * COIN);
+
+    {
+        CWallet reloaded("wallet_archive_tests.dat");
+        BOOST_REQUIRE(reloaded.LoadWallet(fFirstRun) == DB_LOAD_OK);
+        LOCK(reloaded.cs_wallet);
+        BOOST_CHECK(reloaded.mapWallet.count(wtxFund1.GetHash()));
+        BOOST_CHECK(reloaded.mapWallet.count(wtxFund2.GetHash()));
+        BOOST_CHECK_EQUAL(reloaded.mapArchived.size(), 2);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(it_indexes_only_transactions_with_unspent_outputs_of_ours)
+{
+    TestChain chain(20);
+    CWallet unspentwallet("wallet_unspent_tests.dat");
+    bool fFirstRun;
+    BOOST_REQUIRE(unspentwallet.LoadWallet(fFirstRun) == DB_LOAD_OK);
+
+    CKey key;
+    CKey other;
+    key.MakeNewKey(true);
+    other.MakeNewKey(true);
+
+    LOCK2(cs_main, unspentwallet.cs_wallet);
+    BOOST_REQUIRE(unspentwallet.AddKey(key));
+
+    CWalletTx wtxFund1(&unspentwallet, make_payment(COutPoint(uint256S("a1"), 0), key.GetPubKey().GetID(), 100 * COIN, false));
+    CWalletTx wtxFund2(&unspentwallet, make_payment(COutPoint(uint256S("a2"), 0), key.GetPubKey().GetID(), 200 * COIN, false));
+    CWalletTx wtxSpend(&unspentwallet, make_payment(COutPoint(wtxFund1.GetHash(), 0), other.GetPubKey().GetID(), 100 * COIN, false));
+
+    chain.Confirm(wtxFund1, 1);
+    chain.Confirm(wtxFund2, 1);
+    chain.Confirm(wtxSpend, 2);
+
+    {
+        CWalletDB walletdb(unspentwallet.strWalletFile);
+        for (CWalletTx* pwtx : { &wtxFund1, &wtxFund2, &wtxSpend })
+            BOOST_REQUIRE(unspentwallet.AddToWallet(*pwtx, &walletdb));
+    }
+
+    // The spent payment and the spend that pays someone else drop out:
+    vector<COutput> vAvailable;
+    unspentwallet.AvailableCoins(vAvailable);
+    BOOST_REQUIRE_EQUAL(vAvailable.size(), 1);
+    BOOST_CHECK(vAvailable[0].tx->GetHash() == wtxFund2.GetHash());
+    BOOST_CHECK_EQUAL(vAvailable[0].i, 0);
+    BOOST_CHECK_EQUAL(unspentwallet.GetBalance(), 200 * COIN);
+
+    // A wallet loaded from the file rebuilds the same index:
+    CWallet reloaded("wallet_unspent_tests.dat");
+    BOOST_REQUIRE(reloaded.LoadWallet(fFirstRun) == DB_LOAD_OK);
+    LOCK(reloaded.cs_wallet);
+    BOOST_CHECK_EQUAL(reloaded.mapWallet.size(), 3);
+
+    vector<COutput> vReloaded;
+    reloaded.AvailableCoins(vReloaded);
+    BOOST_REQUIRE_EQUAL(vReloaded.size(), 1);
+    BOOST_CHECK(vReloaded[0].tx->GetHash() == wtxFund2.GetHash());
+    BOOST_CHECK_EQUAL(reloaded.GetBalance(), 200 * COIN);
+}
+
+BOOST_AUTO_TEST_CASE(it_keeps_the_cached_balance_current_across_wallet_and_tip_changes)
+{
+    TestChain chain(20);
+    CWallet balancewallet("wallet_balance_tests.dat");
+    bool fFirstRun;
+    BOOST_REQUIRE(balancewallet.LoadWallet(fFirstRun) == DB_LOAD_OK);
+
+    CKey key;
+    CKey other;
+    key.MakeNewKey(true);
+    other.MakeNewKey(true);
+
+    LOCK2(cs_main, balancewallet.cs_wallet);
+    BOOST_REQUIRE(balancewallet.AddKey(key));
+    CWalletDB walletdb(balancewallet.strWalletFile);
+
+    CWalletTx wtxFund1(&balancewallet, make_payment(COutPoint(uint256S("b1"), 0), key.GetPubKey().GetID(), 100 * COIN, false));
+    CWalletTx wtxFund2(&balancewallet, make_payment(COutPoint(uint256S("b2"), 0), key.GetPubKey().GetID(), 200 * COIN, false));
+    CWalletTx wtxSpend(&balancewallet, make_payment(COutPoint(wtxFund1.GetHash(), 0), other.GetPubKey().GetID(), 100 * COIN, false));
+    CWalletTx wtxFund3(&balancewallet, make_payment(COutPoint(uint256S("b3"), 0), key.GetPubKey().GetID(), 400 * COIN, false));
+
+    chain.Confirm(wtxFund1, 1);
+    chain.Confirm(wtxFund2, 1);
+    chain.Confirm(wtxSpend, 2);
+    chain.Confirm(wtxFund3, 10);
+
+    BOOST_REQUIRE(balancewallet.AddToWallet(wtxFund1, &walletdb));
+    BOOST_REQUIRE(balancewallet.AddToWallet(wtxFund2, &walletdb));
+    BOOST_CHECK_EQUAL(balancewallet.GetBalance(), 300 * COIN);
+
+    BOOST_REQUIRE(balancewallet.AddToWallet(wtxSpend, &walletdb));
+    BOOST_CHECK_EQUAL(balancewallet.GetBalance(), 200 * COIN);
+
+    BOOST_REQUIRE(balancewallet.EraseFromWallet(wtxFund2.GetHash()));
+    BOOST_CHECK_EQUAL(balancewallet.GetBalance(), 0);
+
+    // One block short of the confirmations that the balance requires:
+    chain.vIndex[18].pnext = nullptr;
+    pindexBest = &chain.vIndex[18];
+    nBestHeight = 18;
+
+    BOOST_REQUIRE(balancewallet.AddToWallet(wtxFund3, &walletdb));
+    BOOST_CHECK_EQUAL(balancewallet.GetBalance(), 0);
+    BOOST_CHECK_EQUAL(balancewallet.GetUnconfirmedBalance(), 400 * COIN);
+
+    // A new block alone moves the payment into the balance:
+    chain.vIndex[18].pnext = &chain.vIndex[19];
+    pindexBest = &chain.vIndex[19];
+    nBestHeight = 19;
+
+    BOOST_CHECK_EQUAL(balancewallet.GetBalance(), 400 * COIN);
+    BOOST_CHECK_EQUAL(balancewallet.GetUnconfirmedBalance(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(it_lists_transactions_newest_first_across_archiving_and_reloading)
+{
+    TestChain chain(20);
+    CWallet orderwallet("wallet_order_tests.dat");
+    bool fFirstRun;
+    BOOST_REQUIRE(orderwallet.LoadWallet(fFirstRun) == DB_LOAD_OK);
+
+    CKey key;
+    CKey other;
+    key.MakeNewKey(true);
+    other.MakeNewKey(true);
+
+    LOCK2(cs_main, orderwallet.cs_wallet);
+    BOOST_REQUIRE(orderwallet.AddKey(key));
+
+    CWalletTx wtxFund1(&orderwallet, make_payment(COutPoint(uint256S("d1"), 0), key.GetPubKey().GetID(), 100 * COIN, false));
+    CWalletTx wtxFund2(&orderwallet, make_payment(COutPoint(uint256S("d2"), 0), key.GetPubKey().GetID(), 200 * COIN, false));
+    CWalletTx wtxSpend(&orderwallet, make_payment(COutPoint(wtxFund1.GetHash(), 0), other.GetPubKey().GetID(), 100 * COIN, false));
+    CWalletTx wtxFund3(&orderwallet, make_payment(COutPoint(uint256S("d3"), 0), key.GetPubKey().GetID(), 400 * COIN, false));
+
+    chain.Confirm(wtxFund1, 1);
+    chain.Confirm(wtxFund2, 1);
+    chain.Confirm(wtxSpend, 3);
+    chain.Confirm(wtxFund3, 5);
+
+    {
+        CWalletDB walletdb(orderwallet.strWalletFile);
+        for (CWalletTx* pwtx : { &wtxFund1, &wtxFund2, &wtxSpend, &wtxFund3 })
+            BOOST_REQUIRE(orderwallet.AddToWallet(*pwtx, &walletdb));
+    }
+
+    const vector<uint256> vExpected = {
+        wtxFund3.GetHash(), wtxSpend.GetHash(), wtxFund2.GetHash(), wtxFund1.GetHash(),
+    };
+
+    BOOST_CHECK(list_newest_first(orderwallet, 10) == vExpected);
+
+    // The walk stops when the caller has a page:
+    const vector<uint256> vPage = list_newest_first(orderwallet, 2);
+    BOOST_CHECK(vPage == vector<uint256>(vExpected.begin(), vExpected.begin() + 2));
+
+    // It matches the full sort that it replaces:
+    std::list<CAccountingEntry> acentries;
+    const CWallet::TxItems txOrdered = orderwallet.OrderedTxItems(acentries);
+    vector<uint256> vSorted;
+    for (auto it = txOrdered.rbegin(); it != txOrdered.rend(); ++it)
+        vSorted.push_back(it->second.first->GetHash());
+    BOOST_CHECK(vSorted == vExpected);
+
+    // Archive the spent payment and its spend:
+    CTxDB txdb("r+");
+    CTxIndex txindexFund1(chain.Pos(1), 1);
+    txindexFund1.vSpent[0] = chain.Pos(3);
+    BOOST_REQUIRE(txdb.UpdateTxIndex(wtxFund1.GetHash(), txindexFund1));
+    BOOST_REQUIRE(txdb.UpdateTxIndex(wtxSpend.GetHash(), CTxIndex(chain.Pos(3), 1)));
+
+    BOOST_CHECK_EQUAL(orderwallet.ArchiveTransactions(5), 2);
+    BOOST_CHECK_EQUAL(orderwallet.mapWallet.size(), 2);
+
+    // The archived wallet lists and counts the same as it did before, both
+    // in memory and when loaded from the file:
+    BOOST_CHECK(list_newest_first(orderwallet, 10) == vExpected);
+    BOOST_CHECK_EQUAL(orderwallet.GetBalance(), 600 * COIN);
+
+    CWallet reloaded("wallet_order_tests.dat");
+    BOOST_REQUIRE(reloaded.LoadWallet(fFirstRun) == DB_LOAD_OK);
+    LOCK(reloaded.cs_wallet);
+    BOOST_CHECK(list_newest_first(reloaded, 10) == vExpected);
+    BOOST_CHECK_EQUAL(reloaded.GetBalance(), 600 * COIN);
+}
+
+BOOST_AUTO_TEST_CASE(it_writes_the_latest_state_of_batched_transactions_when_the_batch_closes)
+{
+    TestChain chain(20);
+    CWallet batchwallet("wallet_batch_tests.dat");
+    bool fFirstRun;
+    BOOST_REQUIRE(batchwallet.LoadWallet(fFirstRun) == DB_LOAD_OK);
+
+    CKey key;
+    CKey other;
+    key.MakeNewKey(true);
+    other.MakeNewKey(true);
+
+    LOCK2(cs_main, batchwallet.cs_wallet);
+    BOOST_REQUIRE(batchwallet.AddKey(key));
+
+    CWalletTx wtxFund(&batchwallet, make_payment(COutPoint(uint256S("e1"), 0), key.GetPubKey().GetID(), 100 * COIN, false));
+    CWalletTx wtxSpend(&batchwallet, make_payment(COutPoint(wtxFund.GetHash(), 0), other.GetPubKey().GetID(), 100 * COIN, false));
+
+    chain.Confirm(wtxFund, 1);
+    chain.Confirm(wtxSpend, 2);
+
+    {
+        CWalletDBBatch batch(&batchwallet);
+        CWalletDB walletdb(batchwallet.strWalletFile);
+
+        BOOST_REQUIRE(batchwallet.AddToWallet(wtxFund, &walletdb));
+        BOOST_REQUIRE(batchwallet.AddToWallet(wtxSpend, &walletdb));
+
+        {
+            CWalletDBBatch inner(&batchwallet);
+            BOOST_REQUIRE(batchwallet.mapWallet[wtxFund.GetHash()].WriteToDisk(&walletdb));
+        }
+
+        // Nothing reaches the file until the outermost batch closes:
+        CWallet pending("wallet_batch_tests.dat");
+        BOOST_REQUIRE(pending.LoadWallet(fFirstRun) == DB_LOAD_OK);
+        LOCK(pending.cs_wallet);
+        BOOST_CHECK(pending.mapWallet.empty());
+        BOOST_CHECK_EQUAL(pending.nOrderPosNext, 0);
+    }
+
+    // The payment was written again when the spend marked it spent. The file
+    // holds its final state and the order counter:
+    CWallet reloaded("wallet_batch_tests.dat");
+    BOOST_REQUIRE(reloaded.LoadWallet(fFirstRun) == DB_LOAD_OK);
+    LOCK(reloaded.cs_wallet);
+    BOOST_CHECK_EQUAL(reloaded.mapWallet.size(), 2);
+    BOOST_REQUIRE(reloaded.mapWallet.count(wtxFund.GetHash()));
+    BOOST_CHECK(reloaded.mapWallet[wtxFund.GetHash()].IsSpent(0));
+    BOOST_CHECK_EQUAL(reloaded.nOrderPosNext, 2);
+    BOOST_CHECK_EQUAL(reloaded.GetBalance(), batchwallet.GetBalance());
+}
+
+BOOST_AUTO_TEST_CASE(it_finds_payments_and_spends_when_rescanning_the_chain)
+{
+    TestChain chain(4);
+    CWallet scanwallet("wallet_scan_tests.dat");
+    bool fFirstRun;
+    BOOST_REQUIRE(scanwallet.LoadWallet(fFirstRun) == DB_LOAD_OK);
+
+    CKey key;
+    CKey other;
+    key.MakeNewKey(true);
+    other.MakeNewKey(true);
+
+    LOCK2(cs_main, scanwallet.cs_wallet);
+    BOOST_REQUIRE(scanwallet.AddKey(key));
+
+    // A payment to us, then a spend of it that pays only someone else, so the
+    // rescan can only match the spend by its input:
+    CTransaction txPayment = make_payment(COutPoint(uint256S("f3"), 0), key.GetPubKey().GetID(), 100 * COIN, false);
+    CTransaction txSpend = make_payment(COutPoint(txPayment.GetHash(), 0), other.GetPubKey().GetID(), 100 * COIN, false);
+
+    CBlock blockPayment = make_block(txPayment, other.GetPubKey().GetID());
+    CBlock blockSpend = make_block(txSpend, other.GetPubKey().GetID());
+    chain.Store(blockPayment, 1);
+    chain.Store(blockSpend, 2);
+
+    BOOST_CHECK_EQUAL(scanwallet.ScanForWalletTransactions(&chain.vIndex[0], true), 2);
+    BOOST_CHECK_EQUAL(scanwallet.mapWallet.size(), 2);
+
+    BOOST_REQUIRE(scanwallet.mapWallet.count(txPayment.GetHash()));
+    const CWalletTx& wtxPayment = scanwallet.mapWallet[txPayment.GetHash()];
+    BOOST_CHECK(wtxPayment.hashBlock == blockPayment.GetHash());
+    BOOST_CHECK_EQUAL(wtxPayment.nIndex, 2);
+    BOOST_CHECK(wtxPayment.IsSpent(0));
+
+    BOOST_REQUIRE(scanwallet.mapWallet.count(txSpend.GetHash()));
+    const CWalletTx& wtxSpend = scanwallet.mapWallet[txSpend.GetHash()];
+    BOOST_CHECK(wtxSpend.hashBlock == blockSpend.GetHash());
+    BOOST_CHECK(scanwallet.IsFromMe(wtxSpend));
+    BOOST_CHECK_EQUAL(scanwallet.GetBalance(), 0);
+
+    // Without fUpdate, a second rescan leaves the known transactions alone:
+    BOOST_CHECK_EQUAL(scanwallet.ScanForWalletTransactions(&chain.vIndex[0], false), 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,134 @@
+// Copyright (c) 2021 The Gridcoin developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_UTIL_PARALLEL_H
+#define BITCOIN_UTIL_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//!
+//! \brief Get the number of worker threads to use for a batch of work.
+//!
+//! \param count       Number of work items in the batch.
+//! \param max_threads Upper bound on the number of threads. Zero selects the
+//! number of hardware threads.
+//!
+//! \return At least one, and no more threads than items.
+//!
+inline size_t GetParallelThreadCount(const size_t count, const size_t max_threads = 0)
+{
+    size_t threads = std::thread::hardware_concurrency();
+
+    if (max_threads > 0) {
+        threads = std::min(threads, max_threads);
+    }
+
+    return std::max<size_t>(1, std::min(threads, count));
+}
+
+//!
+//! \brief Call a function for each index in [0, count) on a set of short-lived
+//! worker threads until the function asks to stop, and wait for all of them
+//! to finish.
+//!
+//! Workers claim indexes one at a time in increasing order, so the function
+//! must be safe to call concurrently for different indexes. Once a call asks
+//! to stop, no worker claims another index, but calls for indexes that were
+//! already claimed still finish. Every index below the one that asked to stop
+//! was claimed before it. When the batch needs only one thread, the function
+//! runs on the calling thread.
+//!
+//! \param count       Number of indexes to process.
+//! \param func        Called with each index. Returns \c true to stop claiming
+//! indexes. Must not throw for control flow: the first exception stops the
+//! remaining work and is rethrown to the caller.
+//! \param max_threads Upper bound on the number of threads. Zero selects the
+//! number of hardware threads.
+//!
+template <typename Func>
+void ParallelForUntil(const size_t count, Func&& func, const size_t max_threads = 0)
+{
+    const size_t thread_count = GetParallelThreadCount(count, max_threads);
+
+    if (thread_count <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            if (func(i)) {
+                return;
+            }
+        }
+
+        return;
+    }
+
+    std::atomic<size_t> next { 0 };
+    std::atomic<bool> stopped { false };
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    const auto worker = [&]() {
+        for (size_t i = next++; i < count && !stopped; i = next++) {
+            try {
+                if (func(i)) {
+                    stopped = true;
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+
+                if (!error) {
+                    error = std::current_exception();
+                }
+
+                stopped = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count - 1);
+
+    for (size_t i = 1; i < thread_count; ++i) {
+        threads.emplace_back(worker);
+    }
+
+    worker();
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+//!
+//! \brief Call a function for each index in [0, count) on a set of short-lived
+//! worker threads and wait for all of them to finish.
+//!
+//! Workers claim indexes one at a time, so the function must be safe to call
+//! concurrently for different indexes. When the batch needs only one thread,
+//! the function runs on the calling thread.
+//!
+//! \param count       Number of indexes to process.
+//! \param func        Called with each index. Must not throw for control flow:
+//! the first exception stops the remaining work and is rethrown to the caller.
+//! \param max_threads Upper bound on the number of threads. Zero selects the
+//! number of hardware threads.
+//!
+template <typename Func>
+void ParallelFor(const size_t count, Func&& func, const size_t max_threads = 0)
+{
+    ParallelForUntil(count, [&](const size_t i) {
+        func(i);
+        return false;
+    }, max_threads);
+}
+
+#endif // BITCOIN_UTIL_PARALLEL_H
@@ -43,7 +43,7 @@ std::string FormatSubVersion(const std::string& name, int nClientVersion, const
 ///////////////////////////////////////////////////////////
 // network protocol versioning                           //
 //                                                       //
-static const int PROTOCOL_VERSION =       180326;        //
+static const int PROTOCOL_VERSION =       180327;        //
 // disconnect from peers older than this proto version   //
 static const int MIN_PEER_PROTO_VERSION = 180326;        //
 ///////////////////////////////////////////////////////////
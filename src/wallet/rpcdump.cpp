@@ -156,6 +156,9 @@ UniValue importprivkey(const UniValue& params, bool fHelp)
         if (!pwalletMain->AddKey(key))
             throw JSONRPCError(RPC_WALLET_ERROR, "Error adding key to wallet");
 
+        // The wallet may already contain outputs sent to the imported key:
+        pwalletMain->RebuildUnspentIndex();
+
         // whenever a key is imported, we need to scan the whole chain
         pwalletMain->nTimeFirstKey = 1; // 0 would be considered 'no value'
         pwalletMain->SetAddressBookName(vchAddress, strLabel);
@@ -1161,6 +1161,9 @@ UniValue addmultisigaddress(const UniValue& params, bool fHelp)
     if (!pwalletMain->AddCScript(inner))
         throw runtime_error("AddCScript() failed");
 
+    // The wallet may already contain outputs sent to the script:
+    pwalletMain->RebuildUnspentIndex();
+
     pwalletMain->SetAddressBookName(innerID, strAccount);
     return CBitcoinAddress(innerID).ToString();
 }
@@ -1189,6 +1192,9 @@ UniValue addredeemscript(const UniValue& params, bool fHelp)
     if (!pwalletMain->AddCScript(inner))
         throw runtime_error("AddCScript() failed");
 
+    // The wallet may already contain outputs sent to the script:
+    pwalletMain->RebuildUnspentIndex();
+
     pwalletMain->SetAddressBookName(innerID, strAccount);
     return CBitcoinAddress(innerID).ToString();
 }
@@ -1620,21 +1626,17 @@ UniValue listtransactions(const UniValue& params, bool fHelp)
 
     LOCK2(cs_main, pwalletMain->cs_wallet);
 
-    std::list<CAccountingEntry> acentries;
-    CWallet::TxItems txOrdered = pwalletMain->OrderedTxItems(acentries, strAccount);
-
     // iterate backwards until we have nCount items to return:
-    for (CWallet::TxItems::reverse_iterator it = txOrdered.rbegin(); it != txOrdered.rend(); ++it)
-    {
-        CWalletTx *const pwtx = (*it).second.first;
+    pwalletMain->VisitTxItemsNewestFirst(strAccount, [&](const CWallet::TxPair& item) {
+        CWalletTx *const pwtx = item.first;
         if (pwtx != 0)
             ListTransactions(*pwtx, strAccount, 0, true, ret, filter);
-        CAccountingEntry *const pacentry = (*it).second.second;
+        CAccountingEntry *const pacentry = item.second;
         if (pacentry != 0)
             AcentryToJSON(*pacentry, strAccount, ret);
 
-        if ((int)ret.size() >= (nCount+nFrom)) break;
-    }
+        return (int)ret.size() < (nCount+nFrom);
+    });
     // ret is newest to oldest
 
     if (nFrom > (int)ret.size())
@@ -1687,21 +1689,17 @@ UniValue liststakes(const UniValue& params, bool fHelp)
 
     LOCK2(cs_main, pwalletMain->cs_wallet);
 
-    std::list<CAccountingEntry> acentries;
-    CWallet::TxItems txOrdered = pwalletMain->OrderedTxItems(acentries, strAccount);
-
     // iterate backwards until we have at least nCount items to return:
-    for (CWallet::TxItems::reverse_iterator it = txOrdered.rbegin(); it != txOrdered.rend(); ++it)
-    {
-        CWalletTx *const pwtx = it->second.first;
+    pwalletMain->VisitTxItemsNewestFirst(strAccount, [&](const CWallet::TxPair& item) {
+        CWalletTx *const pwtx = item.first;
         if (pwtx != 0)
             ListTransactions(*pwtx, strAccount, 0, true, ret_superset, filter, true);
-        CAccountingEntry *const pacentry = it->second.second;
+        CAccountingEntry *const pacentry = item.second;
         if (pacentry != 0)
             AcentryToJSON(*pacentry, strAccount, ret_superset);
 
-        if ((int)ret_superset.size() >= nCount) break;
-    }
+        return (int)ret_superset.size() < nCount;
+    });
     // ret is newest to oldest, for the stake listings, we will leave in that order.
     std::vector<UniValue> arrTmp = ret_superset.getValues();
 
@@ -1875,58 +1873,71 @@ UniValue gettransaction(const UniValue& params, bool fHelp)
              filter = filter | ISMINE_WATCH_ONLY;
     UniValue entry(UniValue::VOBJ);
 
-    LOCK2(cs_main, pwalletMain->cs_wallet);
-
-    if (pwalletMain->mapWallet.count(hash))
     {
-        const CWalletTx& wtx = pwalletMain->mapWallet[hash];
+        LOCK2(cs_main, pwalletMain->cs_wallet);
+
+        CWalletTx wtxArchived;
+        const CWalletTx* pwtx = nullptr;
+
+        if (pwalletMain->mapWallet.count(hash))
+            pwtx = &pwalletMain->mapWallet[hash];
+        else if (pwalletMain->ReadArchivedTx(hash, wtxArchived))
+            pwtx = &wtxArchived;
+
+        if (pwtx)
+        {
+            const CWalletTx& wtx = *pwtx;
 
-        TxToJSON(wtx, uint256(), entry);
+            TxToJSON(wtx, uint256(), entry);
 
-        int64_t nCredit = wtx.GetCredit();
-        int64_t nDebit = wtx.GetDebit();
-        int64_t nNet = nCredit - nDebit;
+            int64_t nCredit = wtx.GetCredit();
+            int64_t nDebit = wtx.GetDebit();
+            int64_t nNet = nCredit - nDebit;
 
-        bool IsFee = wtx.IsFromMe() && !wtx.IsCoinBase() && !wtx.IsCoinStake();
+            bool IsFee = wtx.IsFromMe() && !wtx.IsCoinBase() && !wtx.IsCoinStake();
 
-        int64_t nFee = (IsFee ? wtx.GetValueOut() - nDebit : 0);
+            int64_t nFee = (IsFee ? wtx.GetValueOut() - nDebit : 0);
 
-        if (IsFee)
-            entry.pushKV("fee", ValueFromAmount(nFee));
+            if (IsFee)
+                entry.pushKV("fee", ValueFromAmount(nFee));
 
-        entry.pushKV("amount", ValueFromAmount(nNet - nFee));
+            entry.pushKV("amount", ValueFromAmount(nNet - nFee));
 
-        WalletTxToJSON(wtx, entry);
+            WalletTxToJSON(wtx, entry);
 
-        UniValue details(UniValue::VARR);
-        ListTransactions(pwalletMain->mapWallet[hash], "*", 0, false, details, filter);
-        entry.pushKV("details", details);
+            UniValue details(UniValue::VARR);
+            ListTransactions(wtx, "*", 0, false, details, filter);
+            entry.pushKV("details", details);
+
+            return entry;
+        }
     }
+
+    // Not a wallet transaction. Read it from the transaction index without
+    // holding cs_main across the disk access:
+    CTransaction tx;
+    uint256 hashBlock;
+    if (!GetTransaction(hash, tx, hashBlock))
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available about transaction");
+
+    TxToJSON(tx, uint256(), entry);
+    if (hashBlock.IsNull())
+        entry.pushKV("confirmations", 0);
     else
     {
-        CTransaction tx;
-        uint256 hashBlock;
-        if (GetTransaction(hash, tx, hashBlock))
+        entry.pushKV("blockhash", hashBlock.GetHex());
+
+        LOCK(cs_main);
+
+        BlockMap::iterator mi = mapBlockIndex.find(hashBlock);
+        if (mi != mapBlockIndex.end() && (*mi).second)
         {
-            TxToJSON(tx, uint256(), entry);
-            if (hashBlock.IsNull())
-                entry.pushKV("confirmations", 0);
+            CBlockIndex* pindex = (*mi).second;
+            if (pindex->IsInMainChain())
+                entry.pushKV("confirmations", 1 + nBestHeight - pindex->nHeight);
             else
-            {
-                entry.pushKV("blockhash", hashBlock.GetHex());
-                BlockMap::iterator mi = mapBlockIndex.find(hashBlock);
-                if (mi != mapBlockIndex.end() && (*mi).second)
-                {
-                    CBlockIndex* pindex = (*mi).second;
-                    if (pindex->IsInMainChain())
-                        entry.pushKV("confirmations", 1 + nBestHeight - pindex->nHeight);
-                    else
-                        entry.pushKV("confirmations", 0);
-                }
-            }
+                entry.pushKV("confirmations", 0);
         }
-        else
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available about transaction");
     }
 
     return entry;
@@ -1946,13 +1957,16 @@ UniValue getrawwallettransaction(const UniValue& params, bool fHelp)
     LOCK2(cs_main, pwalletMain->cs_wallet);
 
     const auto iter = pwalletMain->mapWallet.find(hash);
+    CWalletTx wtxArchived;
 
-    if (iter == pwalletMain->mapWallet.end()) {
+    if (iter == pwalletMain->mapWallet.end() && !pwalletMain->ReadArchivedTx(hash, wtxArchived)) {
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Transaction not in wallet");
     }
 
+    const CWalletTx& wtx = iter != pwalletMain->mapWallet.end() ? iter->second : wtxArchived;
+
     CDataStream ssTx(SER_NETWORK, PROTOCOL_VERSION);
-    ssTx << static_cast<const CTransaction&>(iter->second);
+    ssTx << static_cast<const CTransaction&>(wtx);
 
     return HexStr(ssTx.begin(), ssTx.end());
 }
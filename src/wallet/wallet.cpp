@@ -22,6 +22,7 @@
 #include "gridcoin/staking/kernel.h"
 #include "gridcoin/support/block_finder.h"
 #include "policy/fees.h"
+#include "util/parallel.h"
 
 using namespace std;
 
@@ -117,6 +118,7 @@ bool CWallet::AddKey(const CKey& key)
 
     if (!CCryptoKeyStore::AddKey(key))
         return false;
+    AddToScriptFilter(pubkey.GetID());
     if (!fFileBacked)
         return true;
     if (!IsCrypted())
@@ -128,6 +130,7 @@ bool CWallet::AddCryptedKey(const CPubKey &vchPubKey, const vector<unsigned char
 {
     if (!CCryptoKeyStore::AddCryptedKey(vchPubKey, vchCryptedSecret))
         return false;
+    AddToScriptFilter(vchPubKey.GetID());
     if (!fFileBacked)
         return true;
     {
@@ -150,15 +153,27 @@ bool CWallet::LoadKeyMetadata(const CPubKey &pubkey, const CKeyMetadata &meta)
     return true;
 }
 
+bool CWallet::LoadKey(const CKey& key)
+{
+    if (!CCryptoKeyStore::AddKey(key))
+        return false;
+    AddToScriptFilter(key.GetPubKey().GetID());
+    return true;
+}
+
 bool CWallet::LoadCryptedKey(const CPubKey &vchPubKey, const std::vector<unsigned char> &vchCryptedSecret)
 {
-    return CCryptoKeyStore::AddCryptedKey(vchPubKey, vchCryptedSecret);
+    if (!CCryptoKeyStore::AddCryptedKey(vchPubKey, vchCryptedSecret))
+        return false;
+    AddToScriptFilter(vchPubKey.GetID());
+    return true;
 }
 
 bool CWallet::AddCScript(const CScript& redeemScript)
 {
     if (!CCryptoKeyStore::AddCScript(redeemScript))
         return false;
+    AddToScriptFilter(redeemScript.GetID());
     if (!fFileBacked)
         return true;
     return CWalletDB(strWalletFile).WriteCScript(Hash160(redeemScript), redeemScript);
@@ -182,7 +197,47 @@ bool CWallet::LoadCScript(const CScript& redeemScript)
         return true;
     }
 
-    return CCryptoKeyStore::AddCScript(redeemScript);
+    if (!CCryptoKeyStore::AddCScript(redeemScript))
+        return false;
+    AddToScriptFilter(redeemScript.GetID());
+    return true;
+}
+
+void CWallet::AddToScriptFilter(const uint160& id)
+{
+    const uint64_t nBit = id.GetUint64(0) % (scriptFilter.size() * 64);
+    scriptFilter[nBit / 64].fetch_or(uint64_t{1} << (nBit % 64));
+}
+
+bool CWallet::MayBeMine(const CScript& scriptPubKey) const
+{
+    uint160 id;
+
+    if (scriptPubKey.size() == 25 && scriptPubKey[0] == OP_DUP && scriptPubKey[1] == OP_HASH160
+        && scriptPubKey[2] == 20 && scriptPubKey[23] == OP_EQUALVERIFY && scriptPubKey[24] == OP_CHECKSIG)
+    {
+        // Pay to public key hash: the script holds the key ID
+        memcpy(id.begin(), &scriptPubKey[3], 20);
+    }
+    else if (scriptPubKey.IsPayToScriptHash())
+    {
+        // Pay to script hash: the script holds the redeem script ID
+        memcpy(id.begin(), &scriptPubKey[2], 20);
+    }
+    else if (((scriptPubKey.size() == 35 && scriptPubKey[0] == 33) || (scriptPubKey.size() == 67 && scriptPubKey[0] == 65))
+        && scriptPubKey.back() == OP_CHECKSIG)
+    {
+        // Pay to public key: the key ID is the hash of the public key
+        id = Hash160(scriptPubKey.begin() + 1, scriptPubKey.end() - 1);
+    }
+    else
+    {
+        // Bare multisig and nonstandard scripts take the full path:
+        return true;
+    }
+
+    const uint64_t nBit = id.GetUint64(0) % (scriptFilter.size() * 64);
+    return scriptFilter[nBit / 64].load(std::memory_order_relaxed) & (uint64_t{1} << (nBit % 64));
 }
 
 bool CWallet::Unlock(const SecureString& strWalletPassphrase)
@@ -386,7 +441,9 @@ int64_t CWallet::IncOrderPosNext(CWalletDB *pwalletdb)
 {
     AssertLockHeld(cs_wallet); // nOrderPosNext
     int64_t nRet = nOrderPosNext++;
-    if (pwalletdb) {
+    if (nBatchDepth > 0) {
+        fBatchedOrderPos = true;
+    } else if (pwalletdb) {
         pwalletdb->WriteOrderPosNext(nOrderPosNext);
     } else {
         CWalletDB(strWalletFile).WriteOrderPosNext(nOrderPosNext);
@@ -394,6 +451,72 @@ int64_t CWallet::IncOrderPosNext(CWalletDB *pwalletdb)
     return nRet;
 }
 
+bool CWallet::QueueBatchedWrite(const CWalletTx& wtx) const
+{
+    LOCK(cs_wallet);
+
+    if (nBatchDepth == 0)
+        return false;
+
+    // The batch writes the transactions from mapWallet when it commits:
+    uint256 hash = wtx.GetHash();
+    map<uint256, CWalletTx>::const_iterator mi = mapWallet.find(hash);
+    if (mi == mapWallet.end() || &mi->second != &wtx)
+        return false;
+
+    setBatchedTx.insert(hash);
+    return true;
+}
+
+void CWallet::CommitWalletBatch()
+{
+    AssertLockHeld(cs_wallet);
+
+    if (setBatchedTx.empty() && !fBatchedOrderPos)
+        return;
+
+    int64_t nStart = GetTimeMillis();
+    CWalletDB walletdb(strWalletFile, "r+", false);
+
+    bool fOk = walletdb.TxnBegin();
+    for (auto it = setBatchedTx.begin(); fOk && it != setBatchedTx.end(); ++it)
+    {
+        map<uint256, CWalletTx>::const_iterator mi = mapWallet.find(*it);
+        if (mi != mapWallet.end())
+            fOk = walletdb.WriteTx(*it, mi->second);
+    }
+    if (fOk && fBatchedOrderPos)
+        fOk = walletdb.WriteOrderPosNext(nOrderPosNext);
+
+    if (fOk)
+        fOk = walletdb.TxnCommit();
+    else
+        walletdb.TxnAbort();
+
+    if (fOk)
+    {
+        LogPrint(BCLog::LogFlags::VERBOSE, "CommitWalletBatch: wrote %" PRIszu " transactions in %" PRId64 "ms",
+                 setBatchedTx.size(), GetTimeMillis() - nStart);
+    }
+    else
+    {
+        // Fall back to individual writes rather than lose the updates:
+        error("%s: batched write failed, writing %" PRIszu " transactions individually", __func__, setBatchedTx.size());
+
+        for (const auto& hash : setBatchedTx)
+        {
+            map<uint256, CWalletTx>::const_iterator mi = mapWallet.find(hash);
+            if (mi != mapWallet.end())
+                walletdb.WriteTx(hash, mi->second);
+        }
+        if (fBatchedOrderPos)
+            walletdb.WriteOrderPosNext(nOrderPosNext);
+    }
+
+    setBatchedTx.clear();
+    fBatchedOrderPos = false;
+}
+
 CWallet::TxItems CWallet::OrderedTxItems(std::list<CAccountingEntry>& acentries, std::string strAccount)
 {
     AssertLockHeld(cs_wallet); // mapWallet
@@ -419,6 +542,84 @@ CWallet::TxItems CWallet::OrderedTxItems(std::list<CAccountingEntry>& acentries,
     return txOrdered;
 }
 
+void CWallet::VisitTxItemsNewestFirst(const std::string& strAccount, const std::function<bool(const TxPair&)>& visitor)
+{
+    AssertLockHeld(cs_wallet); // mapWalletOrdered
+
+    // Accounting entries are not kept in memory. Read them once and merge them into the walk over
+    // the transaction index. Entries that share an order position with a transaction come first, as
+    // they do in reverse iteration of OrderedTxItems.
+    CWalletDB walletdb(strWalletFile);
+    std::list<CAccountingEntry> acentries;
+    walletdb.ListAccountCreditDebit(strAccount, acentries);
+
+    std::vector<CAccountingEntry*> vAcentries;
+    vAcentries.reserve(acentries.size());
+    for (auto& entry : acentries)
+        vAcentries.push_back(&entry);
+
+    std::stable_sort(vAcentries.begin(), vAcentries.end(),
+        [](const CAccountingEntry* a, const CAccountingEntry* b) { return a->nOrderPos < b->nOrderPos; });
+
+    std::vector<CAccountingEntry*>::reverse_iterator itAcentry = vAcentries.rbegin();
+    std::multimap<int64_t, CWalletTx*>::reverse_iterator itTx = mapWalletOrdered.rbegin();
+    std::multimap<int64_t, uint256>::reverse_iterator itArchived = mapArchivedOrdered.rbegin();
+
+    while (true)
+    {
+        const bool fAcentry = itAcentry != vAcentries.rend();
+        const bool fTx = itTx != mapWalletOrdered.rend();
+        const bool fArchived = itArchived != mapArchivedOrdered.rend();
+
+        if (!fAcentry && !fTx && !fArchived)
+            break;
+
+        TxPair item((CWalletTx*)0, (CAccountingEntry*)0);
+        CWalletTx wtxArchived;
+
+        if (fAcentry
+            && (!fTx || (*itAcentry)->nOrderPos >= itTx->first)
+            && (!fArchived || (*itAcentry)->nOrderPos >= itArchived->first))
+        {
+            item.second = *itAcentry++;
+        }
+        else if (fTx && (!fArchived || itTx->first >= itArchived->first))
+        {
+            item.first = (itTx++)->second;
+        }
+        else
+        {
+            // Archived transactions are read from the wallet file only when
+            // the walk reaches them:
+            const uint256 hash = (itArchived++)->second;
+            if (!walletdb.ReadArchivedTx(hash, wtxArchived))
+            {
+                LogPrintf("VisitTxItemsNewestFirst: failed to read archived transaction %s", hash.ToString());
+                continue;
+            }
+            wtxArchived.BindWallet(this);
+            item.first = &wtxArchived;
+        }
+
+        if (!visitor(item))
+            break;
+    }
+}
+
+void CWallet::RebuildOrderedIndex()
+{
+    AssertLockHeld(cs_wallet); // mapWallet
+
+    mapWalletOrdered.clear();
+    mapArchivedOrdered.clear();
+
+    for (auto& item : mapWallet)
+        mapWalletOrdered.insert(std::make_pair(item.second.nOrderPos, &item.second));
+
+    for (const auto& item : mapArchived)
+        mapArchivedOrdered.insert(std::make_pair(item.second.nOrderPos, item.first));
+}
+
 void CWallet::WalletUpdateSpent(const CTransaction &tx, bool fBlock, CWalletDB* pwalletdb)
 {
     // Anytime a signature is successfully verified, it's proof the outpoint is spent.
@@ -439,6 +640,7 @@ void CWallet::WalletUpdateSpent(const CTransaction &tx, bool fBlock, CWalletDB*
                     LogPrint(BCLog::LogFlags::VERBOSE, "WalletUpdateSpent found spent coin %s gC %s", FormatMoney(wtx.GetCredit()), wtx.GetHash().ToString());
                     wtx.MarkSpent(txin.prevout.n);
                     wtx.WriteToDisk(pwalletdb);
+                    UpdateUnspentIndex(wtx);
                     NotifyTransactionChanged(this, txin.prevout.hash, CT_UPDATED);
                 }
             }
@@ -459,6 +661,8 @@ void CWallet::WalletUpdateSpent(const CTransaction &tx, bool fBlock, CWalletDB*
                     NotifyTransactionChanged(this, hash, CT_UPDATED);
                 }
             }
+
+            UpdateUnspentIndex(wtx);
         }
 
     }
@@ -470,9 +674,44 @@ void CWallet::MarkDirty()
         LOCK(cs_wallet);
         for (auto &item : mapWallet)
             item.second.MarkDirty();
+
+        // The set of owned outputs may have changed too:
+        RebuildUnspentIndex();
     }
 }
 
+void CWallet::UpdateUnspentIndex(const CWalletTx& wtx)
+{
+    AssertLockHeld(cs_wallet); // mapWalletUnspent
+
+    balanceCache.fValid = false;
+
+    for (unsigned int i = 0; i < wtx.vout.size(); i++)
+    {
+        if (!wtx.IsSpent(i) && IsMine(wtx.vout[i]) != ISMINE_NO)
+        {
+            mapWalletUnspent[wtx.GetHash()] = &wtx;
+            return;
+        }
+    }
+
+    mapWalletUnspent.erase(wtx.GetHash());
+}
+
+void CWallet::RebuildUnspentIndex()
+{
+    LOCK(cs_wallet);
+
+    mapWalletUnspent.clear();
+    balanceCache.fValid = false;
+
+    for (const auto& item : mapWallet)
+        UpdateUnspentIndex(item.second);
+
+    LogPrint(BCLog::LogFlags::VERBOSE, "RebuildUnspentIndex: %" PRIszu " of %" PRIszu " transactions have unspent outputs",
+             mapWalletUnspent.size(), mapWallet.size());
+}
+
 bool CWallet::AddToWallet(const CWalletTx& wtxIn, CWalletDB* pwalletdb)
 {
     uint256 hash = wtxIn.GetHash();
@@ -487,6 +726,7 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, CWalletDB* pwalletdb)
         {
             wtx.nTimeReceived = GetAdjustedTime();
             wtx.nOrderPos = IncOrderPosNext(pwalletdb);
+            mapWalletOrdered.insert(std::make_pair(wtx.nOrderPos, &wtx));
 
             wtx.nTimeSmart = wtx.nTimeReceived;
             if (!wtxIn.hashBlock.IsNull())
@@ -499,14 +739,11 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, CWalletDB* pwalletdb)
                     {
                         // Tolerate times up to the last timestamp in the wallet not more than 5 minutes into the future
                         int64_t latestTolerated = latestNow + 300;
-                        std::list<CAccountingEntry> acentries;
-                        TxItems txOrdered = OrderedTxItems(acentries);
-                        for (TxItems::reverse_iterator it = txOrdered.rbegin(); it != txOrdered.rend(); ++it)
-                        {
-                            CWalletTx *const pwtx = (*it).second.first;
+                        VisitTxItemsNewestFirst("", [&](const TxPair& item) {
+                            CWalletTx *const pwtx = item.first;
                             if (pwtx == &wtx)
-                                continue;
-                            CAccountingEntry *const pacentry = (*it).second.second;
+                                return true;
+                            CAccountingEntry *const pacentry = item.second;
                             int64_t nSmartTime;
                             if (pwtx)
                             {
@@ -521,9 +758,10 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, CWalletDB* pwalletdb)
                                 latestEntry = nSmartTime;
                                 if (nSmartTime > latestNow)
                                     latestNow = nSmartTime;
-                                break;
+                                return false;
                             }
-                        }
+                            return true;
+                        });
                     }
 
                     unsigned int& blocktime = mapItem->second->nTime;
@@ -564,6 +802,8 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, CWalletDB* pwalletdb)
         if (fInsertedNew || fUpdated)
             if (!wtx.WriteToDisk(pwalletdb))
                 return false;
+
+        UpdateUnspentIndex(wtx);
         if(!fQtActive)
         {
             // If default receiving address gets used, replace it with a new one
@@ -613,6 +853,9 @@ bool CWallet::AddToWalletIfInvolvingMe(const CTransaction& tx, const CBlock* pbl
         bool fExisted = mapWallet.count(hash);
         if (fExisted && !fUpdate) return false;
 
+        // A rescan finds archived transactions again. Leave them in the archive:
+        if (mapArchived.count(hash)) return false;
+
         // Do not flush the wallet here for performance reasons
         // this is safe, as in case of a crash, we rescan the necessary blocks on startup.
         CWalletDB walletdb(strWalletFile, "r+", false);
@@ -638,8 +881,25 @@ bool CWallet::EraseFromWallet(uint256 hash)
         return false;
     {
         LOCK(cs_wallet);
-        if (mapWallet.erase(hash))
+        mapWalletUnspent.erase(hash);
+        balanceCache.fValid = false;
+
+        std::map<uint256, CWalletTx>::iterator mi = mapWallet.find(hash);
+        if (mi != mapWallet.end())
+        {
+            auto range = mapWalletOrdered.equal_range(mi->second.nOrderPos);
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                if (it->second == &mi->second)
+                {
+                    mapWalletOrdered.erase(it);
+                    break;
+                }
+            }
+
+            mapWallet.erase(mi);
             CWalletDB(strWalletFile).EraseTx(hash);
+        }
     }
     return true;
 }
@@ -656,6 +916,13 @@ isminetype CWallet::IsMine(const CTxIn &txin) const
             if (txin.prevout.n < prev.vout.size())
                 return IsMine(prev.vout[txin.prevout.n]);
         }
+        map<uint256, CArchivedWalletTx>::const_iterator ai = mapArchived.find(txin.prevout.hash);
+        if (ai != mapArchived.end())
+        {
+            const CArchivedWalletTx& prev = (*ai).second;
+            if (txin.prevout.n < prev.vout.size())
+                return IsMine(prev.vout[txin.prevout.n]);
+        }
     }
     return ISMINE_NO;
 }
@@ -672,6 +939,14 @@ int64_t CWallet::GetDebit(const CTxIn &txin,const isminefilter& filter) const
                  if (IsMine(prev.vout[txin.prevout.n]) & filter)
                     return prev.vout[txin.prevout.n].nValue;
         }
+        map<uint256, CArchivedWalletTx>::const_iterator ai = mapArchived.find(txin.prevout.hash);
+        if (ai != mapArchived.end())
+        {
+            const CArchivedWalletTx& prev = (*ai).second;
+            if (txin.prevout.n < prev.vout.size())
+                 if (IsMine(prev.vout[txin.prevout.n]) & filter)
+                    return prev.vout[txin.prevout.n].nValue;
+        }
     }
     return 0;
 }
@@ -1027,6 +1302,9 @@ void CWalletTx::AddSupportingTransactions(CTxDB& txdb)
 
 bool CWalletTx::WriteToDisk(CWalletDB *pwalletdb)
 {
+    if (pwallet && pwallet->QueueBatchedWrite(*this))
+        return true;
+
     return pwalletdb->WriteTx(GetHash(), *this);
 }
 
@@ -1035,30 +1313,112 @@ bool CWalletTx::WriteToDisk(CWalletDB *pwalletdb)
 // exist in the wallet will be updated.
 int CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, bool fUpdate)
 {
+    // Blocks are read from disk and their outputs tested against the key store in
+    // batches on worker threads. Whether a transaction spends our coins depends on
+    // the transactions found before it, so the matches are applied to the wallet in
+    // chain order on this thread.
+    static const size_t SCAN_BATCH_SIZE = 500;
+
+    struct ScannedBlock
+    {
+        CBlockIndex* pindex;
+        CBlock block;
+        std::vector<bool> vPaysToMe;
+    };
+
     int ret = 0;
 
+    LOCK2(cs_main, cs_wallet);
+
+    if (!pindexStart)
+        return ret;
+
+    // Bring back archived transactions whose spenders left the main chain so
+    // that the rescan sees their outputs as ours again:
+    int64_t nValueRestored = 0;
+    RestoreUnspentArchivedTx(false, nValueRestored);
+
+    const int nStartHeight = pindexStart->nHeight;
+    const int nEndHeight = std::max(nStartHeight, pindexBest ? pindexBest->nHeight : 0);
+    int64_t nLastProgress = GetTimeMillis();
+
+    std::vector<ScannedBlock> vBatch;
+    vBatch.reserve(SCAN_BATCH_SIZE);
+
     CBlockIndex* pindex = pindexStart;
+    while (pindex)
     {
-        LOCK2(cs_main, cs_wallet);
-        while (pindex)
+        vBatch.clear();
+
+        for (; pindex && vBatch.size() < SCAN_BATCH_SIZE; pindex = pindex->pnext)
         {
             // no need to read and scan block, if block was created before
             // our wallet birthday (as adjusted for block time variability)
-            if (nTimeFirstKey && (pindex->nTime < (nTimeFirstKey - 7200))) {
-                pindex = pindex->pnext;
+            if (nTimeFirstKey && (pindex->nTime < (nTimeFirstKey - 7200)))
                 continue;
+
+            vBatch.emplace_back();
+            vBatch.back().pindex = pindex;
+        }
+
+        ParallelFor(vBatch.size(), [&](const size_t i) {
+            ScannedBlock& scanned = vBatch[i];
+
+            scanned.block.ReadFromDisk(scanned.pindex, true);
+            scanned.vPaysToMe.reserve(scanned.block.vtx.size());
+
+            for (auto const& tx : scanned.block.vtx)
+            {
+                bool fPaysToMe = false;
+                for (auto const& txout : tx.vout)
+                {
+                    if (IsMine(txout) != ISMINE_NO)
+                    {
+                        fPaysToMe = true;
+                        break;
+                    }
+                }
+                scanned.vPaysToMe.push_back(fPaysToMe);
             }
+        });
+
+        CWalletDBBatch batch(this);
 
-            CBlock block;
-            block.ReadFromDisk(pindex, true);
-            for (auto const& tx : block.vtx)
+        for (auto const& scanned : vBatch)
+        {
+            for (size_t i = 0; i < scanned.block.vtx.size(); i++)
             {
-                if (AddToWalletIfInvolvingMe(tx, &block, fUpdate))
+                const CTransaction& tx = scanned.block.vtx[i];
+
+                // A transaction that neither pays to us, spends one of our
+                // transactions, nor already exists in the wallet cannot change
+                // anything in AddToWalletIfInvolvingMe:
+                bool fInvolvesMe = scanned.vPaysToMe[i] || mapWallet.count(tx.GetHash());
+                for (auto const& txin : tx.vin)
+                {
+                    if (fInvolvesMe)
+                        break;
+                    fInvolvesMe = mapWallet.count(txin.prevout.hash) || mapArchived.count(txin.prevout.hash);
+                }
+
+                if (fInvolvesMe && AddToWalletIfInvolvingMe(tx, &scanned.block, fUpdate))
                     ret++;
             }
-            pindex = pindex->pnext;
+        }
+
+        if (!vBatch.empty() && GetTimeMillis() - nLastProgress >= 10000)
+        {
+            const int nHeight = vBatch.back().pindex->nHeight;
+
+            LogPrintf("ScanForWalletTransactions: scanned to height %d (%.1f%%), %d transactions found",
+                nHeight,
+                100.0 * (nHeight - nStartHeight) / std::max(1, nEndHeight - nStartHeight),
+                ret);
+
+            nLastProgress = GetTimeMillis();
         }
     }
+
     return ret;
 }
 
@@ -1106,6 +1466,7 @@ void CWallet::ReacceptWalletTransactions()
                     CWalletDB walletdb(strWalletFile);
 
                     wtx.WriteToDisk(&walletdb);
+                    UpdateUnspentIndex(wtx);
                 }
             }
             else
@@ -1241,50 +1602,59 @@ void CWallet::ResendWalletTransactions(bool fForce)
 //
 
 
-int64_t CWallet::GetBalance() const
+const CWallet::CBalanceCache& CWallet::GetBalanceCache() const
 {
-    int64_t nTotal = 0;
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_wallet);
+
+    if (balanceCache.fValid && balanceCache.pindexTip == pindexBest)
+        return balanceCache;
+
+    CBalanceCache cache;
+
+    for (const auto& item : mapWalletUnspent)
     {
-        LOCK2(cs_main, cs_wallet);
-        for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
-        {
-            const CWalletTx* pcoin = &(*it).second;
-            if (pcoin->IsTrusted() && (pcoin->IsConfirmed() || pcoin->fFromMe))
-                nTotal += pcoin->GetAvailableCredit();
-        }
+        const CWalletTx* pcoin = item.second;
+
+        if (pcoin->IsTrusted() && (pcoin->IsConfirmed() || pcoin->fFromMe))
+            cache.nBalance += pcoin->GetAvailableCredit();
+
+        if (!IsFinalTx(*pcoin) || (!pcoin->IsConfirmed() && !pcoin->fFromMe && pcoin->IsInMainChain()))
+            cache.nUnconfirmed += pcoin->GetAvailableCredit();
+
+        if (pcoin->IsCoinBase() && pcoin->GetBlocksToMaturity() > 0 && pcoin->IsInMainChain())
+            cache.nImmature += GetCredit(*pcoin);
+
+        if (pcoin->IsCoinStake() && pcoin->GetBlocksToMaturity() > 0 && pcoin->GetDepthInMainChain() > 0)
+            cache.nStake += GetCredit(*pcoin);
     }
 
-    return nTotal;
+    cache.fValid = true;
+    cache.pindexTip = pindexBest;
+    balanceCache = cache;
+
+    return balanceCache;
+}
+
+int64_t CWallet::GetBalance() const
+{
+    LOCK2(cs_main, cs_wallet);
+
+    return GetBalanceCache().nBalance;
 }
 
 int64_t CWallet::GetUnconfirmedBalance() const
 {
-    int64_t nTotal = 0;
-    {
-        LOCK2(cs_main, cs_wallet);
-        for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
-        {
-            const CWalletTx* pcoin = &(*it).second;
-            if (!IsFinalTx(*pcoin) || (!pcoin->IsConfirmed() && !pcoin->fFromMe && pcoin->IsInMainChain()))
-                nTotal += pcoin->GetAvailableCredit();
-        }
-    }
-    return nTotal;
+    LOCK2(cs_main, cs_wallet);
+
+    return GetBalanceCache().nUnconfirmed;
 }
 
 int64_t CWallet::GetImmatureBalance() const
 {
-    int64_t nTotal = 0;
-    {
-        LOCK2(cs_main, cs_wallet);
-        for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
-        {
-            const CWalletTx& pcoin = (*it).second;
-            if (pcoin.IsCoinBase() && pcoin.GetBlocksToMaturity() > 0 && pcoin.IsInMainChain())
-                nTotal += GetCredit(pcoin);
-        }
-    }
-    return nTotal;
+    LOCK2(cs_main, cs_wallet);
+
+    return GetBalanceCache().nImmature;
 }
 
 // populate vCoins with vector of spendable COutputs
@@ -1294,9 +1664,9 @@ void CWallet::AvailableCoins(vector<COutput>& vCoins, bool fOnlyConfirmed, const
 
     {
         LOCK2(cs_main, cs_wallet);
-        for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
+        for (const auto& item : mapWalletUnspent)
         {
-            const CWalletTx* pcoin = &(*it).second;
+            const CWalletTx* pcoin = item.second;
 			int nDepth = pcoin->GetDepthInMainChain();
 
 			if (!fIncludeStakedCoins)
@@ -1324,7 +1694,7 @@ void CWallet::AvailableCoins(vector<COutput>& vCoins, bool fOnlyConfirmed, const
             for (unsigned int i = 0; i < pcoin->vout.size(); i++)
 			{
                 if ((!(pcoin->IsSpent(i)) && (IsMine(pcoin->vout[i]) != ISMINE_NO) && pcoin->vout[i].nValue >= nMinimumInputValue &&
-                   (!coinControl || !coinControl->HasSelected() || coinControl->IsSelected((*it).first, i)))
+                   (!coinControl || !coinControl->HasSelected() || coinControl->IsSelected(item.first, i)))
 	     	 	   || (fIncludeStakedCoins && pcoin->IsCoinStake() && pcoin->GetBlocksToMaturity() > 0 && pcoin->GetDepthInMainChain() > 0))
 				   {
 				        vCoins.push_back(COutput(pcoin, i, nDepth));
@@ -1350,9 +1720,9 @@ void CWallet::AvailableCoinsForStaking(vector<COutput>& vCoins, unsigned int nSp
         unsigned int transactions = 0;
         unsigned int txns_w_avail_outputs = 0;
 
-        for (const auto& it : mapWallet)
+        for (const auto& item : mapWalletUnspent)
         {
-            const CWalletTx* pcoin = &it.second;
+            const CWalletTx* pcoin = item.second;
 
             // Track number of transactions processed for instrumentation purposes.
             ++transactions;
@@ -1434,7 +1804,57 @@ void CWallet::AvailableCoinsForStaking(vector<COutput>& vCoins, unsigned int nSp
     }
 }
 
-static void ApproximateBestSubset(vector<pair<int64_t, pair<const CWalletTx*,unsigned int> > >vValue, int64_t nTotalLower, int64_t nTargetValue,
+// Search for a subset of vValue that sums to exactly nTargetValue. vValue must be
+// sorted by descending value. This walks the include/exclude decisions depth-first
+// and backtracks when the selection overshoots the target or the remaining coins
+// cannot reach it. Coins with the same value as a coin just excluded are skipped
+// because they lead to the same sums. Gives up after nMaxTries steps.
+static bool SelectCoinsBnB(const vector<pair<int64_t, pair<const CWalletTx*,unsigned int> > >& vValue, int64_t nTargetValue,
+                           vector<char>& vfBest, int nMaxTries = 100000)
+{
+    const size_t nCoins = vValue.size();
+
+    // vRemaining[i] is the total value of the coins from i onward
+    vector<int64_t> vRemaining(nCoins + 1, 0);
+    for (size_t i = nCoins; i-- > 0;)
+        vRemaining[i] = vRemaining[i + 1] + vValue[i].first;
+
+    vector<char> vfIncluded(nCoins, false);
+    int64_t nTotal = 0;
+    size_t i = 0;
+
+    for (int nTry = 0; nTry < nMaxTries; nTry++)
+    {
+        if (nTotal == nTargetValue)
+        {
+            vfBest = vfIncluded;
+            return true;
+        }
+
+        if (nTotal < nTargetValue && nTotal + vRemaining[i] >= nTargetValue)
+        {
+            vfIncluded[i] = true;
+            nTotal += vValue[i].first;
+            i++;
+            continue;
+        }
+
+        // Exclude the most recently included coin and continue after it:
+        while (i > 0 && !vfIncluded[i - 1])
+            i--;
+        if (i == 0)
+            return false;
+
+        vfIncluded[--i] = false;
+        nTotal -= vValue[i].first;
+
+        for (i++; i < nCoins && vValue[i].first == vValue[i - 1].first; i++);
+    }
+
+    return false;
+}
+
+static void ApproximateBestSubset(const vector<pair<int64_t, pair<const CWalletTx*,unsigned int> > >& vValue, int64_t nTotalLower, int64_t nTargetValue,
                                   vector<char>& vfBest, int64_t& nBest, int iterations = 1000)
 {
     vector<char> vfIncluded;
@@ -1483,28 +1903,16 @@ static void ApproximateBestSubset(vector<pair<int64_t, pair<const CWalletTx*,uns
 // ppcoin: total coins staked (non-spendable until maturity)
 int64_t CWallet::GetStake() const
 {
-    int64_t nTotal = 0;
     LOCK2(cs_main, cs_wallet);
-    for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
-    {
-        const CWalletTx* pcoin = &(*it).second;
-        if (pcoin->IsCoinStake() && pcoin->GetBlocksToMaturity() > 0 && pcoin->GetDepthInMainChain() > 0)
-            nTotal += CWallet::GetCredit(*pcoin);
-    }
-    return nTotal;
+
+    return GetBalanceCache().nStake;
 }
 
 int64_t CWallet::GetNewMint() const
 {
-    int64_t nTotal = 0;
     LOCK2(cs_main, cs_wallet);
-    for (map<uint256, CWalletTx>::const_iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
-    {
-        const CWalletTx* pcoin = &(*it).second;
-        if (pcoin->IsCoinStake() && pcoin->GetBlocksToMaturity() > 0 && pcoin->GetDepthInMainChain() > 0)
-            nTotal += CWallet::GetCredit(*pcoin);
-    }
-    return nTotal;
+
+    return GetBalanceCache().nStake;
 }
 
 // This comparator is needed since std::sort alone cannot sort COutput
@@ -1587,14 +1995,28 @@ bool CWallet::SelectCoinsMinConf(int64_t nTargetValue, unsigned int nSpendTime,
         return true;
     }
 
-    // Solve subset sum by stochastic approximation
+    // Search for an exact subset first, then fall back to stochastic approximation.
+    // Each approximation pass walks every candidate coin, so fragmented wallets get
+    // fewer passes to keep the cost of a selection bounded:
     sort(vValue.rbegin(), vValue.rend(), CompareValueOnly());
     vector<char> vfBest;
     int64_t nBest;
 
-    ApproximateBestSubset(vValue, nTotalLower, nTargetValue, vfBest, nBest, 1000);
-    if (nBest != nTargetValue && nTotalLower >= nTargetValue + CENT)
-        ApproximateBestSubset(vValue, nTotalLower, nTargetValue + CENT, vfBest, nBest, 1000);
+    const int nIterations = std::max<int>(10, std::min<int>(1000, 1000000 / vValue.size()));
+
+    if (SelectCoinsBnB(vValue, nTargetValue, vfBest))
+        nBest = nTargetValue;
+    else
+    {
+        ApproximateBestSubset(vValue, nTotalLower, nTargetValue, vfBest, nBest, nIterations);
+        if (nBest != nTargetValue && nTotalLower >= nTargetValue + CENT)
+        {
+            if (SelectCoinsBnB(vValue, nTargetValue + CENT, vfBest))
+                nBest = nTargetValue + CENT;
+            else
+                ApproximateBestSubset(vValue, nTotalLower, nTargetValue + CENT, vfBest, nBest, nIterations);
+        }
+    }
 
     // If we have a bigger coin and (either the stochastic approximation didn't find a good solution,
     //                                   or the next bigger coin is closer), return the bigger coin
@@ -2127,6 +2549,7 @@ bool CWallet::CommitTransaction(CWalletTx& wtxNew, CReserveKey& reservekey)
                 coin.BindWallet(this);
                 coin.MarkSpent(txin.prevout.n);
                 coin.WriteToDisk(pwalletdb);
+                UpdateUnspentIndex(coin);
                 NotifyTransactionChanged(this, coin.GetHash(), CT_UPDATED);
             }
 
@@ -2229,6 +2652,17 @@ DBErrors CWallet::LoadWallet(bool& fFirstRunRet)
         return nLoadWalletRet;
     fFirstRunRet = !vchDefaultKey.IsValid();
 
+    int64_t nIndexStart = GetTimeMillis();
+
+    {
+        LOCK(cs_wallet);
+        RebuildOrderedIndex();
+    }
+
+    RebuildUnspentIndex();
+
+    LogPrintf("LoadWallet: built transaction indexes in %" PRId64 "ms", GetTimeMillis() - nIndexStart);
+
     NewThread(ThreadFlushWalletDB, &strWalletFile);
 
     LogPrintf("LoadWallet: started wallet flush thread.");
@@ -2503,9 +2937,9 @@ std::map<CTxDestination, int64_t> CWallet::GetAddressBalances()
 
     {
         LOCK(cs_wallet);
-        for (auto walletEntry : mapWallet)
+        for (const auto& item : mapWalletUnspent)
         {
-            CWalletTx *pcoin = &walletEntry.second;
+            const CWalletTx *pcoin = item.second;
 
             if (!IsFinalTx(*pcoin) || !pcoin->IsTrusted())
                 continue;
@@ -2552,8 +2986,22 @@ set< set<CTxDestination> > CWallet::GetAddressGroupings()
             // group all input addresses with each other
             for (auto const& txin : pcoin->vin)
             {
+                // The input may spend an archived transaction:
+                const std::vector<CTxOut>* pvout = nullptr;
+                map<uint256, CWalletTx>::const_iterator mi = mapWallet.find(txin.prevout.hash);
+                if (mi != mapWallet.end())
+                    pvout = &mi->second.vout;
+                else
+                {
+                    map<uint256, CArchivedWalletTx>::const_iterator ai = mapArchived.find(txin.prevout.hash);
+                    if (ai != mapArchived.end())
+                        pvout = &ai->second.vout;
+                }
+
                 CTxDestination address;
-                if(!ExtractDestination(mapWallet[txin.prevout.hash].vout[txin.prevout.n].scriptPubKey, address))
+                if (!pvout || txin.prevout.n >= pvout->size())
+                    continue;
+                if(!ExtractDestination((*pvout)[txin.prevout.n].scriptPubKey, address))
                     continue;
                 grouping.insert(address);
             }
@@ -2562,7 +3010,6 @@ set< set<CTxDestination> > CWallet::GetAddressGroupings()
             for (auto const& txout : pcoin->vout)
                 if (IsChange(txout))
                 {
-                    CWalletTx tx = mapWallet[pcoin->vin[0].prevout.hash];
                     CTxDestination txoutAddr;
                     if(!ExtractDestination(txout.scriptPubKey, txoutAddr))
                         continue;
@@ -2629,13 +3076,20 @@ void CWallet::FixSpentCoins(int& nMismatchFound, int64_t& nBalanceInQuestion, bo
     nBalanceInQuestion = 0;
 
     LOCK(cs_wallet);
+
+    CWalletDB walletdb(strWalletFile);
+
+    // Coins can also be lost in the archive when a reorganization orphans
+    // the transaction that spent them:
+    int64_t nArchivedInQuestion = 0;
+    nMismatchFound += RestoreUnspentArchivedTx(fCheckOnly, nArchivedInQuestion);
+    nBalanceInQuestion += nArchivedInQuestion;
+
     vector<CWalletTx*> vCoins;
     vCoins.reserve(mapWallet.size());
     for (map<uint256, CWalletTx>::iterator it = mapWallet.begin(); it != mapWallet.end(); ++it)
         vCoins.push_back(&(*it).second);
 
-    CWalletDB walletdb(strWalletFile);
-
     CTxDB txdb("r");
     for (auto const& pcoin : vCoins)
     {
@@ -2655,6 +3109,7 @@ void CWallet::FixSpentCoins(int& nMismatchFound, int64_t& nBalanceInQuestion, bo
                 {
                     pcoin->MarkUnspent(n);
                     pcoin->WriteToDisk(&walletdb);
+                    UpdateUnspentIndex(*pcoin);
                 }
             }
             else if ((IsMine(pcoin->vout[n]) != ISMINE_NO) && !pcoin->IsSpent(n) && (txindex.vSpent.size() > n && !txindex.vSpent[n].IsNull()))
@@ -2667,6 +3122,7 @@ void CWallet::FixSpentCoins(int& nMismatchFound, int64_t& nBalanceInQuestion, bo
                 {
                     pcoin->MarkSpent(n);
                     pcoin->WriteToDisk(&walletdb);
+                    UpdateUnspentIndex(*pcoin);
                 }
             }
         }
@@ -2685,6 +3141,10 @@ void CWallet::DisableTransaction(const CTransaction &tx)
 
     for (auto const& txin : tx.vin)
     {
+        // The coinstake may spend an output of an archived transaction:
+        if (!mapWallet.count(txin.prevout.hash))
+            RestoreArchivedTx(txin.prevout.hash);
+
         map<uint256, CWalletTx>::iterator mi = mapWallet.find(txin.prevout.hash);
         if (mi != mapWallet.end())
         {
@@ -2693,11 +3153,259 @@ void CWallet::DisableTransaction(const CTransaction &tx)
             {
                 prev.MarkUnspent(txin.prevout.n);
                 prev.WriteToDisk(&walletdb);
+                UpdateUnspentIndex(prev);
             }
         }
     }
 }
 
+int CWallet::ArchiveTransactions(int nMinDepth)
+{
+    // Commit the archive in chunks to keep each database transaction small:
+    static const size_t ARCHIVE_BATCH_SIZE = 1000;
+
+    if (!fFileBacked || nMinDepth <= 0)
+        return 0;
+
+    LOCK2(cs_main, cs_wallet);
+
+    if (!pindexBest)
+        return 0;
+
+    int64_t nStart = GetTimeMillis();
+    std::vector<uint256> vArchive;
+
+    // Spends recorded in the transaction index belong to the main chain, so a
+    // spend is deep enough unless it sits in one of the newest blocks:
+    std::set<std::pair<unsigned int, unsigned int>> setShallowBlocks;
+    for (const CBlockIndex* pindex = pindexBest;
+         pindex && pindexBest->nHeight - pindex->nHeight + 1 < nMinDepth;
+         pindex = pindex->pprev)
+    {
+        setShallowBlocks.emplace(pindex->nFile, pindex->nBlockPos);
+    }
+
+    CTxDB txdb("r");
+
+    // A reorganization that orphans the spender of an archived coin would
+    // hide the coin from the balance, so every output of ours must be spent
+    // by a transaction that is also deeply confirmed:
+    const auto fSpentDeeply = [&](const uint256& hash, const CWalletTx& wtx) {
+        CTxIndex txindex;
+        if (!txdb.ReadTxIndex(hash, txindex))
+            return false;
+
+        for (unsigned int n = 0; n < wtx.vout.size(); n++)
+        {
+            if (IsMine(wtx.vout[n]) == ISMINE_NO)
+                continue;
+
+            if (txindex.vSpent.size() <= n || txindex.vSpent[n].IsNull())
+                return false;
+
+            if (setShallowBlocks.count(std::make_pair(txindex.vSpent[n].nFile, txindex.vSpent[n].nBlockPos)))
+                return false;
+        }
+
+        return true;
+    };
+
+    for (const auto& item : mapWallet)
+    {
+        const CWalletTx& wtx = item.second;
+
+        // Fully spent and deeply confirmed, as are its spenders:
+        if (!mapWalletUnspent.count(item.first) && wtx.GetDepthInMainChain() >= nMinDepth)
+        {
+            if (fSpentDeeply(item.first, wtx))
+                vArchive.push_back(item.first);
+            continue;
+        }
+
+        // A coinbase or coinstake whose block left the main chain long ago:
+        if (!(wtx.IsCoinBase() || wtx.IsCoinStake()) || wtx.hashBlock.IsNull())
+            continue;
+
+        BlockMap::iterator mi = mapBlockIndex.find(wtx.hashBlock);
+        if (mi == mapBlockIndex.end() || !mi->second || mi->second->IsInMainChain())
+            continue;
+
+        if (pindexBest->nHeight - mi->second->nHeight >= nMinDepth)
+            vArchive.push_back(item.first);
+    }
+
+    int nArchived = 0;
+
+    for (size_t nBatchStart = 0; nBatchStart < vArchive.size(); nBatchStart += ARCHIVE_BATCH_SIZE)
+    {
+        const size_t nBatchEnd = std::min(vArchive.size(), nBatchStart + ARCHIVE_BATCH_SIZE);
+        std::vector<std::pair<uint256, CArchivedWalletTx>> vBatch;
+
+        CWalletDB walletdb(strWalletFile);
+        if (!walletdb.TxnBegin())
+        {
+            error("%s: failed to begin database transaction", __func__);
+            break;
+        }
+
+        bool fOk = true;
+        for (size_t i = nBatchStart; fOk && i < nBatchEnd; i++)
+        {
+            const CWalletTx& wtx = mapWallet[vArchive[i]];
+            CArchivedWalletTx archived(wtx.nOrderPos, wtx.vout);
+
+            fOk = walletdb.WriteArchivedTx(vArchive[i], wtx, archived) && walletdb.EraseTx(vArchive[i]);
+            vBatch.emplace_back(vArchive[i], std::move(archived));
+        }
+
+        if (!fOk || !walletdb.TxnCommit())
+        {
+            walletdb.TxnAbort();
+            error("%s: failed to write archived transactions", __func__);
+            break;
+        }
+
+        for (auto& item : vBatch)
+        {
+            mapWallet.erase(item.first);
+            mapWalletUnspent.erase(item.first);
+            mapArchived.emplace(item.first, std::move(item.second));
+            nArchived++;
+        }
+    }
+
+    if (nArchived > 0)
+    {
+        RebuildOrderedIndex();
+        RebuildUnspentIndex();
+
+        for (size_t i = 0; i < (size_t)nArchived; i++)
+            NotifyTransactionChanged(this, vArchive[i], CT_DELETED);
+    }
+
+    LogPrintf("ArchiveTransactions: archived %d of %" PRIszu " wallet transactions in %" PRId64 "ms",
+        nArchived, mapWallet.size() + nArchived, GetTimeMillis() - nStart);
+
+    return nArchived;
+}
+
+bool CWallet::RestoreArchivedTx(const uint256& hash)
+{
+    AssertLockHeld(cs_wallet); // mapWallet, mapArchived
+
+    map<uint256, CArchivedWalletTx>::iterator ai = mapArchived.find(hash);
+    if (ai == mapArchived.end())
+        return false;
+
+    CWalletTx wtx;
+    CWalletDB walletdb(strWalletFile);
+
+    if (!walletdb.ReadArchivedTx(hash, wtx))
+        return error("%s: failed to read archived transaction %s", __func__, hash.ToString());
+
+    if (!walletdb.TxnBegin())
+        return error("%s: failed to begin database transaction", __func__);
+
+    if (!walletdb.WriteTx(hash, wtx) || !walletdb.EraseArchivedTx(hash) || !walletdb.TxnCommit())
+    {
+        walletdb.TxnAbort();
+        return error("%s: failed to restore archived transaction %s", __func__, hash.ToString());
+    }
+
+    auto range = mapArchivedOrdered.equal_range(ai->second.nOrderPos);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second == hash)
+        {
+            mapArchivedOrdered.erase(it);
+            break;
+        }
+    }
+    mapArchived.erase(ai);
+
+    CWalletTx& restored = mapWallet.emplace(hash, wtx).first->second;
+    restored.BindWallet(this);
+    mapWalletOrdered.insert(std::make_pair(restored.nOrderPos, &restored));
+    UpdateUnspentIndex(restored);
+
+    LogPrintf("RestoreArchivedTx: restored %s", hash.ToString());
+
+    NotifyTransactionChanged(this, hash, CT_NEW);
+
+    return true;
+}
+
+int CWallet::RestoreUnspentArchivedTx(bool fCheckOnly, int64_t& nValueRestored)
+{
+    AssertLockHeld(cs_wallet); // mapArchived
+
+    nValueRestored = 0;
+
+    if (mapArchived.empty())
+        return 0;
+
+    std::vector<std::pair<uint256, std::vector<unsigned int>>> vRestore;
+
+    CTxDB txdb("r");
+    for (const auto& item : mapArchived)
+    {
+        // Orphaned coinbase and coinstake transactions have no index entry:
+        CTxIndex txindex;
+        if (!txdb.ReadTxIndex(item.first, txindex))
+            continue;
+
+        std::vector<unsigned int> vUnspent;
+        for (unsigned int n = 0; n < item.second.vout.size(); n++)
+        {
+            if ((IsMine(item.second.vout[n]) != ISMINE_NO) && (txindex.vSpent.size() <= n || txindex.vSpent[n].IsNull()))
+            {
+                LogPrintf("RestoreUnspentArchivedTx found lost coin %s gC %s[%d], %s",
+                    FormatMoney(item.second.vout[n].nValue), item.first.ToString(), n, fCheckOnly ? "repair not attempted" : "repairing");
+                nValueRestored += item.second.vout[n].nValue;
+                vUnspent.push_back(n);
+            }
+        }
+
+        if (!vUnspent.empty())
+            vRestore.emplace_back(item.first, std::move(vUnspent));
+    }
+
+    if (fCheckOnly)
+        return vRestore.size();
+
+    CWalletDB walletdb(strWalletFile);
+    for (const auto& item : vRestore)
+    {
+        if (!RestoreArchivedTx(item.first))
+            continue;
+
+        CWalletTx& wtx = mapWallet[item.first];
+        for (unsigned int n : item.second)
+            wtx.MarkUnspent(n);
+
+        wtx.WriteToDisk(&walletdb);
+        UpdateUnspentIndex(wtx);
+    }
+
+    return vRestore.size();
+}
+
+bool CWallet::ReadArchivedTx(const uint256& hash, CWalletTx& wtx)
+{
+    {
+        LOCK(cs_wallet);
+        if (!mapArchived.count(hash))
+            return false;
+    }
+
+    if (!CWalletDB(strWalletFile, "r").ReadArchivedTx(hash, wtx))
+        return false;
+
+    wtx.BindWallet(this);
+
+    return true;
+}
+
 bool CReserveKey::GetReservedKey(CPubKey& pubkey)
 {
     if (nIndex == -1)
@@ -5,6 +5,9 @@
 #ifndef BITCOIN_WALLET_H
 #define BITCOIN_WALLET_H
 
+#include <array>
+#include <atomic>
+#include <functional>
 #include <string>
 #include <vector>
 #include <set>
@@ -102,6 +105,58 @@ private:
     // the maximum wallet format version: memory-only variable that specifies to what version this wallet may be upgraded
     int nWalletMaxVersion;
 
+    // Wallet transactions that have at least one unspent output owned by the wallet, ordered like mapWallet.
+    // The balance and coin selection methods scan these instead of every transaction in mapWallet.
+    std::map<uint256, const CWalletTx*> mapWalletUnspent;
+
+    // Wallet transactions keyed by nOrderPos. AddToWallet and EraseFromWallet maintain it incrementally
+    // so that listing the newest activity does not need to sort every transaction in mapWallet.
+    std::multimap<int64_t, CWalletTx*> mapWalletOrdered;
+
+    // Archived transactions keyed by nOrderPos, merged into the activity log walk.
+    std::multimap<int64_t, uint256> mapArchivedOrdered;
+
+    // Add or remove a wallet transaction from mapWalletUnspent after its outputs or spent flags change.
+    void UpdateUnspentIndex(const CWalletTx& wtx);
+
+    // Totals returned by the balance methods as of a chain tip. Any change to the wallet transactions
+    // invalidates the totals, and a new tip promotes immature and unconfirmed outputs, so the wallet
+    // recomputes them in one pass over mapWalletUnspent on the next request after either event.
+    struct CBalanceCache
+    {
+        bool fValid = false;
+        const CBlockIndex* pindexTip = nullptr;
+        int64_t nBalance = 0;
+        int64_t nUnconfirmed = 0;
+        int64_t nImmature = 0;
+        int64_t nStake = 0;
+    };
+
+    mutable CBalanceCache balanceCache;
+
+    // Recompute the cached balance totals if the wallet or the chain tip changed. Requires cs_main and cs_wallet.
+    const CBalanceCache& GetBalanceCache() const;
+
+    // Wallet transaction writes deferred while a CWalletDBBatch is open. Repeated writes of
+    // the same transaction collapse into one, and the outermost batch writes them all in a
+    // single database transaction when it closes.
+    int nBatchDepth;
+    mutable std::set<uint256> setBatchedTx;
+    bool fBatchedOrderPos;
+
+    friend class CWalletDBBatch;
+    void CommitWalletBatch();
+
+    // Compact filter over the IDs of the keys and redeem scripts in the key store, one bit
+    // per ID. A standard output whose key or script ID maps to a clear bit cannot be ours,
+    // so IsMine() rejects most outputs with one probe instead of running Solver() and
+    // taking the key store lock. Bits are only ever set, so the rescan worker threads can
+    // read the filter without a lock.
+    std::array<std::atomic<uint64_t>, 1024> scriptFilter;
+
+    void AddToScriptFilter(const uint160& id);
+    bool MayBeMine(const CScript& scriptPubKey) const;
+
 public:
     /// Main wallet lock.
     /// This lock protects all the fields added by CWallet
@@ -185,9 +240,18 @@ public:
         pwalletdbEncryption = NULL;
         nOrderPosNext = 0;
         nTimeFirstKey = 0;
+        nBatchDepth = 0;
+        fBatchedOrderPos = false;
+
+        for (auto& word : scriptFilter)
+            word = 0;
     }
 
     std::map<uint256, CWalletTx> mapWallet;
+
+    // Transactions moved out of mapWallet by ArchiveTransactions(), by hash.
+    std::map<uint256, CArchivedWalletTx> mapArchived;
+
     int64_t nOrderPosNext;
     std::map<uint256, int> mapRequestCount;
 
@@ -212,7 +276,7 @@ public:
     // Adds a key to the store, and saves it to disk.
     bool AddKey(const CKey& key);
     // Adds a key to the store, without saving it to disk (used by LoadWallet)
-    bool LoadKey(const CKey& key) { return CCryptoKeyStore::AddKey(key); }
+    bool LoadKey(const CKey& key);
     // Load metadata (used by LoadWallet)
     bool LoadKeyMetadata(const CPubKey &pubkey, const CKeyMetadata &metadata);
 
@@ -237,6 +301,11 @@ public:
      */
     int64_t IncOrderPosNext(CWalletDB *pwalletdb = NULL);
 
+    /** Defer the write of a wallet transaction to the open CWalletDBBatch
+        @return false if no batch is open or wtx is not the copy held in mapWallet
+     */
+    bool QueueBatchedWrite(const CWalletTx& wtx) const;
+
     typedef std::pair<CWalletTx*, CAccountingEntry*> TxPair;
     typedef std::multimap<int64_t, TxPair > TxItems;
 
@@ -246,7 +315,18 @@ public:
      */
     TxItems OrderedTxItems(std::list<CAccountingEntry>& acentries, std::string strAccount = "");
 
+    /** Walk the wallet's activity log from newest to oldest
+        @param[in] strAccount  account to include accounting entries for, as in OrderedTxItems
+        @param[in] visitor     called for each transaction or accounting entry until it returns false
+        Pointers passed to the visitor are only valid during the call.
+     */
+    void VisitTxItemsNewestFirst(const std::string& strAccount, const std::function<bool(const TxPair&)>& visitor);
+
+    // Rebuild mapWalletOrdered after transactions are loaded or their nOrderPos values are rewritten.
+    void RebuildOrderedIndex();
+
     void MarkDirty();
+    void RebuildUnspentIndex();
     bool AddToWallet(const CWalletTx& wtxIn, CWalletDB *pwalletdb);
     bool AddToWalletIfInvolvingMe(const CTransaction& tx, const CBlock* pblock, bool fUpdate = false, bool fFindBlock = false);
     bool EraseFromWallet(uint256 hash);
@@ -286,6 +366,8 @@ public:
     int64_t GetDebit(const CTxIn& txin, const isminefilter& filter=(ISMINE_SPENDABLE|ISMINE_WATCH_ONLY)) const;
     isminetype IsMine(const CTxOut& txout) const
     {
+        if (!MayBeMine(txout.scriptPubKey))
+            return ISMINE_NO;
         return ::IsMine(*this, txout.scriptPubKey);
     }
     int64_t GetCredit(const CTxOut& txout, const isminefilter& filter=(ISMINE_WATCH_ONLY|ISMINE_SPENDABLE)) const
@@ -392,6 +474,33 @@ public:
     void FixSpentCoins(int& nMismatchSpent, int64_t& nBalanceInQuestion, bool fCheckOnly = false);
     void DisableTransaction(const CTransaction &tx);
 
+    /** Move dead transactions out of memory into the archive in the wallet file
+        @param[in] nMinDepth  confirmations a fully spent transaction and the transactions
+                              that spend it need, or blocks since an orphaned coinbase or
+                              coinstake fell off the chain
+        @return number of transactions archived
+     */
+    int ArchiveTransactions(int nMinDepth);
+
+    /** Move an archived transaction back into mapWallet, for example when a
+        reorganization orphans the coinstake that spent one of its outputs
+        @return false if the transaction is not archived or cannot be restored
+     */
+    bool RestoreArchivedTx(const uint256& hash);
+
+    /** Restore the archived transactions that have an output of ours which the
+        transaction index reports unspent, and mark those outputs unspent
+        @param[in]  fCheckOnly      only count the transactions, do not restore them
+        @param[out] nValueRestored  value of the outputs found unspent
+        @return number of transactions found with unspent outputs
+     */
+    int RestoreUnspentArchivedTx(bool fCheckOnly, int64_t& nValueRestored);
+
+    /** Load an archived transaction from the wallet file
+        @return false if the transaction is not archived or the record cannot be read
+     */
+    bool ReadArchivedTx(const uint256& hash, CWalletTx& wtx);
+
     //!
     //! \brief Get the time that the wallet last created a backup.
     //!
@@ -443,6 +552,35 @@ public:
     void KeepKey();
 };
 
+/** Groups the wallet transaction writes made while in scope into one database
+ * transaction. Connecting a block with stake splitting and side staking, or a
+ * rescan, writes the same transactions many times over. The batch holds
+ * cs_wallet so that no other thread adds writes to it. Batches nest, and only
+ * the outermost one commits. If the process stops before the commit, the wallet
+ * best block is not advanced either, and the startup rescan recovers the writes.
+ */
+class CWalletDBBatch
+{
+private:
+    CWallet* pwallet;
+    CCriticalBlock lock;
+
+    CWalletDBBatch(const CWalletDBBatch&);
+    void operator=(const CWalletDBBatch&);
+public:
+    explicit CWalletDBBatch(CWallet* pwalletIn)
+        : pwallet(pwalletIn), lock(pwalletIn->cs_wallet, "cs_wallet", __FILE__, __LINE__)
+    {
+        pwallet->nBatchDepth++;
+    }
+
+    ~CWalletDBBatch()
+    {
+        if (--pwallet->nBatchDepth == 0)
+            pwallet->CommitWalletBatch();
+    }
+};
+
 
 typedef std::map<std::string, std::string> mapValue_t;
 
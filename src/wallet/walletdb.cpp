@@ -7,6 +7,7 @@
 #include "wallet/walletdb.h"
 #include "wallet/wallet.h"
 #include "init.h"
+#include "util/parallel.h"
 
 #include <variant>
 
@@ -192,6 +193,8 @@ CWalletDB::ReorderTransactions(CWallet* pwallet)
         }
     }
 
+    pwallet->RebuildOrderedIndex();
+
     return DB_LOAD_OK;
 }
 
@@ -213,6 +216,38 @@ public:
     }
 };
 
+// Deserialize and validate a wallet transaction record. This touches nothing but
+// its arguments so that LoadWallet can decode transaction records in parallel.
+static bool
+ReadWalletTx(const uint256& hash, CDataStream& ssValue, CWalletTx& wtx, bool& fUpgraded, string& strErr)
+{
+    ssValue >> wtx;
+    if (!CheckTransaction(wtx) || (wtx.GetHash() != hash))
+        return false;
+
+    // Undo serialize changes in 31600
+    if (31404 <= wtx.fTimeReceivedIsTxTime && wtx.fTimeReceivedIsTxTime <= 31703)
+    {
+        if (!ssValue.empty())
+        {
+            char fTmp;
+            char fUnused;
+            ssValue >> fTmp >> fUnused >> wtx.strFromAccount;
+            strErr = strprintf("LoadWallet() upgrading tx ver=%d %d '%s' %s",
+                               wtx.fTimeReceivedIsTxTime, fTmp, wtx.strFromAccount, hash.ToString());
+            wtx.fTimeReceivedIsTxTime = fTmp;
+        }
+        else
+        {
+            strErr = strprintf("LoadWallet() repairing tx ver=%d %s", wtx.fTimeReceivedIsTxTime, hash.ToString());
+            wtx.fTimeReceivedIsTxTime = 0;
+        }
+        fUpgraded = true;
+    }
+
+    return true;
+}
+
 bool
 ReadKeyValue(CWallet* pwallet, CDataStream& ssKey, CDataStream& ssValue,
              CWalletScanState &wss, string& strType, string& strErr)
@@ -233,8 +268,8 @@ ReadKeyValue(CWallet* pwallet, CDataStream& ssKey, CDataStream& ssValue,
             uint256 hash;
             ssKey >> hash;
             CWalletTx& wtx = pwallet->mapWallet[hash];
-            ssValue >> wtx;
-            if (CheckTransaction(wtx) && (wtx.GetHash() == hash))
+            bool fUpgraded = false;
+            if (ReadWalletTx(hash, ssValue, wtx, fUpgraded, strErr))
                 wtx.BindWallet(pwallet);
             else
             {
@@ -242,29 +277,18 @@ ReadKeyValue(CWallet* pwallet, CDataStream& ssKey, CDataStream& ssValue,
                 return false;
             }
 
-            // Undo serialize changes in 31600
-            if (31404 <= wtx.fTimeReceivedIsTxTime && wtx.fTimeReceivedIsTxTime <= 31703)
-            {
-                if (!ssValue.empty())
-                {
-                    char fTmp;
-                    char fUnused;
-                    ssValue >> fTmp >> fUnused >> wtx.strFromAccount;
-                    strErr = strprintf("LoadWallet() upgrading tx ver=%d %d '%s' %s",
-                                       wtx.fTimeReceivedIsTxTime, fTmp, wtx.strFromAccount, hash.ToString());
-                    wtx.fTimeReceivedIsTxTime = fTmp;
-                }
-                else
-                {
-                    strErr = strprintf("LoadWallet() repairing tx ver=%d %s", wtx.fTimeReceivedIsTxTime, hash.ToString());
-                    wtx.fTimeReceivedIsTxTime = 0;
-                }
+            if (fUpgraded)
                 wss.vWalletUpgrade.push_back(hash);
-            }
 
             if (wtx.nOrderPos == -1)
                 wss.fAnyUnordered = true;
         }
+        else if (strType == "atxmeta")
+        {
+            uint256 hash;
+            ssKey >> hash;
+            ssValue >> pwallet->mapArchived[hash];
+        }
         else if (strType == "acentry")
         {
             string strAccount;
@@ -437,11 +461,36 @@ static bool IsKeyType(string strType)
 
 DBErrors CWalletDB::LoadWallet(CWallet* pwallet)
 {
+    // A wallet transaction record waiting to be decoded.
+    struct CTxRecord
+    {
+        uint256 hash;
+        CDataStream ssValue;
+        CWalletTx wtx;
+        bool fValid = false;
+        bool fUpgraded = false;
+        string strErr;
+
+        CTxRecord(const uint256& hashIn, CDataStream&& ssValueIn)
+            : hash(hashIn), ssValue(std::move(ssValueIn))
+        {
+        }
+    };
+
     pwallet->vchDefaultKey = CPubKey();
     CWalletScanState wss;
     bool fNoncriticalErrors = false;
     DBErrors result = DB_LOAD_OK;
 
+    // Staking wallets consist mostly of transaction records. The load happens in
+    // three stages: a sequential pass over the cursor that handles the other
+    // records and sets transaction records aside, a parallel pass that decodes
+    // and checks the transactions, and a sequential pass that links them into
+    // mapWallet.
+    std::vector<CTxRecord> vTxRecords;
+    int64_t nStageStart = GetTimeMillis();
+    unsigned int nRecords = 0;
+
     try {
         LOCK(pwallet->cs_wallet);
         int nMinVersion = 0;
@@ -474,6 +523,25 @@ DBErrors CWalletDB::LoadWallet(CWallet* pwallet)
                 return DB_CORRUPT;
             }
 
+            nRecords++;
+
+            {
+                CDataStream ssPeek(ssKey);
+                string strType;
+                ssPeek >> strType;
+                if (strType == "tx")
+                {
+                    uint256 hash;
+                    ssPeek >> hash;
+                    vTxRecords.emplace_back(hash, std::move(ssValue));
+                    continue;
+                }
+
+                // Archived transactions are read on demand:
+                if (strType == "atx")
+                    continue;
+            }
+
             // Try to be tolerant of single corrupt records:
             string strType, strErr;
             if (!ReadKeyValue(pwallet, ssKey, ssValue, wss, strType, strErr))
@@ -495,6 +563,54 @@ DBErrors CWalletDB::LoadWallet(CWallet* pwallet)
                 LogPrintf("%s", strErr);
         }
         pcursor->close();
+
+        LogPrintf("LoadWallet: read %u records (%" PRIszu " transactions) in %" PRId64 "ms",
+            nRecords, vTxRecords.size(), GetTimeMillis() - nStageStart);
+        nStageStart = GetTimeMillis();
+
+        ParallelFor(vTxRecords.size(), [&](const size_t i) {
+            CTxRecord& record = vTxRecords[i];
+
+            try {
+                record.fValid = ReadWalletTx(record.hash, record.ssValue, record.wtx, record.fUpgraded, record.strErr);
+            } catch (...) {
+                record.fValid = false;
+            }
+
+            // Release the serialized copy as soon as it is no longer needed:
+            record.ssValue = CDataStream(SER_DISK, CLIENT_VERSION);
+        });
+
+        LogPrintf("LoadWallet: decoded %" PRIszu " transactions in %" PRId64 "ms",
+            vTxRecords.size(), GetTimeMillis() - nStageStart);
+        nStageStart = GetTimeMillis();
+
+        for (auto& record : vTxRecords)
+        {
+            if (!record.strErr.empty())
+                LogPrintf("%s", record.strErr);
+
+            if (!record.fValid)
+            {
+                // Rescan if there is a bad transaction record:
+                fNoncriticalErrors = true;
+                SoftSetBoolArg("-rescan", true);
+                continue;
+            }
+
+            CWalletTx& wtx = pwallet->mapWallet[record.hash];
+            wtx = std::move(record.wtx);
+            wtx.BindWallet(pwallet);
+
+            if (record.fUpgraded)
+                wss.vWalletUpgrade.push_back(record.hash);
+
+            if (wtx.nOrderPos == -1)
+                wss.fAnyUnordered = true;
+        }
+
+        LogPrintf("LoadWallet: linked %" PRIszu " transactions in %" PRId64 "ms",
+            pwallet->mapWallet.size(), GetTimeMillis() - nStageStart);
     }
     catch (...)
     {
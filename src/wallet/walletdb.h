@@ -7,6 +7,7 @@
 
 #include "wallet/db.h"
 #include "base58.h"
+#include "primitives/transaction.h"
 
 class CKeyPool;
 class CAccount;
@@ -56,6 +57,38 @@ public:
     }
 };
 
+/** The part of an archived wallet transaction that stays in memory. The full
+ * transaction is stored under atx<hash> and read on demand. Wallet transactions
+ * that spend the archived outputs still need them to report their debits.
+ * Database key is atxmeta<hash>.
+ */
+class CArchivedWalletTx
+{
+public:
+    int64_t nOrderPos;
+    std::vector<CTxOut> vout;
+
+    CArchivedWalletTx()
+    {
+        nOrderPos = -1;
+    }
+
+    CArchivedWalletTx(int64_t nOrderPosIn, const std::vector<CTxOut>& voutIn)
+    {
+        nOrderPos = nOrderPosIn;
+        vout = voutIn;
+    }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        READWRITE(nOrderPos);
+        READWRITE(vout);
+    }
+};
+
 
 /** Access to the wallet database (wallet.dat) */
 class CWalletDB : public CDB
@@ -87,6 +120,31 @@ public:
         return Erase(std::make_pair(std::string("tx"), hash));
     }
 
+    bool WriteArchivedTx(uint256 hash, const CWalletTx& wtx, const CArchivedWalletTx& archived)
+    {
+        nWalletDBUpdated++;
+
+        if (!Write(std::make_pair(std::string("atx"), hash), wtx))
+            return false;
+
+        return Write(std::make_pair(std::string("atxmeta"), hash), archived);
+    }
+
+    bool ReadArchivedTx(uint256 hash, CWalletTx& wtx)
+    {
+        return Read(std::make_pair(std::string("atx"), hash), wtx);
+    }
+
+    bool EraseArchivedTx(uint256 hash)
+    {
+        nWalletDBUpdated++;
+
+        if (!Erase(std::make_pair(std::string("atx"), hash)))
+            return false;
+
+        return Erase(std::make_pair(std::string("atxmeta"), hash));
+    }
+
     bool WriteKey(const CPubKey& vchPubKey, const CPrivKey& vchPrivKey, const CKeyMetadata &keyMeta)
     {
         nWalletDBUpdated++;